@@ -32,6 +32,11 @@ G_GNUC_END_IGNORE_DEPRECATIONS
 
 #define BUS_NAME PHOSH_APP_ID ".CalendarServer"
 
+/* How long to collect view changes before emitting them */
+#define NOTIFY_DELAY_MS   100
+/* Upper bound of events or ids per emitted signal */
+#define NOTIFY_MAX_EVENTS 250
+
 static const gchar introspection_xml[] =
   "<node>"
   "  <interface name='" PHOSH_APP_ID ".CalendarServer'>"
@@ -100,6 +105,7 @@ typedef struct
   time_t  start_time;
   time_t  end_time;
   char   *color;
+  guint   generation; /* of the views that last reported it */
 } CalendarAppointment;
 
 static gboolean
@@ -265,6 +271,31 @@ calendar_appointment_free (gpointer ptr)
     }
 }
 
+static gboolean
+calendar_appointment_equal (CalendarAppointment *a,
+                            CalendarAppointment *b)
+{
+  return a->start_time == b->start_time &&
+    a->end_time == b->end_time &&
+    g_strcmp0 (a->summary, b->summary) == 0 &&
+    g_strcmp0 (a->color, b->color) == 0;
+}
+
+/* Sorts by start time, the id makes the order stable */
+static gint
+calendar_appointment_compare (gconstpointer a,
+                              gconstpointer b,
+                              gpointer      user_data)
+{
+  const CalendarAppointment *appt_a = a;
+  const CalendarAppointment *appt_b = b;
+
+  if (appt_a->start_time != appt_b->start_time)
+    return appt_a->start_time < appt_b->start_time ? -1 : 1;
+
+  return strcmp (appt_a->id, appt_b->id);
+}
+
 static time_t
 timet_from_ical_time (ICalTime     *time,
                       ICalTimezone *default_zone)
@@ -321,12 +352,30 @@ struct _App
 
   gchar *timezone_location;
 
-  GSList *notify_appointments; /* CalendarAppointment *, for EventsAdded */
-  GSList *notify_ids; /* gchar *, for EventsRemoved */
+  GHashTable *notify_appointments; /* id -> CalendarAppointment *, for EventsAddedOrUpdated */
+  GHashTable *notify_ids; /* gchar *, for EventsRemoved */
+  guint notify_timeout_id;
+
+  /* The events sent since the last time range change, sorted by start
+   * time. Every SetTimeRange gets all of them as the caller might be a
+   * new client, the index then only suppresses repeated view updates. */
+  GSequence *index; /* CalendarAppointment * */
+  GHashTable *index_ids; /* id -> GSequenceIter * */
+  GHashTable *sweep_sources; /* source uids whose views completed their initial load */
+  guint generation;
 
   GSList *live_views;
+  GHashTable *pending_views; /* source uid -> GCancellable *, views being set up */
+  gboolean has_calendars;
 };
 
+typedef struct
+{
+  App          *app;
+  gchar        *source_uid;
+  GCancellable *cancellable;
+} StartViewData;
+
 static void
 app_update_timezone (App *app)
 {
@@ -345,101 +394,353 @@ app_update_timezone (App *app)
     }
 }
 
+static gboolean
+app_in_range (App                 *app,
+              CalendarAppointment *appt)
+{
+  return (appt->start_time >= app->since &&
+          appt->start_time < app->until) ||
+         (appt->start_time <= app->since &&
+         (appt->end_time - 1) > app->since);
+}
+
 static void
-app_notify_events_added (App *app)
+app_index_drop (App           *app,
+                GSequenceIter *iter,
+                GPtrArray     *removed)
 {
-  GVariantBuilder builder;
-  GSList *events, *link;
+  CalendarAppointment *appt = g_sequence_get (iter);
+
+  if (removed)
+    g_ptr_array_add (removed, g_strdup (appt->id));
+
+  g_hash_table_remove (app->index_ids, appt->id);
+  g_sequence_remove (iter);
+}
+
+/* Takes ownership of appt, returns whether clients need to be told about it */
+static gboolean
+app_index_update (App                 *app,
+                  CalendarAppointment *appt)
+{
+  GSequenceIter *iter;
+
+  appt->generation = app->generation;
+
+  iter = g_hash_table_lookup (app->index_ids, appt->id);
+  if (iter)
+    {
+      CalendarAppointment *known = g_sequence_get (iter);
+
+      if (calendar_appointment_equal (known, appt))
+        {
+          known->generation = appt->generation;
+          calendar_appointment_free (appt);
+          return FALSE;
+        }
+
+      app_index_drop (app, iter, NULL);
+    }
+
+  iter = g_sequence_insert_sorted (app->index, appt, calendar_appointment_compare, NULL);
+  g_hash_table_insert (app->index_ids, appt->id, iter);
 
-  events = g_slist_reverse (app->notify_appointments);
-  app->notify_appointments = NULL;
+  return TRUE;
+}
+
+static gboolean
+app_index_remove (App         *app,
+                  const gchar *id)
+{
+  GSequenceIter *iter;
+
+  iter = g_hash_table_lookup (app->index_ids, id);
+  if (!iter)
+    return FALSE;
+
+  app_index_drop (app, iter, NULL);
+
+  return TRUE;
+}
+
+/* Drop the events of the given source last reported before generation */
+static void
+app_index_drop_source (App         *app,
+                       const gchar *source_uid,
+                       guint        generation,
+                       GPtrArray   *removed)
+{
+  /* See create_event_id () */
+  g_autofree gchar *prefix = g_strconcat (source_uid, "\n", NULL);
+  GSequenceIter *iter;
+
+  iter = g_sequence_get_begin_iter (app->index);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      CalendarAppointment *appt = g_sequence_get (iter);
+      GSequenceIter *next = g_sequence_iter_next (iter);
+
+      if (appt->generation < generation && g_str_has_prefix (appt->id, prefix))
+        app_index_drop (app, iter, removed);
 
-  print_debug ("Emitting EventsAddedOrUpdated with %d events", g_slist_length (events));
+      iter = next;
+    }
+}
 
-  if (!events)
+static void
+app_index_clear (App *app)
+{
+  g_hash_table_remove_all (app->index_ids);
+  g_sequence_remove_range (g_sequence_get_begin_iter (app->index),
+                           g_sequence_get_end_iter (app->index));
+}
+
+static void
+app_emit_events_added (App             *app,
+                       GVariantBuilder *builder)
+{
+  g_dbus_connection_emit_signal (app->connection,
+                                 NULL, /* destination_bus_name */
+                                 PHOSH_DBUS_PATH_PREFIX "/CalendarServer",
+                                 PHOSH_APP_ID ".CalendarServer",
+                                 "EventsAddedOrUpdated",
+                                 g_variant_new ("(a(ssxxa{sv}))", builder),
+                                 NULL);
+}
+
+static void
+app_notify_events_added (App       *app,
+                         GPtrArray *appointments)
+{
+  GVariantBuilder builder;
+  guint n_events = 0;
+
+  if (appointments->len == 0)
     return;
 
+  print_debug ("Emitting EventsAddedOrUpdated with %u events", appointments->len);
+
   /* The a{sv} is used as an escape hatch in case we want to provide more
    * information in the future without breaking ABI
    */
   g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(ssxxa{sv})"));
-  for (link = events; link; link = g_slist_next (link))
+  for (guint i = 0; i < appointments->len; i++)
     {
-      CalendarAppointment *appt = link->data;
-      time_t start_time = appt->start_time;
-      time_t end_time   = appt->end_time;
+      CalendarAppointment *appt = g_ptr_array_index (appointments, i);
       GVariantBuilder extras_builder;
 
-      if ((start_time >= app->since &&
-           start_time < app->until) ||
-          (start_time <= app->since &&
-          (end_time - 1) > app->since))
+      g_variant_builder_init (&extras_builder, G_VARIANT_TYPE ("a{sv}"));
+      if (appt->color)
         {
-          g_variant_builder_init (&extras_builder, G_VARIANT_TYPE ("a{sv}"));
-          if (appt->color)
-            {
-              g_variant_builder_add (&extras_builder,
-                                     "{sv}",
-                                     "color",
-                                     g_variant_new_string (appt->color));
-            }
-          g_variant_builder_add (&builder,
-                                 "(ssxxa{sv})",
-                                 appt->id,
-                                 appt->summary != NULL ? appt->summary : "",
-                                 (gint64) start_time,
-                                 (gint64) end_time,
-                                 &extras_builder);
+          g_variant_builder_add (&extras_builder,
+                                 "{sv}",
+                                 "color",
+                                 g_variant_new_string (appt->color));
+        }
+      g_variant_builder_add (&builder,
+                             "(ssxxa{sv})",
+                             appt->id,
+                             appt->summary != NULL ? appt->summary : "",
+                             (gint64) appt->start_time,
+                             (gint64) appt->end_time,
+                             &extras_builder);
+
+      /* Keep the individual messages at a reasonable size */
+      if (++n_events == NOTIFY_MAX_EVENTS)
+        {
+          app_emit_events_added (app, &builder);
+          g_variant_builder_init (&builder, G_VARIANT_TYPE ("a(ssxxa{sv})"));
+          n_events = 0;
         }
     }
 
+  if (n_events)
+    app_emit_events_added (app, &builder);
+  else
+    g_variant_builder_clear (&builder);
+}
+
+static void
+app_emit_events_removed (App             *app,
+                         GVariantBuilder *builder)
+{
   g_dbus_connection_emit_signal (app->connection,
                                  NULL, /* destination_bus_name */
                                  PHOSH_DBUS_PATH_PREFIX "/CalendarServer",
                                  PHOSH_APP_ID ".CalendarServer",
-                                 "EventsAddedOrUpdated",
-                                 g_variant_new ("(a(ssxxa{sv}))", &builder),
+                                 "EventsRemoved",
+                                 g_variant_new ("(as)", builder),
                                  NULL);
+}
+
+static void
+app_notify_events_removed (App       *app,
+                           GPtrArray *ids)
+{
+  GVariantBuilder builder;
+  guint n_ids = 0;
+
+  if (ids->len == 0)
+    return;
 
-  g_variant_builder_clear (&builder);
+  print_debug ("Emitting EventsRemoved with %u ids", ids->len);
 
-  g_slist_free_full (events, calendar_appointment_free);
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+  for (guint i = 0; i < ids->len; i++)
+    {
+      g_variant_builder_add (&builder, "s", g_ptr_array_index (ids, i));
+
+      if (++n_ids == NOTIFY_MAX_EVENTS)
+        {
+          app_emit_events_removed (app, &builder);
+          g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
+          n_ids = 0;
+        }
+    }
+
+  if (n_ids)
+    app_emit_events_removed (app, &builder);
+  else
+    g_variant_builder_clear (&builder);
 }
 
+/* Drop the events that aren't in the time range anymore */
 static void
-app_notify_events_removed (App *app)
+app_index_prune_range (App *app)
 {
-  GVariantBuilder builder;
-  GSList *ids, *link;
+  g_autoptr (GPtrArray) removed = g_ptr_array_new_with_free_func (g_free);
+  CalendarAppointment lookup = { .id = (gchar *) "", .start_time = app->until };
+  GSequenceIter *iter, *next;
 
-  ids = app->notify_ids;
-  app->notify_ids = NULL;
+  /* Everything starting at or after until */
+  iter = g_sequence_search (app->index, &lookup, calendar_appointment_compare, NULL);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      next = g_sequence_iter_next (iter);
+      app_index_drop (app, iter, removed);
+      iter = next;
+    }
 
-  print_debug ("Emitting EventsRemoved with %d ids", g_slist_length (ids));
+  /* Events starting before since unless they're still ongoing */
+  iter = g_sequence_get_begin_iter (app->index);
+  while (!g_sequence_iter_is_end (iter))
+    {
+      CalendarAppointment *appt = g_sequence_get (iter);
 
-  if (!ids)
-    return;
+      if (appt->start_time >= app->since)
+        break;
 
-  g_variant_builder_init (&builder, G_VARIANT_TYPE ("as"));
-  for (link = ids; link; link = g_slist_next (link))
+      next = g_sequence_iter_next (iter);
+      if (!app_in_range (app, appt))
+        app_index_drop (app, iter, removed);
+      iter = next;
+    }
+
+  app_notify_events_removed (app, removed);
+}
+
+/* Send all known events in the time range, the caller might be a new client */
+static void
+app_index_emit_range (App *app)
+{
+  g_autoptr (GPtrArray) events = g_ptr_array_new ();
+  GSequenceIter *iter;
+
+  for (iter = g_sequence_get_begin_iter (app->index);
+       !g_sequence_iter_is_end (iter);
+       iter = g_sequence_iter_next (iter))
     {
-      const gchar *id = link->data;
+      CalendarAppointment *appt = g_sequence_get (iter);
 
-      g_variant_builder_add (&builder, "s", id);
+      if (appt->start_time >= app->until)
+        break;
+
+      if (app_in_range (app, appt))
+        g_ptr_array_add (events, appt);
     }
 
-  g_dbus_connection_emit_signal (app->connection,
-                                 NULL, /* destination_bus_name */
-                                 PHOSH_DBUS_PATH_PREFIX "/CalendarServer",
-                                 PHOSH_APP_ID ".CalendarServer",
-                                 "EventsRemoved",
-                                 g_variant_new ("(as)", &builder),
-                                 NULL);
-  g_variant_builder_clear (&builder);
+  app_notify_events_added (app, events);
+}
+
+static gboolean
+on_notify_timeout (gpointer user_data)
+{
+  App *app = user_data;
+  g_autoptr (GPtrArray) changed = g_ptr_array_new ();
+  g_autoptr (GPtrArray) removed = g_ptr_array_new_with_free_func (g_free);
+  GHashTableIter iter;
+  CalendarAppointment *appt;
+  const gchar *id;
+
+  app->notify_timeout_id = 0;
+
+  /* Only tell clients about events that actually changed */
+  g_hash_table_iter_init (&iter, app->notify_appointments);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &appt))
+    {
+      g_hash_table_iter_steal (&iter);
+
+      if (!app_in_range (app, appt))
+        {
+          if (app_index_remove (app, appt->id))
+            g_ptr_array_add (removed, g_strdup (appt->id));
+          calendar_appointment_free (appt);
+          continue;
+        }
+
+      if (app_index_update (app, appt))
+        g_ptr_array_add (changed, appt);
+    }
+
+  g_hash_table_iter_init (&iter, app->notify_ids);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &id, NULL))
+    {
+      if (app_index_remove (app, id))
+        g_ptr_array_add (removed, g_strdup (id));
+    }
+  g_hash_table_remove_all (app->notify_ids);
+
+  /* Events a view didn't report again on its initial load are gone */
+  g_hash_table_iter_init (&iter, app->sweep_sources);
+  while (g_hash_table_iter_next (&iter, (gpointer *) &id, NULL))
+    app_index_drop_source (app, id, app->generation, removed);
+  g_hash_table_remove_all (app->sweep_sources);
+
+  /* Adds and removals never share an id so the order doesn't matter */
+  app_notify_events_removed (app, removed);
+  app_notify_events_added (app, changed);
 
-  g_slist_free_full (ids, g_free);
+  return G_SOURCE_REMOVE;
+}
+
+/* Views report changes in many small bursts, collect them into fewer signals */
+static void
+app_schedule_notify (App *app)
+{
+  if (app->notify_timeout_id)
+    return;
 
-  return;
+  app->notify_timeout_id = g_timeout_add (NOTIFY_DELAY_MS, on_notify_timeout, app);
+  g_source_set_name_by_id (app->notify_timeout_id, "[CalendarServer] notify");
+}
+
+static void
+app_queue_appointment (App                 *app,
+                       CalendarAppointment *appt)
+{
+  /* Clients track events by id so only the last update matters */
+  g_hash_table_remove (app->notify_ids, appt->id);
+  g_hash_table_replace (app->notify_appointments, appt->id, appt);
+  app_schedule_notify (app);
+}
+
+static void
+app_queue_removed (App   *app,
+                   gchar *id)
+{
+  g_hash_table_remove (app->notify_appointments, id);
+  g_hash_table_add (app->notify_ids, id);
+  app_schedule_notify (app);
 }
 
 static void
@@ -448,7 +749,7 @@ app_process_added_modified_objects (App *app,
                                     GSList *objects) /* ICalComponent * */
 {
   ECalClient *cal_client;
-  GSList *link;
+  GSList *link, *appointments = NULL;
   gboolean expand_recurrences;
 
   cal_client = e_cal_client_view_ref_client (view);
@@ -469,7 +770,7 @@ app_process_added_modified_objects (App *app,
           CollectAppointmentsData data;
 
           data.client = cal_client;
-          data.pappointments = &app->notify_appointments;
+          data.pappointments = &appointments;
 
           e_cal_client_generate_instances_for_object_sync (cal_client, icomp, app->since, app->until, NULL,
                                                            generate_instances_cb, &data);
@@ -480,16 +781,17 @@ app_process_added_modified_objects (App *app,
           if (!comp)
             continue;
 
-          app->notify_appointments = g_slist_prepend (app->notify_appointments,
-                                                      calendar_appointment_new (cal_client, comp));
+          appointments = g_slist_prepend (appointments, calendar_appointment_new (cal_client, comp));
           g_object_unref (comp);
         }
     }
 
   g_clear_object (&cal_client);
 
-  if (app->notify_appointments)
-    app_notify_events_added (app);
+  appointments = g_slist_reverse (appointments);
+  for (link = appointments; link; link = g_slist_next (link))
+    app_queue_appointment (app, link->data);
+  g_slist_free (appointments);
 }
 
 static void
@@ -522,6 +824,25 @@ on_objects_modified (ECalClientView *view,
   app_process_added_modified_objects (app, view, objects);
 }
 
+static void
+on_view_complete (ECalClientView *view,
+                  const GError   *error,
+                  gpointer        user_data)
+{
+  App *app = user_data;
+  ECalClient *client;
+
+  if (error)
+    return;
+
+  client = e_cal_client_view_ref_client (view);
+  g_hash_table_add (app->sweep_sources,
+                    g_strdup (e_source_get_uid (e_client_get_source (E_CLIENT (client)))));
+  g_clear_object (&client);
+
+  app_schedule_notify (app);
+}
+
 static void
 on_objects_removed (ECalClientView *view,
                     GSList         *uids,
@@ -544,25 +865,117 @@ on_objects_removed (ECalClientView *view,
       if (!id)
         continue;
 
-      app->notify_ids = g_slist_prepend (app->notify_ids,
-                                         create_event_id (source_uid,
-                                         e_cal_component_id_get_uid (id),
-                                         e_cal_component_id_get_rid (id)));
+      app_queue_removed (app,
+                         create_event_id (source_uid,
+                                          e_cal_component_id_get_uid (id),
+                                          e_cal_component_id_get_rid (id)));
     }
 
   g_clear_object (&client);
-
-  if (app->notify_ids)
-    app_notify_events_removed (app);
 }
 
 static gboolean
 app_has_calendars (App *app)
 {
-  return app->live_views != NULL;
+  return app->has_calendars;
+}
+
+static void
+start_view_data_free (StartViewData *data)
+{
+  g_free (data->source_uid);
+  g_object_unref (data->cancellable);
+  g_free (data);
+}
+
+static void
+app_cancel_pending_view (App         *app,
+                         const gchar *source_uid)
+{
+  GCancellable *cancellable;
+
+  cancellable = g_hash_table_lookup (app->pending_views, source_uid);
+  if (!cancellable)
+    return;
+
+  g_cancellable_cancel (cancellable);
+  g_hash_table_remove (app->pending_views, source_uid);
 }
 
-static ECalClientView *
+static void
+app_cancel_pending_views (App *app)
+{
+  GHashTableIter iter;
+  GCancellable *cancellable;
+
+  g_hash_table_iter_init (&iter, app->pending_views);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &cancellable))
+    g_cancellable_cancel (cancellable);
+
+  g_hash_table_remove_all (app->pending_views);
+}
+
+static void app_update_has_calendars (App *app);
+
+static void
+on_get_view_ready (GObject      *source_object,
+                   GAsyncResult *res,
+                   gpointer      user_data)
+{
+  StartViewData *data = user_data;
+  ECalClient *cal_client = E_CAL_CLIENT (source_object);
+  ECalClientView *view = NULL;
+  g_autoptr (GError) error = NULL;
+  gboolean success;
+  App *app;
+
+  success = e_cal_client_get_view_finish (cal_client, res, &view, &error);
+
+  /* The time range changed, the client disappeared or we're shutting down */
+  if (g_cancellable_is_cancelled (data->cancellable))
+    {
+      g_clear_object (&view);
+      start_view_data_free (data);
+      return;
+    }
+
+  app = data->app;
+  g_hash_table_remove (app->pending_views, data->source_uid);
+
+  if (!success)
+    {
+      g_warning ("Error setting up live-query on calendar '%s': %s\n", data->source_uid,
+                 error ? error->message : "Unknown error");
+    }
+  else
+    {
+      g_signal_connect (view,
+                        "objects-added",
+                        G_CALLBACK (on_objects_added),
+                        app);
+      g_signal_connect (view,
+                        "objects-modified",
+                        G_CALLBACK (on_objects_modified),
+                        app);
+      g_signal_connect (view,
+                        "objects-removed",
+                        G_CALLBACK (on_objects_removed),
+                        app);
+      g_signal_connect (view,
+                        "complete",
+                        G_CALLBACK (on_view_complete),
+                        app);
+      e_cal_client_view_start (view, NULL);
+      app->live_views = g_slist_prepend (app->live_views, view);
+    }
+
+  start_view_data_free (data);
+
+  app_update_has_calendars (app);
+}
+
+/* Sets up the view asynchronously so slow backends don't block other requests */
+static void
 app_start_view (App *app,
                 ECalClient *cal_client)
 {
@@ -570,16 +983,16 @@ app_start_view (App *app,
   g_autofree char *until_iso8601 = NULL;
   g_autofree char *query = NULL;
   const gchar *tz_location;
-  ECalClientView *view = NULL;
-  g_autoptr (GError) error = NULL;
+  const gchar *source_uid;
+  StartViewData *data;
 
   if (app->since <= 0 || app->since >= app->until)
-    return NULL;
+    return;
 
   if (!app->since || !app->until)
     {
       print_debug ("Skipping load of events, no time interval set yet");
-      return NULL;
+      return;
     }
 
   /* timezone could have changed */
@@ -588,11 +1001,12 @@ app_start_view (App *app,
   since_iso8601 = isodate_from_time_t (app->since);
   until_iso8601 = isodate_from_time_t (app->until);
   tz_location = i_cal_timezone_get_location (app->zone);
+  source_uid = e_source_get_uid (e_client_get_source (E_CLIENT (cal_client)));
 
   print_debug ("Loading events since %s until %s for calendar '%s'",
                since_iso8601,
                until_iso8601,
-               e_source_get_uid (e_client_get_source (E_CLIENT (cal_client))));
+               source_uid);
 
   query = g_strdup_printf ("occur-in-time-range? (make-time \"%s\") "
                            "(make-time \"%s\") \"%s\"",
@@ -603,28 +1017,17 @@ app_start_view (App *app,
   if (app->zone)
     e_cal_client_set_default_timezone (cal_client, app->zone);
 
-  if (!e_cal_client_get_view_sync (cal_client, query, &view, NULL /* cancellable */, &error))
-    {
-      g_warning ("Error setting up live-query '%s' on calendar: %s\n", query, error ? error->message : "Unknown error");
-      view = NULL;
-    }
-  else
-    {
-      g_signal_connect (view,
-                        "objects-added",
-                        G_CALLBACK (on_objects_added),
-                        app);
-      g_signal_connect (view,
-                        "objects-modified",
-                        G_CALLBACK (on_objects_modified),
-                        app);
-      g_signal_connect (view,
-                        "objects-removed",
-                        G_CALLBACK (on_objects_removed),
-                        app);
-      e_cal_client_view_start (view, NULL);
-    }
-  return view;
+  app_cancel_pending_view (app, source_uid);
+
+  data = g_new0 (StartViewData, 1);
+  data->app = app;
+  data->source_uid = g_strdup (source_uid);
+  data->cancellable = g_cancellable_new ();
+  g_hash_table_insert (app->pending_views,
+                       g_strdup (source_uid),
+                       g_object_ref (data->cancellable));
+
+  e_cal_client_get_view (cal_client, query, data->cancellable, on_get_view_ready, data);
 }
 
 static void
@@ -636,6 +1039,7 @@ app_stop_view (App *app,
       g_signal_handlers_disconnect_by_func (view, on_objects_added, app);
       g_signal_handlers_disconnect_by_func (view, on_objects_modified, app);
       g_signal_handlers_disconnect_by_func (view, on_objects_removed, app);
+      g_signal_handlers_disconnect_by_func (view, on_view_complete, app);
 }
 
 static void
@@ -660,13 +1064,34 @@ app_notify_has_calendars (App *app)
   g_variant_builder_clear (&dict_builder);
 }
 
+static void
+app_update_has_calendars (App *app)
+{
+  gboolean has_calendars = app->live_views != NULL;
+
+  /* Don't flip to FALSE while views are being set up */
+  if (!has_calendars && g_hash_table_size (app->pending_views))
+    return;
+
+  if (has_calendars == app->has_calendars)
+    return;
+
+  app->has_calendars = has_calendars;
+  app_notify_has_calendars (app);
+}
+
 static void
 app_update_views (App *app)
 {
   GSList *link, *clients;
-  gboolean had_views, has_views;
 
-  had_views = app->live_views != NULL;
+  app_cancel_pending_views (app);
+
+  /* The new views report all current events, everything not reported
+   * again on their initial load is gone. */
+  app->generation++;
+  g_hash_table_remove_all (app->notify_appointments);
+  g_hash_table_remove_all (app->sweep_sources);
 
   for (link = app->live_views; link; link = g_slist_next (link))
     {
@@ -681,20 +1106,14 @@ app_update_views (App *app)
   for (link = clients; link; link = g_slist_next (link))
     {
       ECalClient *cal_client = link->data;
-      ECalClientView *view;
 
       if (!cal_client)
         continue;
 
-      view = app_start_view (app, cal_client);
-      if (view)
-        app->live_views = g_slist_prepend (app->live_views, view);
+      app_start_view (app, cal_client);
     }
 
-  has_views = app->live_views != NULL;
-
-  if (has_views != had_views)
-    app_notify_has_calendars (app);
+  app_update_has_calendars (app);
 
   g_slist_free_full (clients, g_object_unref);
 }
@@ -705,7 +1124,6 @@ on_client_appeared_cb (CalendarSources *sources,
                        gpointer user_data)
 {
   App *app = user_data;
-  ECalClientView *view;
   GSList *link;
   const gchar *source_uid;
 
@@ -713,6 +1131,9 @@ on_client_appeared_cb (CalendarSources *sources,
 
   print_debug ("Client appeared '%s'", source_uid);
 
+  if (g_hash_table_contains (app->pending_views, source_uid))
+    return;
+
   for (link = app->live_views; link; link = g_slist_next (link))
     {
       ECalClientView *v = link->data;
@@ -731,16 +1152,7 @@ on_client_appeared_cb (CalendarSources *sources,
       g_clear_object (&cal_client);
     }
 
-  view = app_start_view (app, client);
-
-  if (view)
-    {
-      app->live_views = g_slist_prepend (app->live_views, view);
-
-      /* It's the first view, notify that it has calendars now */
-      if (!g_slist_next (app->live_views))
-        app_notify_has_calendars (app);
-    }
+  app_start_view (app, client);
 }
 
 static void
@@ -753,6 +1165,10 @@ on_client_disappeared_cb (CalendarSources *sources,
 
   print_debug ("Client disappeared '%s'", source_uid);
 
+  app_cancel_pending_view (app, source_uid);
+  /* Clients drop all events on ClientDisappeared and reload */
+  app_index_drop_source (app, source_uid, G_MAXUINT, NULL);
+
   for (link = app->live_views; link; link = g_slist_next (link))
     {
       ECalClientView *view = link->data;
@@ -778,16 +1194,13 @@ on_client_disappeared_cb (CalendarSources *sources,
                                          "ClientDisappeared",
                                          g_variant_new ("(s)", source_uid),
                                          NULL);
-
-          /* It was the last view, notify that it doesn't have calendars now */
-          if (!app->live_views)
-            app_notify_has_calendars (app);
-
           break;
         }
 
       g_clear_object (&cal_client);
     }
+
+  app_update_has_calendars (app);
 }
 
 static App *
@@ -798,6 +1211,13 @@ app_new (GDBusConnection *connection)
   app = g_new0 (App, 1);
   app->connection = g_object_ref (connection);
   app->sources = calendar_sources_get ();
+  app->notify_appointments = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                    NULL, calendar_appointment_free);
+  app->notify_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  app->pending_views = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_object_unref);
+  app->index = g_sequence_new (calendar_appointment_free);
+  app->index_ids = g_hash_table_new (g_str_hash, g_str_equal);
+  app->sweep_sources = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   app->client_appeared_signal_id = g_signal_connect (app->sources,
                                                      "client-appeared",
                                                      G_CALLBACK (on_client_appeared_cb),
@@ -817,6 +1237,10 @@ app_free (App *app)
 {
   GSList *ll;
 
+  app_cancel_pending_views (app);
+  g_hash_table_destroy (app->pending_views);
+  g_clear_handle_id (&app->notify_timeout_id, g_source_remove);
+
   for (ll = app->live_views; ll != NULL; ll = g_slist_next (ll))
     {
       ECalClientView *view = E_CAL_CLIENT_VIEW (ll->data);
@@ -832,8 +1256,11 @@ app_free (App *app)
   g_free (app->timezone_location);
 
   g_slist_free_full (app->live_views, g_object_unref);
-  g_slist_free_full (app->notify_appointments, calendar_appointment_free);
-  g_slist_free_full (app->notify_ids, g_free);
+  g_hash_table_destroy (app->notify_appointments);
+  g_hash_table_destroy (app->notify_ids);
+  g_hash_table_destroy (app->index_ids);
+  g_sequence_free (app->index);
+  g_hash_table_destroy (app->sweep_sources);
 
   g_object_unref (app->connection);
   g_object_unref (app->sources);
@@ -913,6 +1340,15 @@ handle_method_call (GDBusConnection       *connection,
 
       g_dbus_method_invocation_return_value (invocation, NULL);
 
+      if (window_changed)
+        app_index_prune_range (app);
+
+      /* Clients might have dropped their events so send all of them again */
+      if (force_reload)
+        app_index_clear (app);
+      else
+        app_index_emit_range (app);
+
       if (window_changed || force_reload)
         app_update_views (app);
     }
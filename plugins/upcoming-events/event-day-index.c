@@ -0,0 +1,236 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "phosh-config.h"
+
+#include "calendar-event.h"
+#include "event-day-index.h"
+
+/**
+ * PhoshEventDayIndex:
+ *
+ * Sorts the events of a `GListModel` of `PhoshCalendarEvent`s into
+ * per day lists starting at `today`. The events need to be sorted by
+ * their begin.
+ *
+ * Each event's days are computed once per update so the per day
+ * lists don't need to filter the whole model themselves. Days whose
+ * events didn't change aren't touched.
+ */
+struct _PhoshEventDayIndex {
+  GObject     parent;
+
+  GListModel *events;
+  GPtrArray  *days;   /* GListStore of PhoshCalendarEvent per day */
+  GDateTime  *today;
+  gboolean    today_changed;
+};
+G_DEFINE_TYPE (PhoshEventDayIndex, phosh_event_day_index, G_TYPE_OBJECT)
+
+
+static int
+get_day_number (GDateTime *date_time)
+{
+  GDate date;
+  int year, month, day;
+
+  g_date_time_get_ymd (date_time, &year, &month, &day);
+  g_date_clear (&date, 1);
+  g_date_set_dmy (&date, day, month, year);
+
+  return g_date_get_julian (&date);
+}
+
+/*
+ * The days relative to `today` the event is shown on: The day it
+ * begins and all days it's ongoing. Events ending at midnight don't
+ * leak into the next day.
+ */
+static void
+get_day_range (PhoshCalendarEvent *event, int today, int *first, int *last)
+{
+  GDateTime *end = phosh_calendar_event_get_end (event);
+
+  *first = get_day_number (phosh_calendar_event_get_begin (event)) - today;
+  *last = get_day_number (end) - today;
+
+  if (g_date_time_get_hour (end) == 0 && g_date_time_get_minute (end) == 0)
+    *last -= 1;
+
+  *last = MAX (*first, *last);
+}
+
+
+static void
+update_day (GListStore *store, GPtrArray *events, gboolean force)
+{
+  GListModel *model = G_LIST_MODEL (store);
+  guint n_items = g_list_model_get_n_items (model);
+
+  if (!force && n_items == events->len) {
+    gboolean same = TRUE;
+
+    for (guint i = 0; i < n_items && same; i++) {
+      g_autoptr (GObject) item = g_list_model_get_item (model, i);
+
+      same = item == g_ptr_array_index (events, i);
+    }
+
+    if (same)
+      return;
+  }
+
+  g_list_store_splice (store, 0, n_items, events->pdata, events->len);
+}
+
+
+static void
+phosh_event_day_index_finalize (GObject *object)
+{
+  PhoshEventDayIndex *self = PHOSH_EVENT_DAY_INDEX (object);
+
+  g_clear_object (&self->events);
+  g_clear_pointer (&self->days, g_ptr_array_unref);
+  g_clear_pointer (&self->today, g_date_time_unref);
+
+  G_OBJECT_CLASS (phosh_event_day_index_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_event_day_index_class_init (PhoshEventDayIndexClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phosh_event_day_index_finalize;
+}
+
+
+static void
+phosh_event_day_index_init (PhoshEventDayIndex *self)
+{
+  self->days = g_ptr_array_new_with_free_func (g_object_unref);
+  self->today = g_date_time_new_now_local ();
+}
+
+
+PhoshEventDayIndex *
+phosh_event_day_index_new (GListModel *events)
+{
+  PhoshEventDayIndex *self;
+
+  g_return_val_if_fail (G_IS_LIST_MODEL (events), NULL);
+
+  self = g_object_new (PHOSH_TYPE_EVENT_DAY_INDEX, NULL);
+  self->events = g_object_ref (events);
+
+  return self;
+}
+
+/**
+ * phosh_event_day_index_set_today:
+ * @self: The day index
+ * @today: The day to start at
+ *
+ * Sets the first day and updates the index.
+ */
+void
+phosh_event_day_index_set_today (PhoshEventDayIndex *self, GDateTime *today)
+{
+  g_return_if_fail (PHOSH_IS_EVENT_DAY_INDEX (self));
+  g_return_if_fail (today);
+
+  g_clear_pointer (&self->today, g_date_time_unref);
+  self->today = g_date_time_ref (today);
+  /* The per day rows depend on the day so recreate them */
+  self->today_changed = TRUE;
+
+  phosh_event_day_index_update (self);
+}
+
+/**
+ * phosh_event_day_index_set_n_days:
+ * @self: The day index
+ * @n_days: The number of days
+ *
+ * Sets the number of days to index and updates the index.
+ */
+void
+phosh_event_day_index_set_n_days (PhoshEventDayIndex *self, guint n_days)
+{
+  g_return_if_fail (PHOSH_IS_EVENT_DAY_INDEX (self));
+
+  if (n_days < self->days->len)
+    g_ptr_array_remove_range (self->days, n_days, self->days->len - n_days);
+
+  while (self->days->len < n_days)
+    g_ptr_array_add (self->days, g_list_store_new (PHOSH_TYPE_CALENDAR_EVENT));
+
+  phosh_event_day_index_update (self);
+}
+
+/**
+ * phosh_event_day_index_get_day:
+ * @self: The day index
+ * @day_offset: The offset in days from today
+ *
+ * Gets the events on the given day.
+ *
+ * Returns:(transfer none): The events on that day
+ */
+GListModel *
+phosh_event_day_index_get_day (PhoshEventDayIndex *self, guint day_offset)
+{
+  g_return_val_if_fail (PHOSH_IS_EVENT_DAY_INDEX (self), NULL);
+  g_return_val_if_fail (day_offset < self->days->len, NULL);
+
+  return G_LIST_MODEL (g_ptr_array_index (self->days, day_offset));
+}
+
+/**
+ * phosh_event_day_index_update:
+ * @self: The day index
+ *
+ * Sorts the events into their days again. Needs to be invoked when
+ * events got added, removed or changed.
+ */
+void
+phosh_event_day_index_update (PhoshEventDayIndex *self)
+{
+  g_autoptr (GPtrArray) buckets = NULL;
+  int today, n_days;
+  guint n_items;
+
+  g_return_if_fail (PHOSH_IS_EVENT_DAY_INDEX (self));
+
+  n_days = self->days->len;
+  buckets = g_ptr_array_new_full (n_days, (GDestroyNotify) g_ptr_array_unref);
+  for (int day = 0; day < n_days; day++)
+    g_ptr_array_add (buckets, g_ptr_array_new ());
+
+  today = get_day_number (self->today);
+  n_items = g_list_model_get_n_items (self->events);
+  for (guint i = 0; i < n_items; i++) {
+    g_autoptr (PhoshCalendarEvent) event = g_list_model_get_item (self->events, i);
+    int first, last;
+
+    get_day_range (event, today, &first, &last);
+
+    /* Sorted by begin so all further events are past the last day too */
+    if (first >= n_days)
+      break;
+
+    /* The model holds a reference so borrowing is fine */
+    for (int day = MAX (first, 0); day <= MIN (last, n_days - 1); day++)
+      g_ptr_array_add (g_ptr_array_index (buckets, day), event);
+  }
+
+  for (int day = 0; day < n_days; day++)
+    update_day (g_ptr_array_index (self->days, day), g_ptr_array_index (buckets, day),
+                self->today_changed);
+
+  self->today_changed = FALSE;
+}
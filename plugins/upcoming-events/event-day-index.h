@@ -0,0 +1,26 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_EVENT_DAY_INDEX (phosh_event_day_index_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshEventDayIndex, phosh_event_day_index, PHOSH, EVENT_DAY_INDEX, GObject)
+
+PhoshEventDayIndex *phosh_event_day_index_new        (GListModel         *events);
+void                phosh_event_day_index_set_today  (PhoshEventDayIndex *self,
+                                                      GDateTime          *today);
+void                phosh_event_day_index_set_n_days (PhoshEventDayIndex *self,
+                                                      guint               n_days);
+GListModel         *phosh_event_day_index_get_day    (PhoshEventDayIndex *self,
+                                                      guint               day_offset);
+void                phosh_event_day_index_update     (PhoshEventDayIndex *self);
+
+G_END_DECLS
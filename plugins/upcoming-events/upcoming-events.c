@@ -8,6 +8,7 @@
 
 #include "phosh-config.h"
 
+#include "event-day-index.h"
 #include "event-list.h"
 #include "calendar-event.h"
 #include "upcoming-events.h"
@@ -40,6 +41,7 @@ struct _PhoshUpcomingEvents {
   GtkBox                        *events_box;
   GPtrArray                     *event_lists;
   GListStore                    *events;
+  PhoshEventDayIndex            *day_index;
   GHashTable                    *event_ids;
   GDateTime                     *since;
   guint                          num_days;
@@ -63,6 +65,7 @@ phosh_upcoming_events_finalize (GObject *object)
   g_clear_handle_id (&self->today_changed_timeout_id, g_source_remove);
   g_cancellable_cancel (self->cancel);
   g_clear_object (&self->cancel);
+  g_clear_object (&self->day_index);
   g_clear_object (&self->events);
   g_clear_object (&self->settings);
   g_clear_object (&self->tz_monitor);
@@ -178,11 +181,121 @@ update_event_lists_visibility (PhoshUpcomingEvents *self)
 }
 
 
+static int
+calendar_event_ptr_begin_compare (gconstpointer a, gconstpointer b)
+{
+  return calendar_event_begin_compare (*(gpointer *)a, *(gpointer *)b, NULL);
+}
+
+/* Binary search for the first event that doesn't begin before `begin` */
+static guint
+find_begin_position (GListModel *model, GDateTime *begin)
+{
+  guint low = 0, high = g_list_model_get_n_items (model);
+
+  while (low < high) {
+    guint mid = low + (high - low) / 2;
+    g_autoptr (PhoshCalendarEvent) event = g_list_model_get_item (model, mid);
+
+    if (g_date_time_compare (phosh_calendar_event_get_begin (event), begin) < 0)
+      low = mid + 1;
+    else
+      high = mid;
+  }
+
+  return low;
+}
+
+
+static gboolean
+find_event (PhoshUpcomingEvents *self, PhoshCalendarEvent *event, guint *position)
+{
+  GListModel *model = G_LIST_MODEL (self->events);
+  GDateTime *begin = phosh_calendar_event_get_begin (event);
+  guint n_items = g_list_model_get_n_items (model);
+
+  for (guint pos = find_begin_position (model, begin); pos < n_items; pos++) {
+    g_autoptr (PhoshCalendarEvent) item = g_list_model_get_item (model, pos);
+
+    if (item == event) {
+      *position = pos;
+      return TRUE;
+    }
+
+    if (!g_date_time_equal (phosh_calendar_event_get_begin (item), begin))
+      break;
+  }
+
+  return FALSE;
+}
+
+
+/* Insert the sorted events, events that end up next to each other are added in one go */
+static void
+insert_events (PhoshUpcomingEvents *self, GPtrArray *events)
+{
+  GListModel *model = G_LIST_MODEL (self->events);
+  guint end = events->len;
+
+  /* Go backwards so insertions don't shift the positions still to be looked at */
+  while (end > 0) {
+    PhoshCalendarEvent *last = g_ptr_array_index (events, end - 1);
+    g_autoptr (PhoshCalendarEvent) before = NULL;
+    guint pos, start = end - 1;
+
+    pos = find_begin_position (model, phosh_calendar_event_get_begin (last));
+    if (pos > 0)
+      before = g_list_model_get_item (model, pos - 1);
+
+    while (start > 0) {
+      PhoshCalendarEvent *prev = g_ptr_array_index (events, start - 1);
+
+      if (before && calendar_event_begin_compare (before, prev, NULL) >= 0)
+        break;
+      start--;
+    }
+
+    g_list_store_splice (self->events, pos, 0, &events->pdata[start], end - start);
+    end = start;
+  }
+}
+
+
+static int
+compare_position_desc (gconstpointer a, gconstpointer b)
+{
+  guint pos_a = *(guint *)a;
+  guint pos_b = *(guint *)b;
+
+  return (pos_a < pos_b) - (pos_a > pos_b);
+}
+
+
+/* Remove the given positions, adjacent ones are removed in one go */
+static void
+remove_positions (PhoshUpcomingEvents *self, GArray *positions)
+{
+  g_array_sort (positions, compare_position_desc);
+
+  for (guint i = 0; i < positions->len;) {
+    guint pos = g_array_index (positions, guint, i);
+    guint n = 1;
+
+    while (i + n < positions->len && g_array_index (positions, guint, i + n) == pos - n)
+      n++;
+
+    g_list_store_splice (self->events, pos - n + 1, n, NULL, 0);
+    i += n;
+  }
+}
+
+
 #define EVENT_FORMAT "(&s&sxx@a{sv})"
 
 static void
 on_events_added_or_updated (PhoshUpcomingEvents *self, GVariant *events)
 {
+  g_autoptr (GPtrArray) added = g_ptr_array_new_with_free_func (g_object_unref);
   GVariantIter iter;
   gint64 begin, end;
   const char *id, *summary;
@@ -193,6 +306,8 @@ on_events_added_or_updated (PhoshUpcomingEvents *self, GVariant *events)
   while (g_variant_iter_next (&iter, EVENT_FORMAT, &id, &summary, &begin, &end, &extra_dict)) {
     PhoshCalendarEvent *event;
     g_auto (GVariantDict) dict = G_VARIANT_DICT_INIT (extra_dict);
+    g_autoptr (GDateTime) begin_dt = g_date_time_new_from_unix_local (begin);
+    g_autoptr (GDateTime) end_dt = g_date_time_new_from_unix_local (end);
     const char *color;
 
     if (g_variant_dict_lookup (&dict, "color", "&s", &color) == FALSE)
@@ -200,36 +315,38 @@ on_events_added_or_updated (PhoshUpcomingEvents *self, GVariant *events)
 
     event = g_hash_table_lookup (self->event_ids, id);
     if (event) {
+      guint pos;
+
+      /* Keep the list sorted, events added in this batch get sorted below */
+      if (!g_date_time_equal (phosh_calendar_event_get_begin (event), begin_dt) &&
+          find_event (self, event, &pos)) {
+        g_ptr_array_add (added, g_object_ref (event));
+        g_list_store_remove (self->events, pos);
+      }
+
       g_object_set (event,
                     "summary", summary,
-                    "begin", g_date_time_new_from_unix_local (begin),
-                    "end", g_date_time_new_from_unix_local (end),
+                    "begin", begin_dt,
+                    "end", end_dt,
                     "color", color,
                     NULL);
       changed = TRUE;
       continue;
     }
 
-    event = phosh_calendar_event_new (id,
-                                      summary,
-                                      g_date_time_new_from_unix_local (begin),
-                                      g_date_time_new_from_unix_local (end),
-                                      color);
+    event = phosh_calendar_event_new (id, summary, begin_dt, end_dt, color);
     g_hash_table_insert (self->event_ids, g_strdup (id), g_object_ref (event));
-    g_list_store_insert_sorted (self->events,
-                                g_steal_pointer (&event),
-                                calendar_event_begin_compare,
-                                NULL);
+    g_ptr_array_add (added, event);
   }
 
-  update_event_lists_visibility (self);
+  g_ptr_array_sort (added, calendar_event_ptr_begin_compare);
+  insert_events (self, added);
 
-  if (changed == FALSE)
-    return;
+  /* Changed events might be tz change so always update days */
+  if (added->len || changed)
+    phosh_event_day_index_update (self->day_index);
 
-  /* Changed events might be tz change so refilter days */
-  for (int i = 0; i < self->event_lists->len; i++)
-    phosh_event_list_set_today (g_ptr_array_index (self->event_lists, i), self->since);
+  update_event_lists_visibility (self);
 }
 
 #undef EVENT_FORMAT
@@ -237,9 +354,9 @@ on_events_added_or_updated (PhoshUpcomingEvents *self, GVariant *events)
 static void
 on_events_removed (PhoshUpcomingEvents *self, GStrv ids)
 {
-  int removed = 0;
+  g_autoptr (GArray) positions = g_array_new (FALSE, FALSE, sizeof (guint));
 
-  for (int i = 0; i < g_strv_length (ids); i++) {
+  for (int i = 0; ids[i]; i++) {
     const char *id = ids[i];
     PhoshCalendarEvent *event;
     guint pos;
@@ -248,17 +365,21 @@ on_events_removed (PhoshUpcomingEvents *self, GStrv ids)
     if (!event)
       continue;
 
-    if (g_list_store_find (self->events, event, &pos)) {
-      g_list_store_remove (self->events, pos);
-      removed++;
-    } else {
+    if (find_event (self, event, &pos))
+      g_array_append_val (positions, pos);
+    else
       g_warning ("Found %s in hash but not in list", id);
-    }
 
     g_hash_table_remove (self->event_ids, id);
   }
 
-  g_debug ("Removed %d events of %d", removed, g_strv_length (ids));
+  remove_positions (self, positions);
+  if (positions->len) {
+    phosh_event_day_index_update (self->day_index);
+    update_event_lists_visibility (self);
+  }
+
+  g_debug ("Removed %u events of %u", positions->len, g_strv_length (ids));
 }
 
 
@@ -275,6 +396,8 @@ update_calendar (PhoshUpcomingEvents *self, gboolean force_reload)
 
   for (int i = 0; i < self->event_lists->len; i++)
     phosh_event_list_set_today (g_ptr_array_index (self->event_lists, i), self->since);
+  phosh_event_day_index_set_today (self->day_index, self->since);
+  update_event_lists_visibility (self);
 
   /* Rearm timer */
   setup_date_change_timeout (self);
@@ -381,11 +504,13 @@ on_num_days_changed (PhoshUpcomingEvents *self)
   }
   g_ptr_array_remove_range (self->event_lists, 0, self->event_lists->len);
 
+  phosh_event_day_index_set_n_days (self->day_index, self->num_days);
+
   for (int i = 0; i < self->num_days; i++) {
     GtkWidget *event_list = g_object_new (PHOSH_TYPE_EVENT_LIST,
                                           "day-offset", i,
                                           "today", self->since,
-                                          "model", self->events,
+                                          "model", phosh_event_day_index_get_day (self->day_index, i),
                                           "visible", TRUE,
                                           NULL);
     gtk_container_add (GTK_CONTAINER (self->events_box), event_list);
@@ -451,6 +576,7 @@ phosh_upcoming_events_init (PhoshUpcomingEvents *self)
 
   self->event_lists = g_ptr_array_new ();
   self->events = g_list_store_new (PHOSH_TYPE_CALENDAR_EVENT);
+  self->day_index = phosh_event_day_index_new (G_LIST_MODEL (self->events));
 
   self->event_ids = g_hash_table_new_full (g_str_hash,
                                            g_str_equal,
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "icon-cache.h"
+
+#define DEFAULT_MAX_BYTES (4 * 1024 * 1024)
+
+/**
+ * PhoshSearchIconCache:
+ *
+ * A cache of decoded result icons, bounded by their size in bytes.
+ *
+ * Providers tend to send the same icons for every refinement of a
+ * query. The cache is keyed by a hash of the icon's serialized form
+ * so repeated metas reuse the already decoded icon.
+ */
+
+typedef struct {
+  char  *key;
+  GIcon *icon;
+  gsize  size;
+} CachedIcon;
+
+struct _PhoshSearchIconCache {
+  /* key: char * (content hash), value: GList link of lru */
+  GHashTable *icons;
+  /* element-type: CachedIcon, most recently used first */
+  GQueue      lru;
+  gsize       bytes;
+  gsize       max_bytes;
+};
+
+
+static void
+cached_icon_free (CachedIcon *cached)
+{
+  g_free (cached->key);
+  g_object_unref (cached->icon);
+  g_free (cached);
+}
+
+
+static void
+remove_link (PhoshSearchIconCache *self, GList *link)
+{
+  CachedIcon *cached = link->data;
+
+  g_hash_table_remove (self->icons, cached->key);
+  g_queue_delete_link (&self->lru, link);
+  self->bytes -= cached->size;
+  cached_icon_free (cached);
+}
+
+
+PhoshSearchIconCache *
+phosh_search_icon_cache_new (gsize max_bytes)
+{
+  PhoshSearchIconCache *self = g_new0 (PhoshSearchIconCache, 1);
+
+  self->icons = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&self->lru);
+  self->max_bytes = max_bytes;
+
+  return self;
+}
+
+
+void
+phosh_search_icon_cache_free (PhoshSearchIconCache *self)
+{
+  g_hash_table_destroy (self->icons);
+  g_queue_clear_full (&self->lru, (GDestroyNotify) cached_icon_free);
+  g_free (self);
+}
+
+/**
+ * phosh_search_icon_cache_get_default:
+ *
+ * Get the icon cache shared by all providers.
+ *
+ * Returns: (transfer none): The icon cache
+ */
+PhoshSearchIconCache *
+phosh_search_icon_cache_get_default (void)
+{
+  static PhoshSearchIconCache *instance;
+
+  if (instance == NULL)
+    instance = phosh_search_icon_cache_new (DEFAULT_MAX_BYTES);
+
+  return instance;
+}
+
+/**
+ * phosh_search_icon_cache_lookup:
+ * @self: The icon cache
+ * @key: The icon's content hash
+ *
+ * Looks up an icon and marks it as recently used.
+ *
+ * Returns: (transfer full)(nullable): The icon
+ */
+GIcon *
+phosh_search_icon_cache_lookup (PhoshSearchIconCache *self, const char *key)
+{
+  GList *link;
+
+  g_return_val_if_fail (self, NULL);
+  g_return_val_if_fail (key, NULL);
+
+  link = g_hash_table_lookup (self->icons, key);
+  if (link == NULL)
+    return NULL;
+
+  g_queue_unlink (&self->lru, link);
+  g_queue_push_head_link (&self->lru, link);
+
+  return g_object_ref (((CachedIcon *) link->data)->icon);
+}
+
+/**
+ * phosh_search_icon_cache_insert:
+ * @self: The icon cache
+ * @key: The icon's content hash
+ * @icon: The decoded icon
+ * @size: The memory used by the icon in bytes
+ *
+ * Adds an icon to the cache evicting the least recently used
+ * icons if the cache gets too large. Icons larger than the whole
+ * cache aren't added.
+ */
+void
+phosh_search_icon_cache_insert (PhoshSearchIconCache *self,
+                                const char           *key,
+                                GIcon                *icon,
+                                gsize                 size)
+{
+  CachedIcon *cached;
+  GList *link;
+
+  g_return_if_fail (self);
+  g_return_if_fail (key);
+  g_return_if_fail (G_IS_ICON (icon));
+
+  link = g_hash_table_lookup (self->icons, key);
+  if (link)
+    remove_link (self, link);
+
+  if (size > self->max_bytes)
+    return;
+
+  cached = g_new0 (CachedIcon, 1);
+  cached->key = g_strdup (key);
+  cached->icon = g_object_ref (icon);
+  cached->size = size;
+
+  g_queue_push_head (&self->lru, cached);
+  g_hash_table_insert (self->icons, cached->key, self->lru.head);
+  self->bytes += size;
+
+  while (self->bytes > self->max_bytes)
+    remove_link (self, self->lru.tail);
+}
@@ -0,0 +1,27 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include <gio/gio.h>
+
+#pragma once
+
+G_BEGIN_DECLS
+
+typedef struct _PhoshSearchIconCache PhoshSearchIconCache;
+
+PhoshSearchIconCache *phosh_search_icon_cache_new         (gsize                 max_bytes);
+void                  phosh_search_icon_cache_free        (PhoshSearchIconCache *self);
+PhoshSearchIconCache *phosh_search_icon_cache_get_default (void);
+GIcon                *phosh_search_icon_cache_lookup      (PhoshSearchIconCache *self,
+                                                           const char           *key);
+void                  phosh_search_icon_cache_insert      (PhoshSearchIconCache *self,
+                                                           const char           *key,
+                                                           GIcon                *icon,
+                                                           gsize                 size);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhoshSearchIconCache, phosh_search_icon_cache_free)
+
+G_END_DECLS
@@ -15,6 +15,7 @@
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
+#include "icon-cache.h"
 #include "search-provider.h"
 #include "search-result-meta.h"
 #include "gnome-shell-search-provider.h"
@@ -30,6 +31,16 @@
  */
 
 
+/* Upper bounds of the latency histogram buckets in ms, the last bucket is open */
+static const guint latency_bucket_limits[] = { 25, 50, 100, 200, 400, 800, 1600 };
+#define N_LATENCY_BUCKETS (G_N_ELEMENTS (latency_bucket_limits) + 1)
+
+/* Rough memory used by icons that aren't pixbufs */
+#define ICON_OVERHEAD 256
+
+/* Weight of a new sample in the average latency */
+#define LATENCY_SMOOTHING 0.25
+
 typedef struct _PhoshSearchProviderPrivate PhoshSearchProviderPrivate;
 struct _PhoshSearchProviderPrivate {
   GAppInfo                 *info;
@@ -42,6 +53,10 @@ struct _PhoshSearchProviderPrivate {
   char                     *bus_path;
   gboolean                  autostart;
   gboolean                  default_disabled;
+
+  guint                     latency_buckets[N_LATENCY_BUCKETS];
+  guint                     n_timeouts;
+  double                    latency_avg;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshSearchProvider, phosh_search_provider, G_TYPE_OBJECT)
@@ -421,43 +436,91 @@ phosh_search_provider_launch_search (PhoshSearchProvider *self,
 }
 
 
+static GIcon *
+decode_icon_data (GVariant *icon_data, gsize *size)
+{
+  g_autoptr (GVariant) pixels = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  int width, height, row_stride, bits_per_sample, channels;
+  gboolean has_alpha;
+  gsize min_size;
+
+  g_variant_get (icon_data, "(iiibii@ay)",
+                 &width, &height, &row_stride, &has_alpha,
+                 &bits_per_sample, &channels, &pixels);
+
+  if (width <= 0 || height <= 0 || bits_per_sample != 8 || channels != (has_alpha ? 4 : 3))
+    return NULL;
+
+  min_size = (gsize) row_stride * (height - 1) + (gsize) width * channels;
+  if (row_stride < width * channels || g_variant_get_size (pixels) < min_size)
+    return NULL;
+
+  /* Copy the pixels so a cached icon doesn't keep the whole D-Bus message around */
+  bytes = g_bytes_new (g_variant_get_data (pixels), g_variant_get_size (pixels));
+  *size = g_bytes_get_size (bytes);
+
+  return G_ICON (gdk_pixbuf_new_from_bytes (bytes,
+                                            GDK_COLORSPACE_RGB,
+                                            has_alpha,
+                                            bits_per_sample,
+                                            width,
+                                            height,
+                                            row_stride));
+}
+
+
 static GIcon *
 get_result_icon (PhoshSearchProvider *self, GVariantDict *result_meta)
 {
   PhoshSearchProviderPrivate *priv = phosh_search_provider_get_instance_private (self);
+  PhoshSearchIconCache *cache = phosh_search_icon_cache_get_default ();
+  static const char * const icon_keys[] = { "icon", "gicon", "icon-data" };
   g_autoptr (GError) error = NULL;
-  g_autoptr (GVariant) variant = NULL;
-  g_autofree char *icon_data = NULL;
+  g_autoptr (GVariant) value = NULL;
+  g_autofree char *hash = NULL;
+  g_autofree char *cache_key = NULL;
+  const char *icon_key = NULL;
   GIcon *icon = NULL;
-  int width = 0;
-  int height = 0;
-  int row_stride = 0;
-  int has_alpha = 0;
-  int sample_size = 0;
-  int channels = 0;
-
-  if (g_variant_dict_lookup (result_meta, "icon", "v", &variant)) {
-    icon = g_icon_deserialize (variant);
-  } else if (g_variant_dict_lookup (result_meta, "gicon", "s", &icon_data)) {
-    icon = g_icon_new_for_string (icon_data, &error);
+  gsize size = ICON_OVERHEAD;
+
+  for (int i = 0; i < G_N_ELEMENTS (icon_keys); i++) {
+    value = g_variant_dict_lookup_value (result_meta, icon_keys[i], NULL);
+    if (value) {
+      icon_key = icon_keys[i];
+      break;
+    }
+  }
+
+  if (value == NULL)
+    return NULL;
+
+  hash = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                      g_variant_get_data (value),
+                                      g_variant_get_size (value));
+  cache_key = g_strdup_printf ("%s:%s:%s", icon_key, g_variant_get_type_string (value), hash);
+
+  icon = phosh_search_icon_cache_lookup (cache, cache_key);
+  if (icon)
+    return icon;
+
+  if (g_str_equal (icon_key, "icon")) {
+    icon = g_icon_deserialize (value);
+  } else if (g_str_equal (icon_key, "gicon") &&
+             g_variant_is_of_type (value, G_VARIANT_TYPE_STRING)) {
+    icon = g_icon_new_for_string (g_variant_get_string (value, NULL), &error);
 
     if (error) {
       g_warning ("[%s]: bad icon: %s", priv->bus_path, error->message);
     }
-  } else if (g_variant_dict_lookup (result_meta, "icon-data", "iiibiiay",
-                                    &width, &height, &row_stride, &has_alpha,
-                                    &sample_size, &channels, &icon_data)) {
-    icon = G_ICON (gdk_pixbuf_new_from_data ((guchar *) icon_data,
-                                             GDK_COLORSPACE_RGB,
-                                             has_alpha,
-                                             sample_size,
-                                             width,
-                                             height,
-                                             row_stride,
-                                             (GdkPixbufDestroyNotify) g_free,
-                                             NULL));
+  } else if (g_str_equal (icon_key, "icon-data") &&
+             g_variant_is_of_type (value, G_VARIANT_TYPE ("(iiibiiay)"))) {
+    icon = decode_icon_data (value, &size);
   }
 
+  if (icon)
+    phosh_search_icon_cache_insert (cache, cache_key, icon, size);
+
   return icon;
 }
 
@@ -682,3 +745,109 @@ phosh_search_provider_get_bus_path (PhoshSearchProvider  *self)
 
   return priv->bus_path;
 }
+
+
+/**
+ * phosh_search_provider_record_latency:
+ * @self: The search provider
+ * @latency: The time it took the provider to answer a query in µs
+ *
+ * Records how long the provider took to answer.
+ */
+void
+phosh_search_provider_record_latency (PhoshSearchProvider *self, gint64 latency)
+{
+  PhoshSearchProviderPrivate *priv;
+  double ms = latency / 1000.0;
+  guint i;
+
+  g_return_if_fail (PHOSH_IS_SEARCH_PROVIDER (self));
+
+  priv = phosh_search_provider_get_instance_private (self);
+
+  for (i = 0; i < G_N_ELEMENTS (latency_bucket_limits); i++) {
+    if (ms < latency_bucket_limits[i])
+      break;
+  }
+  priv->latency_buckets[i]++;
+
+  if (priv->latency_avg == 0.0)
+    priv->latency_avg = ms;
+  else
+    priv->latency_avg += LATENCY_SMOOTHING * (ms - priv->latency_avg);
+}
+
+/**
+ * phosh_search_provider_record_timeout:
+ * @self: The search provider
+ *
+ * Records that the provider didn't answer within the deadline.
+ */
+void
+phosh_search_provider_record_timeout (PhoshSearchProvider *self)
+{
+  PhoshSearchProviderPrivate *priv;
+
+  g_return_if_fail (PHOSH_IS_SEARCH_PROVIDER (self));
+
+  priv = phosh_search_provider_get_instance_private (self);
+
+  priv->n_timeouts++;
+}
+
+/**
+ * phosh_search_provider_get_expected_latency:
+ * @self: The search provider
+ *
+ * Gets the smoothed average of the provider's recent latencies.
+ *
+ * Returns: The expected latency in ms or `0` if unknown
+ */
+guint
+phosh_search_provider_get_expected_latency (PhoshSearchProvider *self)
+{
+  PhoshSearchProviderPrivate *priv;
+
+  g_return_val_if_fail (PHOSH_IS_SEARCH_PROVIDER (self), 0);
+
+  priv = phosh_search_provider_get_instance_private (self);
+
+  return (guint) priv->latency_avg;
+}
+
+/**
+ * phosh_search_provider_get_stats:
+ * @self: The search provider
+ *
+ * Gets the latency statistics of the provider. The histogram's
+ * `bucket-limits` are the buckets' upper bounds in ms, the
+ * last bucket in `latencies` has no upper bound.
+ *
+ * Returns: (transfer floating): The statistics as `a{sv}`
+ */
+GVariant *
+phosh_search_provider_get_stats (PhoshSearchProvider *self)
+{
+  PhoshSearchProviderPrivate *priv;
+  GVariantDict dict;
+
+  g_return_val_if_fail (PHOSH_IS_SEARCH_PROVIDER (self), NULL);
+
+  priv = phosh_search_provider_get_instance_private (self);
+
+  g_variant_dict_init (&dict, NULL);
+  g_variant_dict_insert_value (&dict, "bucket-limits",
+                               g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                          latency_bucket_limits,
+                                                          G_N_ELEMENTS (latency_bucket_limits),
+                                                          sizeof (guint)));
+  g_variant_dict_insert_value (&dict, "latencies",
+                               g_variant_new_fixed_array (G_VARIANT_TYPE_UINT32,
+                                                          priv->latency_buckets,
+                                                          N_LATENCY_BUCKETS,
+                                                          sizeof (guint)));
+  g_variant_dict_insert (&dict, "expected-latency", "u", (guint) priv->latency_avg);
+  g_variant_dict_insert (&dict, "timeouts", "u", priv->n_timeouts);
+
+  return g_variant_dict_end (&dict);
+}
@@ -60,5 +60,10 @@ GStrv                phosh_search_provider_get_subsearch_finish   (PhoshSearchPr
                                                                    GError              **error);
 gboolean             phosh_search_provider_get_ready              (PhoshSearchProvider  *self);
 const char          *phosh_search_provider_get_bus_path           (PhoshSearchProvider *self);
+void                 phosh_search_provider_record_latency         (PhoshSearchProvider *self,
+                                                                   gint64               latency);
+void                 phosh_search_provider_record_timeout         (PhoshSearchProvider *self);
+guint                phosh_search_provider_get_expected_latency   (PhoshSearchProvider *self);
+GVariant            *phosh_search_provider_get_stats              (PhoshSearchProvider *self);
 
 G_END_DECLS
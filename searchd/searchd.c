@@ -29,6 +29,20 @@
 
 #define LIMIT_RESULTS 5
 
+/* How long we wait for a provider before considering the query finished */
+#define PROVIDER_TIMEOUT_MS 1500
+
+/* Bounds of the debounce for fast providers, also used when we don't
+ * know how fast providers are yet */
+#define SEARCH_DEBOUNCE_MIN_MS 50
+#define SEARCH_DEBOUNCE_MS 150
+/* Providers slower than this are only queried once typing pauses */
+#define SLOW_PROVIDER_MS 250
+#define SLOW_SEARCH_DEBOUNCE_MAX_MS 1000
+
+#define RESULT_CACHE_MAX_ENTRIES 64
+#define RESULT_CACHE_TTL_US (30 * G_USEC_PER_SEC)
+
 /**
  * PhoshSearchApplication:
  *
@@ -51,15 +65,29 @@ struct _PhoshSearchApplicationPrivate {
 
   /* key: char * (object path), value: GVariant * (results) */
   GHashTable   *last_results;
+  /* The results of the previously searched query */
+  GHashTable   *prev_results;
   gboolean      doing_subsearch;
 
   char         *query;
   GStrv         query_parts;
+  /* The query last sent to providers */
+  char         *searched_query;
 
   GCancellable *cancellable;
 
   gulong        search_timeout;
+  guint         slow_search_timeout;
+  /* Bus paths of the providers only queried once typing pauses, fixed per query */
+  GHashTable   *slow_providers;
   int           outstanding_searches;
+  guint         generation;
+  guint         searched_generation;
+
+  /* key: char * (object path and query), value: GList link of lru */
+  GHashTable   *result_cache;
+  /* element-type: CachedResults, most recently used first */
+  GQueue        result_cache_lru;
 
   GRegex       *splitter;
 };
@@ -67,6 +95,101 @@ struct _PhoshSearchApplicationPrivate {
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshSearchApplication, phosh_search_application, G_TYPE_APPLICATION)
 
 
+typedef struct {
+  char     *key;
+  GVariant *results;
+  gint64    timestamp;
+} CachedResults;
+
+
+static void
+cached_results_free (CachedResults *cached)
+{
+  g_free (cached->key);
+  g_variant_unref (cached->results);
+  g_free (cached);
+}
+
+
+static char *
+result_cache_key (const char *bus_path, GStrv query_parts)
+{
+  g_autofree char *terms = g_strjoinv ("\x1f", query_parts);
+
+  return g_strconcat (bus_path, "\x1e", terms, NULL);
+}
+
+
+static void
+result_cache_clear (PhoshSearchApplication *self)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+
+  g_hash_table_remove_all (priv->result_cache);
+  g_queue_clear_full (&priv->result_cache_lru, (GDestroyNotify) cached_results_free);
+}
+
+
+static void
+result_cache_remove_link (PhoshSearchApplication *self, GList *link)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+  CachedResults *cached = link->data;
+
+  g_hash_table_remove (priv->result_cache, cached->key);
+  g_queue_delete_link (&priv->result_cache_lru, link);
+  cached_results_free (cached);
+}
+
+
+static GVariant *
+result_cache_lookup (PhoshSearchApplication *self, const char *key)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+  CachedResults *cached;
+  GList *link;
+
+  link = g_hash_table_lookup (priv->result_cache, key);
+  if (link == NULL)
+    return NULL;
+
+  cached = link->data;
+  if (g_get_monotonic_time () - cached->timestamp > RESULT_CACHE_TTL_US) {
+    result_cache_remove_link (self, link);
+    return NULL;
+  }
+
+  g_queue_unlink (&priv->result_cache_lru, link);
+  g_queue_push_head_link (&priv->result_cache_lru, link);
+
+  return cached->results;
+}
+
+
+static void
+result_cache_insert (PhoshSearchApplication *self, const char *key, GVariant *results)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+  CachedResults *cached;
+  GList *link;
+
+  link = g_hash_table_lookup (priv->result_cache, key);
+  if (link)
+    result_cache_remove_link (self, link);
+
+  cached = g_new0 (CachedResults, 1);
+  cached->key = g_strdup (key);
+  cached->results = g_variant_ref (results);
+  cached->timestamp = g_get_monotonic_time ();
+
+  g_queue_push_head (&priv->result_cache_lru, cached);
+  g_hash_table_insert (priv->result_cache, cached->key, priv->result_cache_lru.head);
+
+  while (priv->result_cache_lru.length > RESULT_CACHE_MAX_ENTRIES)
+    result_cache_remove_link (self, priv->result_cache_lru.tail);
+}
+
+
 static void
 phosh_search_application_finalize (GObject *object)
 {
@@ -79,10 +202,18 @@ phosh_search_application_finalize (GObject *object)
 
   g_clear_object (&priv->cancellable);
   g_clear_object (&priv->settings);
+  g_clear_handle_id (&priv->search_timeout, g_source_remove);
+  g_clear_handle_id (&priv->slow_search_timeout, g_source_remove);
+
   g_clear_pointer (&priv->last_results, g_hash_table_destroy);
+  g_clear_pointer (&priv->prev_results, g_hash_table_destroy);
+  g_clear_pointer (&priv->slow_providers, g_hash_table_destroy);
+  result_cache_clear (self);
+  g_clear_pointer (&priv->result_cache, g_hash_table_destroy);
 
   g_clear_pointer (&priv->query, g_free);
   g_clear_pointer (&priv->query_parts, g_strfreev);
+  g_clear_pointer (&priv->searched_query, g_free);
 
   g_list_free_full (priv->sources, (GDestroyNotify) phosh_search_source_unref);
   g_clear_pointer (&priv->providers, g_hash_table_destroy);
@@ -309,28 +440,136 @@ get_last_results (PhoshDBusSearch *interface, GDBusMethodInvocation *invocation,
 }
 
 
-static void
-got_metas (GObject *source, GAsyncResult *res, gpointer user_data)
+static gboolean
+get_provider_stats (PhoshDBusSearch       *interface,
+                    GDBusMethodInvocation *invocation,
+                    gpointer               user_data)
 {
   PhoshSearchApplication *self = PHOSH_SEARCH_APPLICATION (user_data);
   PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+  GVariantBuilder builder;
+  GHashTableIter iter;
+  gpointer key, value;
+
+  g_variant_builder_init (&builder, G_VARIANT_TYPE ("a{sa{sv}}"));
+
+  g_hash_table_iter_init (&iter, priv->providers);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    g_variant_builder_add (&builder, "{s@a{sv}}",
+                           (const char *) key,
+                           phosh_search_provider_get_stats (PHOSH_SEARCH_PROVIDER (value)));
+  }
+
+  phosh_dbus_search_complete_get_provider_stats (interface,
+                                                 invocation,
+                                                 g_variant_builder_end (&builder));
+
+  return TRUE;
+}
+
+
+/* A single provider's part of a query */
+typedef struct {
+  PhoshSearchApplication *self;
+  PhoshSearchProvider    *provider;
+  char                   *bus_path;
+  char                   *cache_key;
+  guint                   generation;
+  guint                   timeout_id;
+  gint64                  start;
+  gboolean                initial;
+  gboolean                done;
+} ProviderSearch;
+
+
+static void
+provider_search_free (ProviderSearch *search)
+{
+  g_clear_handle_id (&search->timeout_id, g_source_remove);
+  g_object_unref (search->self);
+  g_object_unref (search->provider);
+  g_free (search->bus_path);
+  g_free (search->cache_key);
+  g_free (search);
+}
+
+
+static void
+maybe_query_finished (PhoshSearchApplication *self)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+
+  if (priv->outstanding_searches || priv->search_timeout || priv->slow_search_timeout)
+    return;
+
+  g_debug ("Query finished: All outstanding searches completed.");
+  phosh_dbus_search_emit_query_finished (priv->object);
+}
+
+
+/* The provider either delivered or missed its deadline */
+static void
+provider_search_done (ProviderSearch *search)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (search->self);
+
+  g_clear_handle_id (&search->timeout_id, g_source_remove);
+
+  if (search->done || search->generation != priv->generation)
+    return;
+
+  search->done = TRUE;
+  priv->outstanding_searches--;
+
+  maybe_query_finished (search->self);
+}
+
+
+static gboolean
+on_provider_timeout (gpointer user_data)
+{
+  ProviderSearch *search = user_data;
+
+  search->timeout_id = 0;
+  g_debug ("[%s]: Didn't answer in time", search->bus_path);
+  phosh_search_provider_record_timeout (search->provider);
+  provider_search_done (search);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+emit_results (PhoshSearchApplication *self, const char *bus_path, GVariant *results)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+
+  phosh_dbus_search_emit_source_results_changed (priv->object, bus_path, results);
+  g_hash_table_insert (priv->last_results, g_strdup (bus_path), g_variant_ref (results));
+}
+
+
+static void
+got_metas (GObject *source, GAsyncResult *res, gpointer user_data)
+{
+  ProviderSearch *search = user_data;
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (search->self);
   g_autoptr (GError) error = NULL;
   g_autoptr (GVariant) result = NULL;
+  g_autoptr (GPtrArray) metas = NULL;
   GVariantBuilder builder;
-  GPtrArray *metas;
-  char *bus_path;
 
   metas = phosh_search_provider_get_result_meta_finish (PHOSH_SEARCH_PROVIDER (source),
                                                         res,
                                                         &error);
-
-  g_object_get (source, "bus-path", &bus_path, NULL);
-
   if (error) {
-    g_critical ("Failed to load results %s", error->message);
-    return;
+    if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("[%s]: Failed to load results %s", search->bus_path, error->message);
+    goto out;
   }
 
+  phosh_search_provider_record_latency (search->provider, g_get_monotonic_time () - search->start);
+
   g_variant_builder_init (&builder, G_VARIANT_TYPE ("aa{sv}"));
 
   for (int i = 0; i < metas->len; i++) {
@@ -338,36 +577,31 @@ got_metas (GObject *source, GAsyncResult *res, gpointer user_data)
                                  phosh_search_result_meta_serialise (g_ptr_array_index (metas, i)));
   }
 
-  result = g_variant_builder_end (&builder);
-
-  phosh_dbus_search_emit_source_results_changed (priv->object, bus_path, g_variant_ref (result));
+  result = g_variant_ref_sink (g_variant_builder_end (&builder));
 
-  g_hash_table_insert (priv->last_results, bus_path, g_variant_ref (result));
-}
+  /* Results for an older query are still good for the cache */
+  result_cache_insert (search->self, search->cache_key, result);
 
+  /* Results that miss the deadline are still shown */
+  if (search->generation == priv->generation)
+    emit_results (search->self, search->bus_path, result);
 
-struct GotResultsData {
-  gboolean initial;
-  PhoshSearchApplication *self;
-};
+ out:
+  provider_search_done (search);
+  provider_search_free (search);
+}
 
 
 static void
 got_results (GObject *source, GAsyncResult *res, gpointer user_data)
 {
-  PhoshSearchApplicationPrivate *priv;
-  struct GotResultsData *data = user_data;
+  ProviderSearch *search = user_data;
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (search->self);
   g_autoptr (GError) error = NULL;
-  GStrv results = NULL;
+  g_auto (GStrv) results = NULL;
   g_autoptr (GPtrArray) sub_res = NULL;
-  g_autofree char *bus_path = NULL;
-  GStrv sub_res_strv = NULL;
-
-  priv = phosh_search_application_get_instance_private (data->self);
 
-  g_object_get (source, "bus-path", &bus_path, NULL);
-
-  if (data->initial) {
+  if (search->initial) {
     results = phosh_search_provider_get_initial_finish (PHOSH_SEARCH_PROVIDER (source),
                                                         res,
                                                         &error);
@@ -377,34 +611,22 @@ got_results (GObject *source, GAsyncResult *res, gpointer user_data)
                                                           &error);
   }
 
-  if (error) {
-    g_warning ("[%s]: %s", bus_path, error->message);
-  } else if (results) {
-    sub_res = phosh_search_provider_limit_results (results, LIMIT_RESULTS);
-
-    sub_res_strv = g_new (char *, sub_res->len + 1);
+  if (error || results == NULL || search->generation != priv->generation) {
+    if (error && !g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("[%s]: %s", search->bus_path, error->message);
 
-    for (int i = 0; i < sub_res->len; i++)
-      sub_res_strv[i] = g_ptr_array_index (sub_res, i);
-
-    sub_res_strv[sub_res->len] = NULL;
-
-    phosh_search_provider_get_result_meta (PHOSH_SEARCH_PROVIDER (source),
-                                           sub_res_strv,
-                                           got_metas,
-                                           data->self);
+    provider_search_done (search);
+    provider_search_free (search);
+    return;
   }
 
-  priv->outstanding_searches--;
-
-  /* If all searches are done, emit the signal */
-  if (priv->outstanding_searches == 0) {
-    g_debug ("Query finished: All outstanding searches completed.\n");
-    phosh_dbus_search_emit_query_finished (priv->object);
-  }
+  sub_res = phosh_search_provider_limit_results (results, LIMIT_RESULTS);
+  g_ptr_array_add (sub_res, NULL);
 
-  g_object_unref (data->self);
-  g_free (data);
+  phosh_search_provider_get_result_meta (PHOSH_SEARCH_PROVIDER (source),
+                                         (GStrv) sub_res->pdata,
+                                         got_metas,
+                                         search);
 }
 
 
@@ -434,57 +656,96 @@ extract_result_ids (GVariant *results_variant)
 }
 
 
+static gboolean
+is_slow_provider (PhoshSearchProvider *provider)
+{
+  return phosh_search_provider_get_expected_latency (provider) > SLOW_PROVIDER_MS;
+}
+
+
 static void
-search (PhoshSearchApplication *self)
+search (PhoshSearchApplication *self, gboolean slow)
 {
   PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
   GHashTableIter iter;
   gpointer key, value;
 
+  /* First search for this query, the current results become the previous ones */
+  if (priv->searched_generation != priv->generation) {
+    priv->searched_generation = priv->generation;
+
+    priv->doing_subsearch = priv->searched_query && g_str_has_prefix (priv->query,
+                                                                      priv->searched_query);
+    g_free (priv->searched_query);
+    priv->searched_query = g_strdup (priv->query);
+
+    g_clear_pointer (&priv->prev_results, g_hash_table_destroy);
+    priv->prev_results = g_steal_pointer (&priv->last_results);
+    priv->last_results = g_hash_table_new_full (g_str_hash,
+                                                g_str_equal,
+                                                g_free,
+                                                (GDestroyNotify) g_variant_unref);
+  }
+
   g_hash_table_iter_init (&iter, priv->providers);
   while (g_hash_table_iter_next (&iter, &key, &value)) {
     PhoshSearchProvider *provider = PHOSH_SEARCH_PROVIDER (value);
-    char *bus_path;
-    struct GotResultsData *data;
-
-    g_object_get (provider, "bus-path", &bus_path, NULL);
+    const char *bus_path = phosh_search_provider_get_bus_path (provider);
+    g_autofree char *cache_key = NULL;
+    ProviderSearch *search;
+    GVariant *cached;
 
     if (!phosh_search_provider_get_ready (provider)) {
       g_warning ("[%s]: not ready", bus_path);
       continue;
     }
 
-    data = g_new (struct GotResultsData, 1);
-    data->self = g_object_ref (self);
+    if (g_hash_table_contains (priv->slow_providers, bus_path) != slow)
+      continue;
+
+    cache_key = result_cache_key (bus_path, priv->query_parts);
+    cached = result_cache_lookup (self, cache_key);
+    if (cached) {
+      g_debug ("[%s]: Using cached results", bus_path);
+      emit_results (self, bus_path, cached);
+      continue;
+    }
+
+    search = g_new0 (ProviderSearch, 1);
+    search->self = g_object_ref (self);
+    search->provider = g_object_ref (provider);
+    search->bus_path = g_strdup (bus_path);
+    search->cache_key = g_steal_pointer (&cache_key);
+    search->generation = priv->generation;
+    search->start = g_get_monotonic_time ();
+    search->timeout_id = g_timeout_add (PROVIDER_TIMEOUT_MS, on_provider_timeout, search);
+    g_source_set_name_by_id (search->timeout_id, "[phosh-searchd] provider timeout");
 
     /* Increment counter for each provider that will be queried */
     priv->outstanding_searches++;
 
-    if (priv->doing_subsearch && g_hash_table_contains (priv->last_results, bus_path)) {
-      GVariant *prev = g_hash_table_lookup (priv->last_results, bus_path);
-      g_auto (GStrv) prev_results = extract_result_ids (prev);
+    if (priv->doing_subsearch && g_hash_table_contains (priv->prev_results, bus_path)) {
+      GVariant *prev = g_hash_table_lookup (priv->prev_results, bus_path);
+      g_auto (GStrv) prev_ids = extract_result_ids (prev);
 
-      data->initial = FALSE;
+      search->initial = FALSE;
       phosh_search_provider_get_subsearch (provider,
-                                           (const char * const *) prev_results,
+                                           (const char * const *) prev_ids,
                                            (const char * const *) priv->query_parts,
                                            got_results,
-                                           data);
+                                           search);
     } else {
-      data->initial = TRUE;
+      search->initial = TRUE;
       phosh_search_provider_get_initial (provider,
                                          (const char * const*) priv->query_parts,
                                          got_results,
-                                         data);
+                                         search);
     }
   }
 
-  g_hash_table_remove_all (priv->last_results);
-
-  if (priv->search_timeout != 0) {
-    g_source_remove (priv->search_timeout);
-    priv->search_timeout = 0;
-  }
+  /* Edge case: if no providers are ready/active or all results were
+   * cached, emit immediately */
+  maybe_query_finished (self);
 }
 
 
@@ -495,17 +756,69 @@ search_timeout (gpointer user_data)
   PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
 
   priv->search_timeout = 0;
+  search (self, FALSE);
+
+  return G_SOURCE_REMOVE;
+}
+
 
-  search (self);
+static gboolean
+slow_search_timeout (gpointer user_data)
+{
+  PhoshSearchApplication *self = PHOSH_SEARCH_APPLICATION (user_data);
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
 
-  /* Edge case: if no providers are ready/active, emit immediately */
-  if (priv->outstanding_searches == 0)
-    phosh_dbus_search_emit_query_finished (priv->object);
+  priv->slow_search_timeout = 0;
+  search (self, TRUE);
 
   return G_SOURCE_REMOVE;
 }
 
 
+/*
+ * Fast providers are queried at most every @fast_delay ms so results
+ * show up while typing. Slow providers are only queried once typing
+ * paused for @slow_delay ms. The set of slow providers is kept until
+ * the next query so each provider is queried exactly once per query
+ * even when its latency changes in between. Returns %FALSE if there
+ * are no slow providers.
+ */
+static gboolean
+get_debounce (PhoshSearchApplication *self, guint *fast_delay, guint *slow_delay)
+{
+  PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
+  GHashTableIter iter;
+  gpointer value;
+  guint fast = 0, slow = 0;
+
+  g_hash_table_remove_all (priv->slow_providers);
+
+  g_hash_table_iter_init (&iter, priv->providers);
+  while (g_hash_table_iter_next (&iter, NULL, &value)) {
+    PhoshSearchProvider *provider = PHOSH_SEARCH_PROVIDER (value);
+    guint latency = phosh_search_provider_get_expected_latency (provider);
+
+    if (!phosh_search_provider_get_ready (provider))
+      continue;
+
+    if (latency == 0) { /* Not known yet */
+      fast = SEARCH_DEBOUNCE_MS;
+    } else if (is_slow_provider (provider)) {
+      g_hash_table_add (priv->slow_providers,
+                        g_strdup (phosh_search_provider_get_bus_path (provider)));
+      slow = MAX (slow, latency);
+    } else {
+      fast = MAX (fast, latency);
+    }
+  }
+
+  *fast_delay = CLAMP (fast, SEARCH_DEBOUNCE_MIN_MS, SEARCH_DEBOUNCE_MS);
+  *slow_delay = CLAMP (slow, SLOW_PROVIDER_MS, SLOW_SEARCH_DEBOUNCE_MAX_MS);
+
+  return slow != 0;
+}
+
+
 static gboolean
 query (PhoshDBusSearch       *interface,
        GDBusMethodInvocation *invocation,
@@ -516,6 +829,8 @@ query (PhoshDBusSearch       *interface,
   PhoshSearchApplicationPrivate *priv = phosh_search_application_get_instance_private (self);
   g_autofree char *striped = NULL;
   g_auto (GStrv) parts = NULL;
+  guint fast_delay, slow_delay;
+  gboolean has_slow;
   int len = 0;
 
   striped = g_strstrip (g_strdup (query));
@@ -534,12 +849,15 @@ query (PhoshDBusSearch       *interface,
   /* Avoid reusing cancellable by creating a new one */
   g_clear_object (&priv->cancellable);
   priv->cancellable = g_cancellable_new ();
+  /* Drop results of any ongoing search */
+  priv->generation++;
+  priv->outstanding_searches = 0;
 
   if (len == 0) {
     g_clear_pointer (&priv->query, g_free);
     g_clear_pointer (&priv->query_parts, g_strfreev);
-
-    priv->doing_subsearch = FALSE;
+    g_clear_handle_id (&priv->search_timeout, g_source_remove);
+    g_clear_handle_id (&priv->slow_search_timeout, g_source_remove);
 
     phosh_dbus_search_complete_query (interface, invocation, FALSE);
     phosh_dbus_search_emit_query_finished (interface);
@@ -547,17 +865,23 @@ query (PhoshDBusSearch       *interface,
     return TRUE;
   }
 
-  if (priv->query != NULL)
-    priv->doing_subsearch = g_str_has_prefix (query, priv->query);
-  else
-    priv->doing_subsearch = FALSE;
-
   g_clear_pointer (&priv->query_parts, g_strfreev);
   priv->query_parts = g_strdupv (parts);
+  g_free (priv->query);
   priv->query = g_strdup (query);
 
-  if (priv->search_timeout == 0)
-    priv->search_timeout = g_timeout_add (150, search_timeout, self);
+  has_slow = get_debounce (self, &fast_delay, &slow_delay);
+
+  if (priv->search_timeout == 0) {
+    priv->search_timeout = g_timeout_add (fast_delay, search_timeout, self);
+    g_source_set_name_by_id (priv->search_timeout, "[phosh-searchd] search");
+  }
+
+  g_clear_handle_id (&priv->slow_search_timeout, g_source_remove);
+  if (has_slow) {
+    priv->slow_search_timeout = g_timeout_add (slow_delay, slow_search_timeout, self);
+    g_source_set_name_by_id (priv->slow_search_timeout, "[phosh-searchd] slow search");
+  }
 
   phosh_dbus_search_complete_query (interface, invocation, TRUE);
 
@@ -635,6 +959,9 @@ reload_providers (PhoshSearchApplication *self)
   GList *list;
   int i = 0;
 
+  /* Cached results might be from providers that went away */
+  result_cache_clear (self);
+
   if (g_settings_get_boolean (priv->settings, "disable-external"))
     g_list_free_full (priv->sources, (GDestroyNotify) phosh_search_source_unref);
 
@@ -841,6 +1168,9 @@ phosh_search_application_init (PhoshSearchApplication *self)
                                            g_str_equal,
                                            g_free,
                                            (GDestroyNotify) g_object_unref);
+  priv->slow_providers = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->result_cache = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&priv->result_cache_lru);
 
   priv->cancellable = g_cancellable_new ();
 
@@ -863,6 +1193,7 @@ phosh_search_application_init (PhoshSearchApplication *self)
                     "object-signal::handle-get-sources", get_sources, self,
                     "object-signal::handle-query", query, self,
                     "object-signal::handle-get-last-results", get_last_results, self,
+                    "object-signal::handle-get-provider-stats", get_provider_stats, self,
                     NULL);
 
   reload_providers (self);
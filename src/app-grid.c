@@ -61,11 +61,16 @@ struct _PhoshAppGridPrivate {
   GtkWidget *folder_name_label;
   GtkWidget *folder_apps;
 
+  /* Launchers of apps currently filtered out, for reuse */
+  GHashTable      *launcher_pool;
+
   PhoshFolderInfo *open_folder;
   int              open_folder_idx;
   GListModel      *folder_model;
 
   char *search_string;
+  /* The search term the model was last filtered with */
+  char *filtered_search;
   gboolean filter_adaptive;
   GSettings *settings;
   GStrv force_adaptive;
@@ -234,19 +239,84 @@ folder_launched_cb (GtkWidget       *widget,
 }
 
 
+typedef struct {
+  char *name;
+  char *collate_key;
+} SortKey;
+
+
+static void
+sort_key_free (SortKey *sort_key)
+{
+  g_free (sort_key->name);
+  g_free (sort_key->collate_key);
+  g_free (sort_key);
+}
+
+
+G_DEFINE_QUARK (phosh-app-grid-sort-key, sort_key)
+
+/*
+ * Get the collation key of the app's casefolded name. The key is stored
+ * on the app info so it's computed once per app rather than on every
+ * comparison. Folders can be renamed so we check the name is still
+ * the same.
+ */
+static const char *
+get_sort_key (GAppInfo *info)
+{
+  const char *name = g_app_info_get_name (info) ?: "";
+  SortKey *sort_key = g_object_get_qdata (G_OBJECT (info), sort_key_quark ());
+  g_autofree char *folded = NULL;
+
+  if (sort_key && g_str_equal (sort_key->name, name))
+    return sort_key->collate_key;
+
+  folded = g_utf8_casefold (name, -1);
+  sort_key = g_new0 (SortKey, 1);
+  sort_key->name = g_strdup (name);
+  sort_key->collate_key = g_utf8_collate_key (folded, -1);
+  g_object_set_qdata_full (G_OBJECT (info), sort_key_quark (), sort_key,
+                           (GDestroyNotify) sort_key_free);
+
+  return sort_key->collate_key;
+}
+
+
 static int
 sort_apps (gconstpointer a,
            gconstpointer b,
            gpointer      data)
 {
-  const char *empty = "";
-  GAppInfo *info1 = G_APP_INFO (a);
-  GAppInfo *info2 = G_APP_INFO (b);
+  return strcmp (get_sort_key (G_APP_INFO (a)), get_sort_key (G_APP_INFO (b)));
+}
 
-  g_autofree char *s1 = g_utf8_casefold (g_app_info_get_name (info1), -1);
-  g_autofree char *s2 = g_utf8_casefold (g_app_info_get_name (info2), -1);
 
-  return g_utf8_collate (s1 ?: empty, s2 ?: empty);
+/**
+ * refilter:
+ * @self: The app grid
+ * @narrow: Whether to only narrow down the current results if possible
+ *
+ * Refilters the app model. When @narrow is set and the current search
+ * term contains the one the model was last filtered with no new apps
+ * can match so only the currently shown ones are checked again.
+ */
+static void
+refilter (PhoshAppGrid *self, gboolean narrow)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  const char *search = priv->search_string;
+  const char *last = priv->filtered_search;
+
+  if (narrow && !gm_str_is_null_or_empty (search) && !gm_str_is_null_or_empty (last) &&
+      strstr (search, last)) {
+    gtk_filter_list_model_refilter_more_strict (priv->model);
+  } else {
+    gtk_filter_list_model_refilter (priv->model);
+  }
+
+  g_free (priv->filtered_search);
+  priv->filtered_search = g_strdup (search);
 }
 
 
@@ -291,7 +361,7 @@ on_filter_setting_changed (PhoshAppGrid *self,
   show = !!(priv->filter_mode & PHOSH_APP_FILTER_MODE_FLAGS_ADAPTIVE);
   gtk_widget_set_visible (priv->btn_adaptive, show);
 
-  gtk_filter_list_model_refilter (priv->model);
+  refilter (self, FALSE);
 }
 
 
@@ -358,7 +428,7 @@ search_apps (gpointer item, gpointer data)
   if (PHOSH_IS_FOLDER_INFO (info))
     return phosh_folder_info_refilter (PHOSH_FOLDER_INFO (info), search);
 
-  return phosh_util_matches_app_info (info, search);
+  return phosh_app_list_model_matches (phosh_app_list_model_get_default (), info, search);
 }
 
 
@@ -402,7 +472,26 @@ favorites_changed (GListModel   *list,
   toggle_favorites_revealer (self);
 
   /* We don't show favorites in the main list, filter them out */
-  gtk_filter_list_model_refilter (priv->model);
+  refilter (self, FALSE);
+}
+
+
+static void
+on_launcher_child_destroy (GtkWidget *child, PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  GtkWidget *btn = gtk_bin_get_child (GTK_BIN (child));
+  gpointer item;
+
+  /* The grid is going away */
+  if (priv->launcher_pool == NULL || btn == NULL)
+    return;
+
+  /* Rescue the launcher before the flow box destroys it */
+  item = g_object_get_data (G_OBJECT (btn), "phosh-app-grid-item");
+  g_object_ref (btn);
+  gtk_container_remove (GTK_CONTAINER (child), btn);
+  g_hash_table_insert (priv->launcher_pool, g_object_ref (item), btn);
 }
 
 
@@ -410,21 +499,70 @@ static GtkWidget *
 create_launcher (gpointer item,
                  gpointer self)
 {
-  GtkWidget *btn;
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (PHOSH_APP_GRID (self));
+  GtkWidget *child, *btn = NULL;
 
-  if (PHOSH_IS_FOLDER_INFO (item)) {
-    btn = phosh_app_grid_folder_button_new_from_folder_info (item);
+  if (g_hash_table_steal_extended (priv->launcher_pool, item, NULL, (gpointer *)&btn)) {
+    /* Drop the key's ref, the launcher's ref is passed to the new child */
+    g_object_unref (item);
+  } else if (PHOSH_IS_FOLDER_INFO (item)) {
+    btn = g_object_ref_sink (phosh_app_grid_folder_button_new_from_folder_info (item));
     g_signal_connect (btn, "folder-launched",
                       G_CALLBACK (folder_launched_cb), self);
   } else {
-    btn = phosh_app_grid_button_new (G_APP_INFO (item));
+    btn = g_object_ref_sink (phosh_app_grid_button_new (G_APP_INFO (item)));
     g_signal_connect (btn, "app-launched",
                       G_CALLBACK (app_launched_cb), self);
   }
-
+  g_object_set_data (G_OBJECT (btn), "phosh-app-grid-item", item);
   gtk_widget_set_visible (btn, TRUE);
 
-  return btn;
+  child = gtk_flow_box_child_new ();
+  gtk_container_add (GTK_CONTAINER (child), btn);
+  g_object_unref (btn);
+  gtk_widget_set_visible (child, TRUE);
+  g_signal_connect (child, "destroy", G_CALLBACK (on_launcher_child_destroy), self);
+
+  return child;
+}
+
+
+static void
+launcher_pool_value_free (gpointer data)
+{
+  gtk_widget_destroy (data);
+  g_object_unref (data);
+}
+
+
+static gboolean
+launcher_pool_is_stale (gpointer key, gpointer value, gpointer data)
+{
+  return !g_hash_table_contains (data, key);
+}
+
+
+static void
+on_apps_changed (GListModel   *list,
+                 guint         position,
+                 guint         removed,
+                 guint         added,
+                 PhoshAppGrid *self)
+{
+  PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
+  g_autoptr (GHashTable) items = NULL;
+  guint n_items;
+
+  if (removed == 0 || g_hash_table_size (priv->launcher_pool) == 0)
+    return;
+
+  /* Drop launchers of apps that went away */
+  items = g_hash_table_new_full (g_direct_hash, g_direct_equal, g_object_unref, NULL);
+  n_items = g_list_model_get_n_items (list);
+  for (guint i = 0; i < n_items; i++)
+    g_hash_table_add (items, g_list_model_get_item (list, i));
+
+  g_hash_table_foreach_remove (priv->launcher_pool, launcher_pool_is_stale, items);
 }
 
 
@@ -449,6 +587,10 @@ phosh_app_grid_init (PhoshAppGrid *self)
                     self);
 
   /* fill the grid with apps */
+  priv->launcher_pool = g_hash_table_new_full (g_direct_hash,
+                                               g_direct_equal,
+                                               g_object_unref,
+                                               launcher_pool_value_free);
   sorted = gtk_sort_list_model_new (G_LIST_MODEL (phosh_app_list_model_get_default ()),
                                     sort_apps,
                                     NULL,
@@ -457,6 +599,8 @@ phosh_app_grid_init (PhoshAppGrid *self)
                                            search_apps,
                                            self,
                                            NULL);
+  g_signal_connect_object (sorted, "items-changed",
+                           G_CALLBACK (on_apps_changed), self, 0);
   g_object_unref (sorted);
   gtk_flow_box_bind_model (GTK_FLOW_BOX (priv->apps),
                            G_LIST_MODEL (priv->model),
@@ -489,6 +633,7 @@ phosh_app_grid_dispose (GObject *object)
 
   g_clear_object (&priv->open_folder);
   g_clear_object (&priv->actions);
+  g_clear_pointer (&priv->launcher_pool, g_hash_table_destroy);
   g_clear_object (&priv->model);
   g_clear_object (&priv->settings);
   g_clear_handle_id (&priv->debounce, g_source_remove);
@@ -504,6 +649,7 @@ phosh_app_grid_finalize (GObject *object)
   PhoshAppGridPrivate *priv = phosh_app_grid_get_instance_private (self);
 
   g_clear_pointer (&priv->search_string, g_free);
+  g_clear_pointer (&priv->filtered_search, g_free);
   g_strfreev (priv->force_adaptive);
 
   G_OBJECT_CLASS (phosh_app_grid_parent_class)->finalize (object);
@@ -544,7 +690,7 @@ do_search (gpointer data)
   }
 
   toggle_favorites_revealer (self);
-  gtk_filter_list_model_refilter (priv->model);
+  refilter (self, TRUE);
 
   priv->debounce = 0;
 }
@@ -593,7 +739,7 @@ on_search_changed (GtkSearchEntry *entry,
   g_clear_handle_id (&priv->debounce, g_source_remove);
 
   if (search && *search != '\0') {
-    priv->search_string = g_utf8_casefold (search, -1);
+    priv->search_string = phosh_app_list_model_normalize_search (search);
 
     /* GtkSearchEntry already adds 150ms of delay, but it's too little
      * so add a bit more until searching is faster and/or non-blocking */
@@ -616,7 +762,7 @@ on_search_preedit_changed (GtkSearchEntry *entry,
   g_clear_pointer (&priv->search_string, g_free);
 
   if (preedit && *preedit != '\0')
-    priv->search_string = g_utf8_casefold (preedit, -1);
+    priv->search_string = phosh_app_list_model_normalize_search (preedit);
 
   g_clear_handle_id (&priv->debounce, g_source_remove);
 
@@ -830,6 +976,6 @@ phosh_app_grid_set_filter_adaptive (PhoshAppGrid *self, gboolean enable)
   priv->filter_adaptive = enable;
   update_filter_adaptive_button (self);
 
-  gtk_filter_list_model_refilter (priv->model);
+  refilter (self, FALSE);
   g_object_notify_by_pspec (G_OBJECT (self), props[PROP_FILTER_ADAPTIVE]);
 }
@@ -14,9 +14,19 @@
 
 #include "app-list-model.h"
 #include "folder-info.h"
+#include "util.h"
+
+#include <gmobile.h>
 
 #include <gio/gio.h>
 
+#include <string.h>
+
+/* Separates the search terms of an app in the search index */
+#define SEARCH_TERM_SEPARATOR '\x1f'
+/* Upper bound of failed app-id lookups to remember */
+#define APP_ID_CACHE_MAX_MISSES 64
+
 typedef struct _PhoshAppListModelPrivate PhoshAppListModelPrivate;
 struct _PhoshAppListModelPrivate {
   GAppInfoMonitor *monitor;
@@ -35,6 +45,18 @@ struct _PhoshAppListModelPrivate {
   GSettings *settings;
 
   GHashTable *startup_wm_class;
+
+  /* Casefolded search terms of all apps, each app's terms are a nul
+   * terminated string in the arena, the index maps app-ids to its offset */
+  GString    *search_arena;
+  GHashTable *search_index;
+  gboolean    search_index_stale;
+
+  /* Resolved app-ids, %NULL values record failed lookups */
+  GHashTable *app_id_cache;
+  GQueue      app_id_misses; /* keys of failed lookups, oldest first */
+  guint       app_id_cache_hits;
+  guint       app_id_cache_misses;
 };
 
 static void list_iface_init (GListModelInterface *iface);
@@ -53,6 +75,10 @@ phosh_app_list_model_finalize (GObject *object)
   g_clear_handle_id (&priv->debounce, g_source_remove);
 
   g_clear_pointer (&priv->startup_wm_class, g_hash_table_destroy);
+  g_clear_pointer (&priv->search_index, g_hash_table_destroy);
+  g_queue_clear (&priv->app_id_misses);
+  g_clear_pointer (&priv->app_id_cache, g_hash_table_destroy);
+  g_string_free (priv->search_arena, TRUE);
   g_clear_object (&priv->monitor);
   g_clear_object (&priv->settings);
 
@@ -129,38 +155,240 @@ list_iface_init (GListModelInterface *iface)
 }
 
 
-static GList*
-filter_out_apps_in_folder (GList *apps, PhoshFolderInfo *folder_info)
+static GList *
+filter_out_apps_in_folders (GList *apps, GHashTable *folder_app_ids)
 {
-  GList *node, *prev;
+  GList *node = apps;
 
-  /* The length of the list is always at least 2. The first element is always the `folder_info`.
-   * This makes the logic easier as otherwise we would have to check for edge-cases like first
-   * element itself part of folder etc. */
+  while (node) {
+    GList *next = g_list_next (node);
+    const char *id = g_app_info_get_id (G_APP_INFO (node->data));
 
-  for (node = g_list_next (apps); node; node = g_list_next (node)) {
-    GAppInfo *app_info = G_APP_INFO (node->data);
-    if (phosh_folder_info_contains (folder_info, app_info)) {
-      prev = g_list_previous (node);
+    if (id && g_hash_table_contains (folder_app_ids, id)) {
+      g_object_unref (node->data);
       apps = g_list_delete_link (apps, node);
-      node = prev;
     }
+    node = next;
   }
 
   return apps;
 }
 
 
+/* Key to match up the items of subsequent rebuilds */
+static char *
+get_item_key (GAppInfo *app_info)
+{
+  /* Desktop ids can't contain '/' so folders can't clash with apps */
+  if (PHOSH_IS_FOLDER_INFO (app_info))
+    return g_strconcat ("/", phosh_folder_info_get_path (PHOSH_FOLDER_INFO (app_info)), NULL);
+
+  return g_strdup (g_app_info_get_id (app_info));
+}
+
+
+static gboolean
+app_info_changed (GAppInfo *old_info, GAppInfo *new_info)
+{
+  GIcon *old_icon, *new_icon;
+
+  /* Folders track their name and apps themselves */
+  if (PHOSH_IS_FOLDER_INFO (old_info))
+    return FALSE;
+
+  if (g_strcmp0 (g_app_info_get_name (old_info), g_app_info_get_name (new_info)) ||
+      g_strcmp0 (g_app_info_get_display_name (old_info), g_app_info_get_display_name (new_info)) ||
+      g_strcmp0 (g_app_info_get_executable (old_info), g_app_info_get_executable (new_info))) {
+    return TRUE;
+  }
+
+  if (G_IS_DESKTOP_APP_INFO (old_info) && G_IS_DESKTOP_APP_INFO (new_info)) {
+    GDesktopAppInfo *old_desktop_info = G_DESKTOP_APP_INFO (old_info);
+    GDesktopAppInfo *new_desktop_info = G_DESKTOP_APP_INFO (new_info);
+
+    if (g_strcmp0 (g_desktop_app_info_get_filename (old_desktop_info),
+                   g_desktop_app_info_get_filename (new_desktop_info))) {
+      return TRUE;
+    }
+
+    if (!g_strv_equal (g_desktop_app_info_list_actions (old_desktop_info),
+                       g_desktop_app_info_list_actions (new_desktop_info))) {
+      return TRUE;
+    }
+  }
+
+  old_icon = g_app_info_get_icon (old_info);
+  new_icon = g_app_info_get_icon (new_info);
+  if (old_icon == NULL || new_icon == NULL)
+    return old_icon != new_icon;
+
+  return !g_icon_equal (old_icon, new_icon);
+}
+
+
+static void
+search_arena_append (GString *arena, const char *str)
+{
+  g_autofree char *normalized = NULL;
+
+  if (gm_str_is_null_or_empty (str))
+    return;
+
+  normalized = phosh_app_list_model_normalize_search (str);
+  g_string_append (arena, normalized);
+  g_string_append_c (arena, SEARCH_TERM_SEPARATOR);
+}
+
+
+/* Append the normalized strings @info is searched by */
+static void
+search_arena_append_app (GString *arena, GAppInfo *info)
+{
+  /* Keep in sync with phosh_util_matches_app_info () */
+  search_arena_append (arena, g_app_info_get_display_name (info));
+  search_arena_append (arena, g_app_info_get_name (info));
+  search_arena_append (arena, g_app_info_get_description (info));
+  search_arena_append (arena, g_app_info_get_executable (info));
+
+  if (G_IS_DESKTOP_APP_INFO (info)) {
+    GDesktopAppInfo *desktop_info = G_DESKTOP_APP_INFO (info);
+    const char * const *kwds;
+
+    search_arena_append (arena, g_desktop_app_info_get_generic_name (desktop_info));
+    search_arena_append (arena, g_desktop_app_info_get_categories (desktop_info));
+
+    kwds = g_desktop_app_info_get_keywords (desktop_info);
+    for (int i = 0; kwds && kwds[i]; i++)
+      search_arena_append (arena, kwds[i]);
+  }
+}
+
+
+static void
+search_index_add (PhoshAppListModel *self, GAppInfo *info)
+{
+  PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
+  const char *id = g_app_info_get_id (info);
+  gsize offset = priv->search_arena->len;
+
+  if (id == NULL || g_hash_table_contains (priv->search_index, id))
+    return;
+
+  search_arena_append_app (priv->search_arena, info);
+  g_string_append_c (priv->search_arena, '\0');
+  g_hash_table_insert (priv->search_index, g_strdup (id), GSIZE_TO_POINTER (offset));
+}
+
+
+static void
+search_index_rebuild (PhoshAppListModel *self, GList *apps)
+{
+  PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
+
+  g_hash_table_remove_all (priv->search_index);
+  g_string_truncate (priv->search_arena, 0);
+
+  for (GList *l = apps; l; l = l->next)
+    search_index_add (self, l->data);
+
+  priv->search_index_stale = FALSE;
+  g_debug ("Search index: %u apps, %" G_GSIZE_FORMAT " bytes",
+           g_hash_table_size (priv->search_index), priv->search_arena->len);
+}
+
+
+static void
+app_id_cache_value_free (gpointer data)
+{
+  /* Failed lookups are cached as %NULL */
+  if (data)
+    g_object_unref (data);
+}
+
+
+static GDesktopAppInfo *
+resolve_app_id (PhoshAppListModel *self, const char *app_id)
+{
+  g_autofree char *desktop_id = NULL;
+  g_autofree char *lowercase = NULL;
+  GDesktopAppInfo *app_info = NULL;
+  const char *last_component;
+
+  desktop_id = g_strdup_printf ("%s.desktop", app_id);
+  app_info = g_desktop_app_info_new (desktop_id);
+  if (app_info)
+    return app_info;
+
+  app_info = phosh_app_list_model_lookup_by_startup_wm_class (self, app_id);
+  if (app_info)
+    return g_object_ref (app_info);
+
+  /* try to handle the case where app-id is rev-DNS, but desktop file is not */
+  last_component = strrchr (app_id, '.');
+  if (last_component) {
+    /* Skip past '.' */
+    last_component++;
+    g_free (desktop_id);
+    desktop_id = g_strdup_printf ("%s.desktop", last_component);
+    app_info = g_desktop_app_info_new (desktop_id);
+    if (app_info)
+      return app_info;
+  }
+
+  /* X11 WM_CLASS is often capitalized, so try in lowercase as well */
+  lowercase = g_utf8_strdown (last_component ?: app_id, -1);
+  app_info = phosh_app_list_model_lookup_by_startup_wm_class (self, lowercase);
+  if (app_info)
+    return g_object_ref (app_info);
+
+  return NULL;
+}
+
+
 static void on_folder_children_changed (PhoshAppListModel *self);
 
 
+typedef struct {
+  guint position;
+  guint removed;
+  guint added;
+} ItemsChangedRun;
+
+
 static void
-emit_items_changed (PhoshAppListModel *self)
+flush_items_changed (PhoshAppListModel *self, ItemsChangedRun *run)
 {
   PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
-  int added = g_sequence_get_length (priv->items);
-  int removed = added;
-  g_list_model_items_changed (G_LIST_MODEL (self), 0, removed, added);
+
+  if (run->removed == 0 && run->added == 0)
+    return;
+
+  priv->last.is_valid = FALSE;
+  priv->last.iter = NULL;
+  priv->last.position = 0;
+
+  g_list_model_items_changed (G_LIST_MODEL (self), run->position, run->removed, run->added);
+
+  run->position += run->added;
+  run->removed = 0;
+  run->added = 0;
+}
+
+
+static void
+on_folder_name_changed (PhoshAppListModel *self, GParamSpec *pspec, PhoshFolderInfo *folder_info)
+{
+  PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
+  GSequenceIter *iter = g_sequence_get_begin_iter (priv->items);
+
+  for (; !g_sequence_iter_is_end (iter); iter = g_sequence_iter_next (iter)) {
+    if (g_sequence_get (iter) == (gpointer) folder_info) {
+      guint position = g_sequence_iter_get_position (iter);
+
+      g_list_model_items_changed (G_LIST_MODEL (self), position, 1, 1);
+      return;
+    }
+  }
 }
 
 
@@ -171,42 +399,56 @@ items_changed (gpointer data)
   PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
   g_auto (GStrv) folder_paths = NULL;
   g_autolist (GAppInfo) new_apps = NULL;
-  int removed;
-  int added = 0;
+  g_autoptr (GHashTable) folder_app_ids = NULL;
+  g_autoptr (GHashTable) new_items = NULL;
+  g_autoptr (GPtrArray) shown = NULL;
+  ItemsChangedRun run = { 0 };
+  GSequenceIter *iter;
 
   new_apps = g_app_info_get_all ();
 
   g_return_val_if_fail (new_apps != NULL, G_SOURCE_REMOVE);
 
-  removed = g_sequence_get_length (priv->items);
-  g_sequence_remove_range (g_sequence_get_begin_iter (priv->items),
-                           g_sequence_get_end_iter (priv->items));
+  /* Index all apps, including the ones that end up in folders */
+  if (priv->search_index_stale)
+    search_index_rebuild (self, new_apps);
+
   g_hash_table_remove_all (priv->startup_wm_class);
+  /* Installed apps or their StartupWMClass might have changed */
+  g_queue_clear (&priv->app_id_misses);
+  g_hash_table_remove_all (priv->app_id_cache);
 
   folder_paths = g_settings_get_strv (priv->settings, "folder-children");
+  folder_app_ids = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+
+  for (int i = 0; folder_paths[i]; i++) {
+    PhoshFolderInfo *folder_info = phosh_folder_info_new_from_folder_path (folder_paths[i]);
 
-  for (int i = 0; i < g_strv_length (folder_paths); i++) {
-    char *path = folder_paths[i];
-    PhoshFolderInfo *folder_info = phosh_folder_info_new_from_folder_path (path);
+    phosh_folder_info_collect_app_ids (folder_info, folder_app_ids);
     new_apps = g_list_prepend (new_apps, folder_info);
-    new_apps = filter_out_apps_in_folder (new_apps, folder_info);
     g_signal_connect_object (folder_info, "apps-changed", G_CALLBACK (on_folder_children_changed),
                              self, G_CONNECT_SWAPPED);
-    g_signal_connect_object (folder_info, "notify::name", G_CALLBACK (emit_items_changed),
+    g_signal_connect_object (folder_info, "notify::name", G_CALLBACK (on_folder_name_changed),
                              self, G_CONNECT_SWAPPED);
   }
+  new_apps = filter_out_apps_in_folders (new_apps, folder_app_ids);
 
+  shown = g_ptr_array_new ();
+  new_items = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
   for (GList *l = new_apps; l; l = g_list_next (l)) {
     const char *startup_wm_class;
     GAppInfo *app_info = l->data;
+    char *key;
 
     /* We add folders irrespective of their emptiness because otherwise we won't be able to listen
      * for apps-changed signal. */
     if (!PHOSH_IS_FOLDER_INFO (app_info) && !g_app_info_should_show (app_info))
       continue;
 
-    g_sequence_append (priv->items, g_object_ref (app_info));
-    added++;
+    g_ptr_array_add (shown, app_info);
+    key = get_item_key (app_info);
+    if (key)
+      g_hash_table_insert (new_items, key, app_info);
 
     if (!G_IS_DESKTOP_APP_INFO (app_info))
       continue;
@@ -219,11 +461,46 @@ items_changed (gpointer data)
     }
   }
 
-  priv->last.is_valid = FALSE;
-  priv->last.iter = NULL;
-  priv->last.position = 0;
+  /* Update the current items in place, keeping their order so only
+   * the removed and changed ones need to be replaced */
+  iter = g_sequence_get_begin_iter (priv->items);
+  while (!g_sequence_iter_is_end (iter)) {
+    GSequenceIter *next = g_sequence_iter_next (iter);
+    GAppInfo *old_info = g_sequence_get (iter);
+    g_autofree char *key = get_item_key (old_info);
+    GAppInfo *new_info = key ? g_hash_table_lookup (new_items, key) : NULL;
+
+    if (new_info == NULL) {
+      g_sequence_remove (iter);
+      run.removed++;
+    } else if (app_info_changed (old_info, new_info)) {
+      g_sequence_set (iter, g_object_ref (new_info));
+      run.removed++;
+      run.added++;
+    } else {
+      flush_items_changed (self, &run);
+      run.position++;
+    }
+
+    if (new_info)
+      g_hash_table_remove (new_items, key);
+
+    iter = next;
+  }
+  flush_items_changed (self, &run);
 
-  g_list_model_items_changed (G_LIST_MODEL (self), 0, removed, added);
+  /* Anything not matched up is new */
+  for (guint i = 0; i < shown->len; i++) {
+    GAppInfo *app_info = g_ptr_array_index (shown, i);
+    g_autofree char *key = get_item_key (app_info);
+
+    if (key && !g_hash_table_remove (new_items, key))
+      continue;
+
+    g_sequence_append (priv->items, g_object_ref (app_info));
+    run.added++;
+  }
+  flush_items_changed (self, &run);
 
   priv->debounce = 0;
 
@@ -232,28 +509,36 @@ items_changed (gpointer data)
 
 
 static void
-on_monitor_changed_cb (GAppInfoMonitor *monitor,
-                       gpointer         data)
+schedule_items_changed (PhoshAppListModel *self)
 {
-  PhoshAppListModel *self = PHOSH_APP_LIST_MODEL (data);
   PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
 
   if (priv->debounce != 0) {
     g_source_remove (priv->debounce);
   }
-  priv->debounce = g_timeout_add (500, items_changed, data);
+  priv->debounce = g_timeout_add (500, items_changed, self);
   g_source_set_name_by_id (priv->debounce, "[phosh] debounce app changes");
 }
 
 
 static void
-on_folder_children_changed (PhoshAppListModel *self)
+on_monitor_changed_cb (GAppInfoMonitor *monitor,
+                       gpointer         data)
 {
+  PhoshAppListModel *self = PHOSH_APP_LIST_MODEL (data);
   PhoshAppListModelPrivate *priv = phosh_app_list_model_get_instance_private (self);
 
+  priv->search_index_stale = TRUE;
+  schedule_items_changed (self);
+}
+
+
+static void
+on_folder_children_changed (PhoshAppListModel *self)
+{
   /* A folder has been created or destroyed or modified.
    * Rearrange the apps from scratch. */
-  on_monitor_changed_cb (priv->monitor, self);
+  schedule_items_changed (self);
 }
 
 
@@ -270,6 +555,12 @@ phosh_app_list_model_init (PhoshAppListModel *self)
 
   priv->last.is_valid = FALSE;
 
+  priv->search_arena = g_string_new (NULL);
+  priv->search_index = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  priv->app_id_cache = g_hash_table_new_full (g_str_hash, g_str_equal, g_free,
+                                              app_id_cache_value_free);
+  g_queue_init (&priv->app_id_misses);
+
   priv->items = g_sequence_new ((GDestroyNotify) g_object_unref);
   priv->monitor = g_app_info_monitor_get ();
   g_signal_connect (priv->monitor, "changed", G_CALLBACK (on_monitor_changed_cb), self);
@@ -322,3 +613,132 @@ phosh_app_list_model_lookup_by_startup_wm_class (PhoshAppListModel *self,
 
   return g_hash_table_lookup (priv->startup_wm_class, class);
 }
+
+/**
+ * phosh_app_list_model_lookup_app_id:
+ * @self: The app list model
+ * @app_id: The app-id
+ *
+ * Looks up the app info for the given application ID. Results are
+ * cached until the installed apps change. Only the most recent failed
+ * lookups are cached as they aren't bounded by the installed apps.
+ *
+ * Returns: (transfer full)(nullable): GDesktopAppInfo for requested app_id
+ */
+GDesktopAppInfo *
+phosh_app_list_model_lookup_app_id (PhoshAppListModel *self, const char *app_id)
+{
+  PhoshAppListModelPrivate *priv;
+  GDesktopAppInfo *app_info;
+  char *key;
+
+  g_return_val_if_fail (PHOSH_IS_APP_LIST_MODEL (self), NULL);
+  g_return_val_if_fail (app_id, NULL);
+
+  priv = phosh_app_list_model_get_instance_private (self);
+
+  if (g_hash_table_lookup_extended (priv->app_id_cache, app_id, NULL, (gpointer *)&app_info)) {
+    priv->app_id_cache_hits++;
+    return app_info ? g_object_ref (app_info) : NULL;
+  }
+
+  priv->app_id_cache_misses++;
+  app_info = resolve_app_id (self, app_id);
+  if (app_info) {
+    g_hash_table_insert (priv->app_id_cache, g_strdup (app_id), g_object_ref (app_info));
+    return app_info;
+  }
+
+  g_message ("Could not find application for app-id '%s'", app_id);
+
+  if (priv->app_id_misses.length >= APP_ID_CACHE_MAX_MISSES)
+    g_hash_table_remove (priv->app_id_cache, g_queue_pop_head (&priv->app_id_misses));
+
+  key = g_strdup (app_id);
+  g_hash_table_insert (priv->app_id_cache, key, NULL);
+  /* The key is owned by the hash table */
+  g_queue_push_tail (&priv->app_id_misses, key);
+
+  return NULL;
+}
+
+/**
+ * phosh_app_list_model_get_app_id_cache_stats:
+ * @self: The app list model
+ * @hits: (out)(optional): Number of app-id lookups answered from the cache
+ * @misses: (out)(optional): Number of app-id lookups that needed a full lookup
+ *
+ * Gets statistics about [method@AppListModel.lookup_app_id].
+ */
+void
+phosh_app_list_model_get_app_id_cache_stats (PhoshAppListModel *self,
+                                             guint             *hits,
+                                             guint             *misses)
+{
+  PhoshAppListModelPrivate *priv;
+
+  g_return_if_fail (PHOSH_IS_APP_LIST_MODEL (self));
+
+  priv = phosh_app_list_model_get_instance_private (self);
+
+  if (hits)
+    *hits = priv->app_id_cache_hits;
+  if (misses)
+    *misses = priv->app_id_cache_misses;
+}
+
+/**
+ * phosh_app_list_model_normalize_search:
+ * @search: The search term
+ *
+ * Normalizes and casefolds a search term so it can be passed to
+ * [method@AppListModel.matches].
+ *
+ * Returns: (transfer full): The normalized search term
+ */
+char *
+phosh_app_list_model_normalize_search (const char *search)
+{
+  g_autofree char *normalized = NULL;
+
+  g_return_val_if_fail (search, NULL);
+
+  normalized = g_utf8_normalize (search, -1, G_NORMALIZE_DEFAULT_COMPOSE);
+  return g_utf8_casefold (normalized ?: search, -1);
+}
+
+/**
+ * phosh_app_list_model_matches:
+ * @self: The app list model
+ * @info: The app info to check
+ * @search: The search term as returned by [func@AppListModel.normalize_search]
+ *
+ * Checks whether the given app matches the search term. This uses the
+ * model's search index so no per app allocations are needed.
+ *
+ * Returns: %TRUE if @info matches @search
+ */
+gboolean
+phosh_app_list_model_matches (PhoshAppListModel *self, GAppInfo *info, const char *search)
+{
+  PhoshAppListModelPrivate *priv;
+  const char *id;
+  gpointer offset;
+
+  g_return_val_if_fail (PHOSH_IS_APP_LIST_MODEL (self), FALSE);
+  g_return_val_if_fail (G_IS_APP_INFO (info), FALSE);
+  g_return_val_if_fail (search, FALSE);
+
+  priv = phosh_app_list_model_get_instance_private (self);
+
+  id = g_app_info_get_id (info);
+  if (id == NULL || !g_hash_table_lookup_extended (priv->search_index, id, NULL, &offset)) {
+    g_autoptr (GString) text = g_string_new (NULL);
+
+    /* Not indexed, normalize like the index so both agree */
+    search_arena_append_app (text, info);
+    return strstr (text->str, search) != NULL;
+  }
+
+  return strstr (priv->search_arena->str + GPOINTER_TO_SIZE (offset), search) != NULL;
+}
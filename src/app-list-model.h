@@ -22,5 +22,14 @@ struct _PhoshAppListModelClass
 PhoshAppListModel *phosh_app_list_model_get_default (void);
 GDesktopAppInfo   *phosh_app_list_model_lookup_by_startup_wm_class (PhoshAppListModel *self,
                                                                     const char        *class);
+GDesktopAppInfo   *phosh_app_list_model_lookup_app_id (PhoshAppListModel *self,
+                                                       const char        *app_id);
+void               phosh_app_list_model_get_app_id_cache_stats (PhoshAppListModel *self,
+                                                                guint             *hits,
+                                                                guint             *misses);
+gboolean           phosh_app_list_model_matches (PhoshAppListModel *self,
+                                                 GAppInfo          *info,
+                                                 const char        *search);
+char              *phosh_app_list_model_normalize_search (const char *search);
 
 G_END_DECLS
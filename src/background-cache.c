@@ -14,22 +14,587 @@
 #include "background-image.h"
 #include "util.h"
 
+#include <gdk/gdk.h>
 #include <gio/gio.h>
 
+#include <errno.h>
+
+/* Upper bound for the memory used by the scaled images */
+#define SCALED_MAX_BYTES (64 * 1024 * 1024)
+/* Upper bound for the scaled images stored on disk */
+#define DISK_MAX_BYTES   (128 * 1024 * 1024)
+
+#define DISK_MAGIC       0x47424850 /* PHBG */
+#define DISK_VERSION     1
+#define DISK_SUFFIX      ".bg"
+
 /**
  * PhoshBackgroundCache:
  *
  * A cache of background images
+ *
+ * Images are decoded in a worker thread at a size that covers the
+ * largest output (see [property@BackgroundCache:max-size]) rather than
+ * their full size.
+ *
+ * Besides the full size images loaded from disk the cache also keeps
+ * the scaled down versions as used by the different background
+ * surfaces. These are keyed by file, size, style and color so
+ * backgrounds on different outputs and the lock screen can share them
+ * and don't need to rescale on every configure. The scaled images are
+ * evicted in least recently used order once they exceed
+ * `SCALED_MAX_BYTES`.
+ *
+ * Scaled images are also stored in `$XDG_CACHE_HOME/phosh/backgrounds`
+ * as raw cairo image data keyed by the source file's modification
+ * time, inode and size as well as the scaling parameters. On the next
+ * start these are mapped into memory directly so no decoding or
+ * scaling is needed to draw the first frame. Querying the source file
+ * and accessing the disk cache happens in a thread.
  */
 
+enum {
+  PROP_0,
+  PROP_MAX_SIZE,
+  PROP_LAST_PROP
+};
+static GParamSpec *props[PROP_LAST_PROP];
+
+enum {
+  SCALED_STORED,
+  N_SIGNALS
+};
+static guint signals[N_SIGNALS];
+
+
+typedef struct {
+  GFile                   *file;
+  int                      width;
+  int                      height;
+  GDesktopBackgroundStyle  style;
+  guint32                  color;
+} ScaledKey;
+
+
+typedef struct {
+  ScaledKey        key;
+  cairo_surface_t *surface;
+  gsize            size;
+} ScaledEntry;
+
+
+/* Header of the on disk format, followed by the image data */
+typedef struct {
+  guint32 magic;
+  guint32 version;
+  gint32  format;
+  gint32  width;
+  gint32  height;
+  gint32  stride;
+  guint32 reserved[2];
+} DiskHeader;
+
+
+typedef struct {
+  char            *dir;
+  ScaledKey        key;
+  cairo_surface_t *surface;
+} DiskData;
+
+static cairo_user_data_key_t mapped_file_key;
+
+
 struct _PhoshBackgroundCache {
   GObject     parent;
 
   GHashTable *background_images;
+  int         max_size;
+
+  GHashTable *scaled;      /* key: ScaledKey, value: GList link in scaled_lru */
+  GQueue      scaled_lru;  /* ScaledEntry, most recently used first */
+  gsize       scaled_bytes;
+
+  char       *disk_dir;
 };
 G_DEFINE_TYPE (PhoshBackgroundCache, phosh_background_cache, G_TYPE_OBJECT)
 
 
+static guint
+scaled_key_hash (gconstpointer data)
+{
+  const ScaledKey *key = data;
+  guint hash = g_file_hash (key->file);
+
+  hash = (hash * 31) + key->width;
+  hash = (hash * 31) + key->height;
+  hash = (hash * 31) + key->style;
+  hash = (hash * 31) + key->color;
+
+  return hash;
+}
+
+
+static guint32
+color_to_key (const GdkRGBA *color)
+{
+  if (color == NULL)
+    return 0;
+
+  return ((((guint32)(color->red   * 255)) << 24) |
+          (((guint32)(color->green * 255)) << 16) |
+          (((guint32)(color->blue  * 255)) << 8)  |
+          (((guint32)(color->alpha * 255))));
+}
+
+
+static gboolean
+scaled_key_equal (gconstpointer a, gconstpointer b)
+{
+  const ScaledKey *key_a = a;
+  const ScaledKey *key_b = b;
+
+  return key_a->width == key_b->width &&
+    key_a->height == key_b->height &&
+    key_a->style == key_b->style &&
+    key_a->color == key_b->color &&
+    g_file_equal (key_a->file, key_b->file);
+}
+
+
+static void
+scaled_entry_free (ScaledEntry *entry)
+{
+  g_clear_object (&entry->key.file);
+  g_clear_pointer (&entry->surface, cairo_surface_destroy);
+  g_free (entry);
+}
+
+
+static void
+drop_scaled_link (PhoshBackgroundCache *self, GList *link)
+{
+  ScaledEntry *entry = link->data;
+
+  g_hash_table_remove (self->scaled, &entry->key);
+  g_queue_delete_link (&self->scaled_lru, link);
+  self->scaled_bytes -= entry->size;
+  scaled_entry_free (entry);
+}
+
+
+static void
+drop_scaled_for_file (PhoshBackgroundCache *self, GFile *file)
+{
+  GList *link = self->scaled_lru.head;
+
+  while (link) {
+    GList *next = link->next;
+    ScaledEntry *entry = link->data;
+
+    if (file == NULL || g_file_equal (entry->key.file, file))
+      drop_scaled_link (self, link);
+
+    link = next;
+  }
+}
+
+
+static void
+evict_scaled (PhoshBackgroundCache *self)
+{
+  /* Always keep the most recently used one */
+  while (self->scaled_bytes > SCALED_MAX_BYTES && self->scaled_lru.length > 1) {
+    ScaledEntry *entry = self->scaled_lru.tail->data;
+
+    g_debug ("Evicting %dx%d scaled background for %s", entry->key.width, entry->key.height,
+             g_file_peek_path (entry->key.file));
+    drop_scaled_link (self, self->scaled_lru.tail);
+  }
+}
+
+
+static DiskData *
+disk_data_new (PhoshBackgroundCache *self, const ScaledKey *key, cairo_surface_t *surface)
+{
+  DiskData *data = g_new0 (DiskData, 1);
+
+  data->dir = g_strdup (self->disk_dir);
+  data->key = *key;
+  data->key.file = g_object_ref (key->file);
+  if (surface)
+    data->surface = cairo_surface_reference (surface);
+
+  return data;
+}
+
+
+static void
+disk_data_free (DiskData *data)
+{
+  g_free (data->dir);
+  g_clear_object (&data->key.file);
+  g_clear_pointer (&data->surface, cairo_surface_destroy);
+  g_free (data);
+}
+
+
+/* Runs in a thread as it queries the file */
+static char *
+get_disk_path (const char *dir, const ScaledKey *key)
+{
+  g_autoptr (GFileInfo) info = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autofree char *uri = NULL;
+  g_autofree char *id = NULL;
+  g_autofree char *checksum = NULL;
+  g_autofree char *name = NULL;
+
+  info = g_file_query_info (key->file,
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                            G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                            G_FILE_ATTRIBUTE_UNIX_INODE ","
+                            G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                            G_FILE_QUERY_INFO_NONE,
+                            NULL,
+                            &err);
+  if (info == NULL) {
+    g_debug ("Failed to query %s: %s", g_file_peek_path (key->file), err->message);
+    return NULL;
+  }
+
+  uri = g_file_get_uri (key->file);
+  id = g_strdup_printf ("%s|%" G_GUINT64_FORMAT ".%u|%" G_GUINT64_FORMAT "|%" G_GOFFSET_FORMAT
+                        "|%dx%d|%d|%08x",
+                        uri,
+                        g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                        g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+                        g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_UNIX_INODE),
+                        g_file_info_get_size (info),
+                        key->width, key->height,
+                        key->style,
+                        key->color);
+  checksum = g_compute_checksum_for_string (G_CHECKSUM_SHA256, id, -1);
+  name = g_strconcat (checksum, DISK_SUFFIX, NULL);
+
+  return g_build_filename (dir, name, NULL);
+}
+
+
+static cairo_surface_t *
+load_from_disk (const char *path, int width, int height)
+{
+  g_autoptr (GMappedFile) mapped = NULL;
+  g_autoptr (GError) err = NULL;
+  cairo_surface_t *surface;
+  const DiskHeader *header;
+  gsize len;
+  char *contents;
+
+  /* Map privately so modifications never end up on disk */
+  mapped = g_mapped_file_new (path, TRUE, &err);
+  if (mapped == NULL) {
+    if (!g_error_matches (err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      g_warning ("Failed to map %s: %s", path, err->message);
+    return NULL;
+  }
+
+  len = g_mapped_file_get_length (mapped);
+  contents = g_mapped_file_get_contents (mapped);
+  if (len < sizeof (DiskHeader)) {
+    g_warning ("Background cache file %s too short", path);
+    return NULL;
+  }
+
+  header = (const DiskHeader *) contents;
+  if (header->magic != DISK_MAGIC || header->version != DISK_VERSION ||
+      header->width != width || header->height != height ||
+      (header->format != CAIRO_FORMAT_RGB24 && header->format != CAIRO_FORMAT_ARGB32) ||
+      header->stride != cairo_format_stride_for_width (header->format, width) ||
+      len != sizeof (DiskHeader) + (gsize) header->stride * header->height) {
+    g_warning ("Background cache file %s is invalid", path);
+    return NULL;
+  }
+
+  surface = cairo_image_surface_create_for_data ((guchar *) contents + sizeof (DiskHeader),
+                                                 header->format,
+                                                 header->width,
+                                                 header->height,
+                                                 header->stride);
+  if (cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS) {
+    cairo_surface_destroy (surface);
+    return NULL;
+  }
+
+  /* The mapping stays around as long as the surface */
+  cairo_surface_set_user_data (surface,
+                               &mapped_file_key,
+                               g_steal_pointer (&mapped),
+                               (cairo_destroy_func_t) g_mapped_file_unref);
+
+  return surface;
+}
+
+
+static int
+cmp_mtime (gconstpointer a, gconstpointer b)
+{
+  GFileInfo *info_a = *(GFileInfo **) a;
+  GFileInfo *info_b = *(GFileInfo **) b;
+  guint64 mtime_a, mtime_b;
+
+  mtime_a = g_file_info_get_attribute_uint64 (info_a, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  mtime_b = g_file_info_get_attribute_uint64 (info_b, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+  return (mtime_a > mtime_b) - (mtime_a < mtime_b);
+}
+
+
+/* Drop the oldest files until we're within the budget. Runs in a thread. */
+static void
+prune_disk (const char *path)
+{
+  g_autoptr (GFile) dir = g_file_new_for_path (path);
+  g_autoptr (GFileEnumerator) enumerator = NULL;
+  g_autoptr (GPtrArray) infos = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr (GError) err = NULL;
+  goffset total = 0;
+  GFileInfo *info;
+
+  enumerator = g_file_enumerate_children (dir,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          NULL,
+                                          &err);
+  if (enumerator == NULL) {
+    g_warning ("Failed to list %s: %s", path, err->message);
+    return;
+  }
+
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL))) {
+    if (!g_str_has_suffix (g_file_info_get_name (info), DISK_SUFFIX)) {
+      g_object_unref (info);
+      continue;
+    }
+    total += g_file_info_get_size (info);
+    g_ptr_array_add (infos, info);
+  }
+
+  if (total <= DISK_MAX_BYTES)
+    return;
+
+  g_ptr_array_sort (infos, cmp_mtime);
+  for (guint i = 0; i < infos->len && total > DISK_MAX_BYTES; i++) {
+    g_autoptr (GFile) file = NULL;
+
+    info = g_ptr_array_index (infos, i);
+    file = g_file_get_child (dir, g_file_info_get_name (info));
+    g_debug ("Pruning %s from background cache", g_file_info_get_name (info));
+    if (g_file_delete (file, NULL, NULL))
+      total -= g_file_info_get_size (info);
+  }
+}
+
+
+static void
+save_to_disk_thread (GTask        *task,
+                     gpointer      source_object,
+                     gpointer      task_data,
+                     GCancellable *cancel)
+{
+  DiskData *data = task_data;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GFileOutputStream) stream = NULL;
+  g_autofree char *path = NULL;
+  GError *err = NULL;
+  DiskHeader header = { 0 };
+
+  path = get_disk_path (data->dir, &data->key);
+  if (path == NULL) {
+    /* Nothing to store, not an error */
+    g_task_return_boolean (task, FALSE);
+    return;
+  }
+  file = g_file_new_for_path (path);
+
+  if (g_mkdir_with_parents (data->dir, 0700) < 0) {
+    g_task_return_new_error (task, G_IO_ERROR, g_io_error_from_errno (errno),
+                             "Failed to create %s: %s", data->dir, g_strerror (errno));
+    return;
+  }
+
+  header.magic = DISK_MAGIC;
+  header.version = DISK_VERSION;
+  header.format = cairo_image_surface_get_format (data->surface);
+  header.width = cairo_image_surface_get_width (data->surface);
+  header.height = cairo_image_surface_get_height (data->surface);
+  header.stride = cairo_image_surface_get_stride (data->surface);
+
+  /* Replacing writes to a temporary file first so readers never see partial data */
+  stream = g_file_replace (file, NULL, FALSE, G_FILE_CREATE_PRIVATE, cancel, &err);
+  if (stream == NULL ||
+      !g_output_stream_write_all (G_OUTPUT_STREAM (stream), &header, sizeof (header),
+                                  NULL, cancel, &err) ||
+      !g_output_stream_write_all (G_OUTPUT_STREAM (stream),
+                                  cairo_image_surface_get_data (data->surface),
+                                  (gsize) header.stride * header.height,
+                                  NULL, cancel, &err) ||
+      !g_output_stream_close (G_OUTPUT_STREAM (stream), cancel, &err)) {
+    g_task_return_error (task, err);
+    return;
+  }
+
+  prune_disk (data->dir);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+static void
+on_save_to_disk_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (source_object);
+  DiskData *data = g_task_get_task_data (G_TASK (res));
+  g_autoptr (GError) err = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (res), &err)) {
+    if (err)
+      g_warning ("Failed to store scaled background: %s", err->message);
+    return;
+  }
+
+  g_signal_emit (self, signals[SCALED_STORED], 0,
+                 data->key.file, data->key.width, data->key.height);
+}
+
+
+static void
+save_to_disk (PhoshBackgroundCache *self, const ScaledKey *key, cairo_surface_t *surface)
+{
+  g_autoptr (GTask) task = NULL;
+
+  /* Make sure all drawing hit the image data before we read it in the thread */
+  cairo_surface_flush (surface);
+
+  task = g_task_new (self, NULL, on_save_to_disk_ready, NULL);
+  g_task_set_source_tag (task, save_to_disk);
+  g_task_set_task_data (task, disk_data_new (self, key, surface), (GDestroyNotify) disk_data_free);
+  g_task_run_in_thread (task, save_to_disk_thread);
+}
+
+
+static void
+load_from_disk_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancel)
+{
+  DiskData *data = task_data;
+  g_autofree char *path = NULL;
+
+  path = get_disk_path (data->dir, &data->key);
+  if (path == NULL) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  g_task_return_pointer (task,
+                         load_from_disk (path, data->key.width, data->key.height),
+                         (GDestroyNotify) cairo_surface_destroy);
+}
+
+
+static cairo_surface_t *
+insert_scaled (PhoshBackgroundCache *self, const ScaledKey *key, cairo_surface_t *surface)
+{
+  ScaledEntry *entry;
+
+  entry = g_new0 (ScaledEntry, 1);
+  entry->key = *key;
+  entry->key.file = g_object_ref (key->file);
+  entry->surface = cairo_surface_reference (surface);
+  entry->size = (gsize) cairo_image_surface_get_stride (surface) *
+    cairo_image_surface_get_height (surface);
+
+  g_queue_push_head (&self->scaled_lru, entry);
+  g_hash_table_insert (self->scaled, &entry->key, self->scaled_lru.head);
+  self->scaled_bytes += entry->size;
+
+  evict_scaled (self);
+
+  return surface;
+}
+
+
+static void
+init_scaled_key (ScaledKey               *key,
+                 GFile                   *file,
+                 int                      width,
+                 int                      height,
+                 GDesktopBackgroundStyle  style,
+                 const GdkRGBA           *color)
+{
+  *key = (ScaledKey) {
+    .file = file,
+    .width = width,
+    .height = height,
+    .style = style,
+    /* Only the scaled style fills in the background color */
+    .color = style == G_DESKTOP_BACKGROUND_STYLE_SCALED ? color_to_key (color) : 0,
+  };
+}
+
+
+static cairo_surface_t *
+lookup_scaled_in_memory (PhoshBackgroundCache *self, const ScaledKey *key)
+{
+  ScaledEntry *entry;
+  GList *link;
+
+  link = g_hash_table_lookup (self->scaled, key);
+  if (link == NULL)
+    return NULL;
+
+  entry = link->data;
+  g_debug ("Scaled background cache hit for %s at %dx%d",
+           g_file_peek_path (key->file), key->width, key->height);
+  g_queue_unlink (&self->scaled_lru, link);
+  g_queue_push_head_link (&self->scaled_lru, link);
+
+  return cairo_surface_reference (entry->surface);
+}
+
+
+static void
+on_load_from_disk_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GTask) task = G_TASK (user_data);
+  PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (source_object);
+  DiskData *data = g_task_get_task_data (G_TASK (res));
+  cairo_surface_t *surface, *cached;
+
+  surface = g_task_propagate_pointer (G_TASK (res), NULL);
+  if (surface == NULL) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  /* Someone might have scaled the image meanwhile */
+  cached = lookup_scaled_in_memory (self, &data->key);
+  if (cached) {
+    cairo_surface_destroy (surface);
+    g_task_return_pointer (task, cached, (GDestroyNotify) cairo_surface_destroy);
+    return;
+  }
+
+  g_debug ("Scaled background disk cache hit for %s at %dx%d",
+           g_file_peek_path (data->key.file), data->key.width, data->key.height);
+  insert_scaled (self, &data->key, surface);
+  g_task_return_pointer (task, surface, (GDestroyNotify) cairo_surface_destroy);
+}
+
+
 static void
 on_background_image_loaded (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
@@ -48,18 +613,62 @@ on_background_image_loaded (GObject *source_object, GAsyncResult *res, gpointer
   self = PHOSH_BACKGROUND_CACHE (g_task_get_source_object (task));
   g_return_if_fail (PHOSH_IS_BACKGROUND_CACHE (self));
   file = phosh_background_image_get_file (image);
-  g_hash_table_insert (self->background_images, g_object_ref (file), g_object_ref (image));
+
+  /* Don't cache images decoded for a different output configuration */
+  if (GPOINTER_TO_INT (g_task_get_task_data (task)) == self->max_size)
+    g_hash_table_insert (self->background_images, g_object_ref (file), g_object_ref (image));
 
   g_task_return_pointer (task, g_steal_pointer (&image), g_object_unref);
 }
 
 
+static void
+phosh_background_cache_set_property (GObject      *object,
+                                     guint         property_id,
+                                     const GValue *value,
+                                     GParamSpec   *pspec)
+{
+  PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (object);
+
+  switch (property_id) {
+  case PROP_MAX_SIZE:
+    phosh_background_cache_set_max_size (self, g_value_get_int (value));
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
+static void
+phosh_background_cache_get_property (GObject    *object,
+                                     guint       property_id,
+                                     GValue     *value,
+                                     GParamSpec *pspec)
+{
+  PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (object);
+
+  switch (property_id) {
+  case PROP_MAX_SIZE:
+    g_value_set_int (value, self->max_size);
+    break;
+  default:
+    G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+    break;
+  }
+}
+
+
 static void
 phosh_background_cache_finalize (GObject *object)
 {
   PhoshBackgroundCache *self = PHOSH_BACKGROUND_CACHE (object);
 
+  g_queue_clear_full (&self->scaled_lru, (GDestroyNotify) scaled_entry_free);
+  g_clear_pointer (&self->scaled, g_hash_table_destroy);
   g_clear_pointer (&self->background_images, g_hash_table_destroy);
+  g_clear_pointer (&self->disk_dir, g_free);
 
   G_OBJECT_CLASS (phosh_background_cache_parent_class)->finalize (object);
 }
@@ -70,7 +679,44 @@ phosh_background_cache_class_init (PhoshBackgroundCacheClass *klass)
 {
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
+  object_class->get_property = phosh_background_cache_get_property;
+  object_class->set_property = phosh_background_cache_set_property;
   object_class->finalize = phosh_background_cache_finalize;
+
+  /**
+   * PhoshBackgroundCache:max-size:
+   *
+   * The longest edge of all outputs in pixels. Images are decoded so
+   * they cover a square of this size. `0` means to decode images at
+   * their full size. Cached images are dropped when this changes so
+   * users should reload their images on notify.
+   */
+  props[PROP_MAX_SIZE] =
+    g_param_spec_int ("max-size", "", "",
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY | G_PARAM_STATIC_STRINGS);
+
+  g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
+
+  /**
+   * PhoshBackgroundCache::scaled-stored:
+   * @self: The background cache
+   * @file: The file of the stored image
+   * @width: The width of the scaled image
+   * @height: The height of the scaled image
+   *
+   * Emitted once a scaled image got stored on disk.
+   */
+  signals[SCALED_STORED] =
+    g_signal_new ("scaled-stored",
+                  G_TYPE_FROM_CLASS (klass),
+                  G_SIGNAL_RUN_LAST,
+                  0, NULL, NULL, NULL,
+                  G_TYPE_NONE,
+                  3,
+                  G_TYPE_FILE,
+                  G_TYPE_INT,
+                  G_TYPE_INT);
 }
 
 
@@ -81,6 +727,9 @@ phosh_background_cache_init (PhoshBackgroundCache *self)
                                                    (GEqualFunc) g_file_equal,
                                                    g_object_unref,
                                                    g_object_unref);
+  self->scaled = g_hash_table_new (scaled_key_hash, scaled_key_equal);
+  g_queue_init (&self->scaled_lru);
+  self->disk_dir = g_build_filename (g_get_user_cache_dir (), "phosh", "backgrounds", NULL);
 }
 
 /**
@@ -128,6 +777,7 @@ phosh_background_cache_fetch_async (PhoshBackgroundCache *self,
 
   task = g_task_new (self, cancel, callback, user_data);
   g_task_set_source_tag (task, phosh_background_cache_fetch_async);
+  g_task_set_task_data (task, GINT_TO_POINTER (self->max_size), NULL);
 
   image = g_hash_table_lookup (self->background_images, file);
   if (image) {
@@ -135,7 +785,11 @@ phosh_background_cache_fetch_async (PhoshBackgroundCache *self,
     g_task_return_pointer (task, g_object_ref (image), g_object_unref);
   } else {
     g_debug ("Background cache miss for %s", g_file_peek_path (file));
-    phosh_background_image_new (file, cancel, on_background_image_loaded, g_steal_pointer (&task));
+    phosh_background_image_new (file,
+                                self->max_size,
+                                cancel,
+                                on_background_image_loaded,
+                                g_steal_pointer (&task));
   }
 }
 
@@ -193,9 +847,12 @@ phosh_background_cache_remove (PhoshBackgroundCache *self, GFile *file)
 
   g_return_if_fail (PHOSH_IS_BACKGROUND_CACHE (self));
 
+  drop_scaled_for_file (self, file);
+
+  /* Backgrounds shown from the disk cache are never decoded */
   success = g_hash_table_remove (self->background_images, file);
   if (!success)
-    g_warning ("'%s' not found in cache", g_file_peek_path (file));
+    g_debug ("'%s' not found in cache", g_file_peek_path (file));
 }
 
 /**
@@ -210,5 +867,211 @@ phosh_background_cache_clear_all (PhoshBackgroundCache *self)
   g_return_if_fail (PHOSH_IS_BACKGROUND_CACHE (self));
 
   g_debug ("Clearing background image cache");
+  drop_scaled_for_file (self, NULL);
   g_hash_table_remove_all (self->background_images);
 }
+
+/**
+ * phosh_background_cache_lookup_scaled:
+ * @self: The background cache
+ * @file: The image's file
+ * @width: The target width
+ * @height: The target height
+ * @style: How to fit the image into the target size
+ * @color: The color to fill uncovered areas with
+ *
+ * Looks up a scaled image in memory. This allows to display an image
+ * without the need to decode it. See
+ * [method@BackgroundCache.load_scaled_async] to also look on disk.
+ *
+ * Returns:(transfer full)(nullable): The scaled image or %NULL if not
+ *   in the cache
+ */
+cairo_surface_t *
+phosh_background_cache_lookup_scaled (PhoshBackgroundCache    *self,
+                                      GFile                   *file,
+                                      int                      width,
+                                      int                      height,
+                                      GDesktopBackgroundStyle  style,
+                                      const GdkRGBA           *color)
+{
+  ScaledKey key;
+
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_CACHE (self), NULL);
+  g_return_val_if_fail (G_IS_FILE (file), NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  if (style == G_DESKTOP_BACKGROUND_STYLE_NONE)
+    return NULL;
+
+  init_scaled_key (&key, file, width, height, style, color);
+
+  return lookup_scaled_in_memory (self, &key);
+}
+
+/**
+ * phosh_background_cache_load_scaled_async:
+ * @self: The background cache
+ * @file: The image's file
+ * @width: The target width
+ * @height: The target height
+ * @style: How to fit the image into the target size
+ * @color: The color to fill uncovered areas with
+ * @cancel: A cancellable
+ * @callback: The callback to invoke when done
+ * @user_data: The user data for the callback
+ *
+ * Looks up a scaled image in memory and on disk. The file is queried
+ * and the disk cache accessed in a thread.
+ */
+void
+phosh_background_cache_load_scaled_async (PhoshBackgroundCache    *self,
+                                          GFile                   *file,
+                                          int                      width,
+                                          int                      height,
+                                          GDesktopBackgroundStyle  style,
+                                          const GdkRGBA           *color,
+                                          GCancellable            *cancel,
+                                          GAsyncReadyCallback      callback,
+                                          gpointer                 user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  g_autoptr (GTask) disk_task = NULL;
+  cairo_surface_t *surface;
+  ScaledKey key;
+
+  g_return_if_fail (PHOSH_IS_BACKGROUND_CACHE (self));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (width > 0 && height > 0);
+
+  task = g_task_new (self, cancel, callback, user_data);
+  g_task_set_source_tag (task, phosh_background_cache_load_scaled_async);
+
+  if (style == G_DESKTOP_BACKGROUND_STYLE_NONE) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  init_scaled_key (&key, file, width, height, style, color);
+  surface = lookup_scaled_in_memory (self, &key);
+  if (surface) {
+    g_task_return_pointer (task, surface, (GDestroyNotify) cairo_surface_destroy);
+    return;
+  }
+
+  disk_task = g_task_new (self, cancel, on_load_from_disk_ready, g_steal_pointer (&task));
+  g_task_set_source_tag (disk_task, load_from_disk_thread);
+  g_task_set_task_data (disk_task, disk_data_new (self, &key, NULL), (GDestroyNotify) disk_data_free);
+  g_task_run_in_thread (disk_task, load_from_disk_thread);
+}
+
+/**
+ * phosh_background_cache_load_scaled_finish:
+ * @self: The background cache
+ * @res: The result
+ * @error: The return location for an error
+ *
+ * Finishes the async operation started with
+ * `phosh_background_cache_load_scaled_async`. Not finding the image
+ * isn't an error.
+ *
+ * Returns:(transfer full)(nullable): The scaled image or %NULL if not
+ *   in the cache
+ */
+cairo_surface_t *
+phosh_background_cache_load_scaled_finish (PhoshBackgroundCache  *self,
+                                           GAsyncResult          *res,
+                                           GError               **error)
+{
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_CACHE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * phosh_background_cache_get_scaled:
+ * @self: The background cache
+ * @image: The image to scale
+ * @width: The target width
+ * @height: The target height
+ * @style: How to fit the image into the target size
+ * @color: The color to fill uncovered areas with
+ *
+ * Gets the given image scaled to the given size and style. If a matching
+ * scaled image is in memory it is reused, otherwise the image is scaled
+ * and the result added to the cache.
+ *
+ * Returns:(transfer full)(nullable): The scaled image or %NULL if the style
+ *   doesn't need an image
+ */
+cairo_surface_t *
+phosh_background_cache_get_scaled (PhoshBackgroundCache    *self,
+                                   PhoshBackgroundImage    *image,
+                                   int                      width,
+                                   int                      height,
+                                   GDesktopBackgroundStyle  style,
+                                   const GdkRGBA           *color)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  cairo_surface_t *surface;
+  ScaledKey key;
+  GFile *file;
+
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_CACHE (self), NULL);
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_IMAGE (image), NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  file = phosh_background_image_get_file (image);
+  surface = phosh_background_cache_lookup_scaled (self, file, width, height, style, color);
+  if (surface)
+    return surface;
+
+  if (style == G_DESKTOP_BACKGROUND_STYLE_NONE)
+    return NULL;
+
+  g_debug ("Scaling background %s to %dx%d", g_file_peek_path (file), width, height);
+  pixbuf = phosh_background_image_scale (image, width, height, style, color);
+  if (pixbuf == NULL)
+    return NULL;
+
+  surface = gdk_cairo_surface_create_from_pixbuf (pixbuf, 1, NULL);
+
+  init_scaled_key (&key, file, width, height, style, color);
+  save_to_disk (self, &key, surface);
+
+  return insert_scaled (self, &key, surface);
+}
+
+/**
+ * phosh_background_cache_set_max_size:
+ * @self: The background cache
+ * @max_size: The longest edge of all outputs in pixels
+ *
+ * Sets the size of the square images need to cover. If the size
+ * changes all cached images are dropped.
+ */
+void
+phosh_background_cache_set_max_size (PhoshBackgroundCache *self, int max_size)
+{
+  g_return_if_fail (PHOSH_IS_BACKGROUND_CACHE (self));
+  g_return_if_fail (max_size >= 0);
+
+  if (self->max_size == max_size)
+    return;
+
+  g_debug ("Background max size changed from %d to %d", self->max_size, max_size);
+  self->max_size = max_size;
+  phosh_background_cache_clear_all (self);
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_MAX_SIZE]);
+}
+
+
+int
+phosh_background_cache_get_max_size (PhoshBackgroundCache *self)
+{
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_CACHE (self), 0);
+
+  return self->max_size;
+}
@@ -11,6 +11,8 @@
 #include <glib-object.h>
 #include <gio/gio.h>
 
+#include <cairo.h>
+
 G_BEGIN_DECLS
 
 #define PHOSH_TYPE_BACKGROUND_CACHE (phosh_background_cache_get_type ())
@@ -18,18 +20,45 @@ G_BEGIN_DECLS
 G_DECLARE_FINAL_TYPE (PhoshBackgroundCache, phosh_background_cache, PHOSH, BACKGROUND_CACHE, GObject)
 
 PhoshBackgroundCache         *phosh_background_cache_get_default       (void);
-void                          phosh_background_cache_fetch_async       (PhoshBackgroundCache *self,
-                                                                        GFile                *file,
-                                                                        GCancellable         *cancel,
-                                                                        GAsyncReadyCallback   callback,
-                                                                        gpointer              user_data);
-PhoshBackgroundImage *        phosh_background_cache_fetch_finish      (PhoshBackgroundCache *self,
-                                                                        GAsyncResult         *res,
-                                                                        GError              **error);
-PhoshBackgroundImage         *phosh_background_cache_lookup_background (PhoshBackgroundCache *self,
-                                                                        GFile                *file);
-void                          phosh_background_cache_remove            (PhoshBackgroundCache *self,
-                                                                        GFile                *file);
-void                          phosh_background_cache_clear_all         (PhoshBackgroundCache *self);
+void                          phosh_background_cache_fetch_async       (PhoshBackgroundCache    *self,
+                                                                        GFile                   *file,
+                                                                        GCancellable            *cancel,
+                                                                        GAsyncReadyCallback      callback,
+                                                                        gpointer                 user_data);
+PhoshBackgroundImage *        phosh_background_cache_fetch_finish      (PhoshBackgroundCache    *self,
+                                                                        GAsyncResult            *res,
+                                                                        GError                 **error);
+PhoshBackgroundImage         *phosh_background_cache_lookup_background (PhoshBackgroundCache    *self,
+                                                                        GFile                   *file);
+void                          phosh_background_cache_remove            (PhoshBackgroundCache    *self,
+                                                                        GFile                   *file);
+void                          phosh_background_cache_clear_all         (PhoshBackgroundCache    *self);
+cairo_surface_t              *phosh_background_cache_lookup_scaled     (PhoshBackgroundCache    *self,
+                                                                        GFile                   *file,
+                                                                        int                      width,
+                                                                        int                      height,
+                                                                        GDesktopBackgroundStyle  style,
+                                                                        const GdkRGBA           *color);
+void                          phosh_background_cache_load_scaled_async (PhoshBackgroundCache    *self,
+                                                                        GFile                   *file,
+                                                                        int                      width,
+                                                                        int                      height,
+                                                                        GDesktopBackgroundStyle  style,
+                                                                        const GdkRGBA           *color,
+                                                                        GCancellable            *cancel,
+                                                                        GAsyncReadyCallback      callback,
+                                                                        gpointer                 user_data);
+cairo_surface_t              *phosh_background_cache_load_scaled_finish (PhoshBackgroundCache    *self,
+                                                                         GAsyncResult            *res,
+                                                                         GError                 **error);
+cairo_surface_t              *phosh_background_cache_get_scaled        (PhoshBackgroundCache    *self,
+                                                                        PhoshBackgroundImage    *image,
+                                                                        int                      width,
+                                                                        int                      height,
+                                                                        GDesktopBackgroundStyle  style,
+                                                                        const GdkRGBA           *color);
+void                          phosh_background_cache_set_max_size      (PhoshBackgroundCache    *self,
+                                                                        int                      max_size);
+int                           phosh_background_cache_get_max_size      (PhoshBackgroundCache    *self);
 
 G_END_DECLS
@@ -11,18 +11,34 @@
 #include "phosh-config.h"
 
 #include "background-image.h"
+#include "util.h"
 
 #include <gtk/gtk.h>
 #include <gio/gio.h>
 
+#include <math.h>
+
+#define COLOR_TO_PIXEL(color)     ((((int)(color->red   * 255)) << 24) | \
+                                   (((int)(color->green * 255)) << 16) | \
+                                   (((int)(color->blue  * 255)) << 8)  | \
+                                   (((int)(color->alpha * 255))))
+
+#define LOAD_BUFFER_SIZE (64 * 1024)
+
 /**
  * PhoshBackgroundImage:
  *
  * An image for a [type@Background] that can be loaded async via [type@BackgroundCache].
+ *
+ * If a [property@BackgroundImage:max-size] is given the image is
+ * downscaled while decoding so it covers a square of that size. This
+ * avoids keeping large images in memory that are only displayed on
+ * small outputs.
  */
 enum {
   PROP_0,
   PROP_FILE,
+  PROP_MAX_SIZE,
   PROP_LAST_PROP
 };
 static GParamSpec *props[PROP_LAST_PROP];
@@ -31,6 +47,7 @@ struct _PhoshBackgroundImage {
   GObject            parent;
 
   GFile             *file;
+  int                max_size;
   GdkPixbuf         *pixbuf;
   GTimer            *load_timer;
 };
@@ -43,6 +60,60 @@ G_DEFINE_TYPE_WITH_CODE (PhoshBackgroundImage, phosh_background_image, G_TYPE_OB
                          G_IMPLEMENT_INTERFACE (G_TYPE_ASYNC_INITABLE, async_initable_iface_init));
 
 
+static void
+on_size_prepared (GdkPixbufLoader *loader, int width, int height, gpointer user_data)
+{
+  PhoshBackgroundImage *self = PHOSH_BACKGROUND_IMAGE (user_data);
+  double factor;
+
+  if (self->max_size <= 0 || width <= 0 || height <= 0)
+    return;
+
+  /* Outputs can be rotated and the image can have an embedded
+   * orientation so make sure the shorter edge covers the longest
+   * output edge. Never upscale. */
+  factor = self->max_size / (double) MIN (width, height);
+  if (factor >= 1.0)
+    return;
+
+  g_debug ("Decoding %dx%d image at %.2f", width, height, factor);
+  gdk_pixbuf_loader_set_size (loader, ceil (width * factor), ceil (height * factor));
+}
+
+
+static GdkPixbuf *
+load_pixbuf (PhoshBackgroundImage *self, GInputStream *stream, GCancellable *cancel, GError **error)
+{
+  g_autoptr (GdkPixbufLoader) loader = gdk_pixbuf_loader_new ();
+  g_autofree guchar *buffer = g_malloc (LOAD_BUFFER_SIZE);
+  GdkPixbuf *pixbuf;
+  gssize n_read;
+
+  g_signal_connect (loader, "size-prepared", G_CALLBACK (on_size_prepared), self);
+
+  do {
+    n_read = g_input_stream_read (stream, buffer, LOAD_BUFFER_SIZE, cancel, error);
+    if (n_read < 0 ||
+        (n_read > 0 && !gdk_pixbuf_loader_write (loader, buffer, n_read, error))) {
+      gdk_pixbuf_loader_close (loader, NULL);
+      return NULL;
+    }
+  } while (n_read > 0);
+
+  if (!gdk_pixbuf_loader_close (loader, error))
+    return NULL;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf == NULL) {
+    g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                 "Failed to decode '%s'", g_file_peek_path (self->file));
+    return NULL;
+  }
+
+  return g_object_ref (pixbuf);
+}
+
+
 static gboolean
 initable_init (GInitable *initable, GCancellable *cancel, GError **error)
 {
@@ -58,7 +129,7 @@ initable_init (GInitable *initable, GCancellable *cancel, GError **error)
     return FALSE;
   }
 
-  pixbuf = gdk_pixbuf_new_from_stream (G_INPUT_STREAM (stream), cancel, &local_error);
+  pixbuf = load_pixbuf (self, G_INPUT_STREAM (stream), cancel, &local_error);
   if (pixbuf == NULL) {
     g_propagate_error (error, local_error);
     return FALSE;
@@ -71,12 +142,50 @@ initable_init (GInitable *initable, GCancellable *cancel, GError **error)
   self->pixbuf = g_steal_pointer (&pixbuf);
 
   g_timer_stop (self->load_timer);
-  g_debug ("Background load took %.2fs", g_timer_elapsed (self->load_timer, NULL));
+  g_debug ("Background load took %.2fs, size %dx%d", g_timer_elapsed (self->load_timer, NULL),
+           gdk_pixbuf_get_width (self->pixbuf), gdk_pixbuf_get_height (self->pixbuf));
 
   return TRUE;
 }
 
 
+static GdkPixbuf *
+pb_scale_to_fit (GdkPixbuf *src, int width, int height, const GdkRGBA *color)
+{
+  int orig_width, orig_height;
+  int final_width, final_height;
+  int off_x, off_y;
+  double ratio_horiz, ratio_vert, ratio;
+  GdkPixbuf *bg;
+
+  bg = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  gdk_pixbuf_fill (bg, COLOR_TO_PIXEL(color));
+
+  orig_width = gdk_pixbuf_get_width (src);
+  orig_height = gdk_pixbuf_get_height (src);
+  ratio_horiz = (double) width / orig_width;
+  ratio_vert = (double) height / orig_height;
+
+  ratio = ratio_horiz > ratio_vert ? ratio_vert : ratio_horiz;
+  final_width = ceil (ratio * orig_width);
+  final_height = ceil (ratio * orig_height);
+
+  off_x = (width - final_width) / 2;
+  off_y = (height - final_height) / 2;
+  gdk_pixbuf_composite (src,
+                        bg,
+                        off_x, off_y, /* dest x,y */
+                        final_width,
+                        final_height,
+                        off_x, off_y, /* offset x, y */
+                        ratio,
+                        ratio,
+                        GDK_INTERP_BILINEAR,
+                        255);
+  return bg;
+}
+
+
 static void
 initable_iface_init (GInitableIface *iface)
 {
@@ -103,6 +212,9 @@ phosh_background_image_set_property (GObject      *object,
   case PROP_FILE:
     self->file = g_value_dup_object (value);
     break;
+  case PROP_MAX_SIZE:
+    self->max_size = g_value_get_int (value);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -122,6 +234,9 @@ phosh_background_image_get_property (GObject    *object,
   case PROP_FILE:
     g_value_set_object (value, self->file);
     break;
+  case PROP_MAX_SIZE:
+    g_value_set_int (value, self->max_size);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
     break;
@@ -155,6 +270,17 @@ phosh_background_image_class_init (PhoshBackgroundImageClass *klass)
     g_param_spec_object ("file", "", "",
                          G_TYPE_FILE,
                          G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY);
+  /**
+   * PhoshBackgroundImage:max-size:
+   *
+   * The size of the square the decoded image needs to cover. Larger
+   * images are scaled down while decoding. `0` means to decode at
+   * full size.
+   */
+  props[PROP_MAX_SIZE] =
+    g_param_spec_int ("max-size", "", "",
+                      0, G_MAXINT, 0,
+                      G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY | G_PARAM_STATIC_STRINGS);
 
   g_object_class_install_properties (object_class, PROP_LAST_PROP, props);
 }
@@ -168,18 +294,31 @@ phosh_background_image_init (PhoshBackgroundImage *self)
 
 
 PhoshBackgroundImage *
-phosh_background_image_new_sync (GFile *file, GCancellable *cancel, GError **error)
+phosh_background_image_new_sync (GFile *file, int max_size, GCancellable *cancel, GError **error)
 {
   return PHOSH_BACKGROUND_IMAGE (g_initable_new (PHOSH_TYPE_BACKGROUND_IMAGE,
                                                  cancel,
                                                  error,
                                                  "file", file,
+                                                 "max-size", max_size,
                                                  NULL));
 }
 
-
+/**
+ * phosh_background_image_new:
+ * @file: The file to load the image from
+ * @max_size: The size of the square the image needs to cover or `0`
+ * @cancellable: A cancellable
+ * @callback: The callback to invoke when the image is loaded
+ * @user_data: The user data for the callback
+ *
+ * Loads and decodes an image in a worker thread. If @max_size is
+ * larger than `0` the image is downscaled during decoding so that it
+ * covers a square of size @max_size.
+ */
 void
 phosh_background_image_new (GFile              *file,
+                            int                 max_size,
                             GCancellable       *cancellable,
                             GAsyncReadyCallback callback,
                             gpointer            user_data)
@@ -192,6 +331,7 @@ phosh_background_image_new (GFile              *file,
                               callback,
                               user_data,
                               "file", file,
+                              "max-size", max_size,
                               NULL);
 }
 
@@ -241,3 +381,53 @@ phosh_background_image_get_file (PhoshBackgroundImage *self)
 
   return self->file;
 }
+
+/**
+ * phosh_background_image_scale:
+ * @self: The background image
+ * @width: The target width
+ * @height: The target height
+ * @style: How to fit the image into the target size
+ * @color: The color to fill uncovered areas with
+ *
+ * Scales the background image to the given size honoring the given
+ * style. This is potentially expensive so users should usually go
+ * via [method@BackgroundCache.get_scaled] instead.
+ *
+ * Returns:(transfer full)(nullable): The scaled pixbuf or %NULL if the
+ *   style doesn't need an image.
+ */
+GdkPixbuf *
+phosh_background_image_scale (PhoshBackgroundImage    *self,
+                              int                      width,
+                              int                      height,
+                              GDesktopBackgroundStyle  style,
+                              const GdkRGBA           *color)
+{
+  GdkPixbuf *scaled_bg = NULL;
+
+  g_return_val_if_fail (PHOSH_IS_BACKGROUND_IMAGE (self), NULL);
+  g_return_val_if_fail (width > 0 && height > 0, NULL);
+
+  switch (style) {
+  case G_DESKTOP_BACKGROUND_STYLE_NONE:
+    /* Nothing to do */
+    break;
+  case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+    g_return_val_if_fail (color, NULL);
+    scaled_bg = pb_scale_to_fit (self->pixbuf, width, height, color);
+    break;
+  case G_DESKTOP_BACKGROUND_STYLE_WALLPAPER:
+  case G_DESKTOP_BACKGROUND_STYLE_CENTERED:
+  case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+  case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
+    g_warning ("Unimplemented style %d, using zoom", style);
+    G_GNUC_FALLTHROUGH;
+  case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
+  default:
+    scaled_bg = phosh_utils_pixbuf_scale_to_min (self->pixbuf, width, height);
+    break;
+  }
+
+  return scaled_bg;
+}
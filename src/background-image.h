@@ -9,6 +9,9 @@
 #include <gio/gio.h>
 #include <glib-object.h>
 #include <gdk-pixbuf/gdk-pixbuf.h>
+#include <gdk/gdk.h>
+
+#include <gdesktop-enums.h>
 
 G_BEGIN_DECLS
 
@@ -16,17 +19,24 @@ G_BEGIN_DECLS
 
 G_DECLARE_FINAL_TYPE (PhoshBackgroundImage, phosh_background_image, PHOSH, BACKGROUND_IMAGE, GObject)
 
-PhoshBackgroundImage     *phosh_background_image_new_sync               (GFile                *file,
-                                                                         GCancellable         *cancellable,
-                                                                         GError               **error);
-void                      phosh_background_image_new                    (GFile                *file,
-                                                                         GCancellable         *cancellable,
-                                                                         GAsyncReadyCallback   callback,
-                                                                         gpointer              user_data);
-PhoshBackgroundImage     *phosh_background_image_new_finish             (GAsyncResult          *res,
-                                                                         GError               **error);
-GdkPixbuf                *phosh_background_image_get_pixbuf             (PhoshBackgroundImage *self);
-GFile                    *phosh_background_image_get_file               (PhoshBackgroundImage *self);
+PhoshBackgroundImage     *phosh_background_image_new_sync               (GFile                   *file,
+                                                                         int                      max_size,
+                                                                         GCancellable            *cancellable,
+                                                                         GError                 **error);
+void                      phosh_background_image_new                    (GFile                   *file,
+                                                                         int                      max_size,
+                                                                         GCancellable            *cancellable,
+                                                                         GAsyncReadyCallback      callback,
+                                                                         gpointer                 user_data);
+PhoshBackgroundImage     *phosh_background_image_new_finish             (GAsyncResult            *res,
+                                                                         GError                 **error);
+GdkPixbuf                *phosh_background_image_get_pixbuf             (PhoshBackgroundImage    *self);
+GFile                    *phosh_background_image_get_file               (PhoshBackgroundImage    *self);
+GdkPixbuf                *phosh_background_image_scale                  (PhoshBackgroundImage    *self,
+                                                                         int                      width,
+                                                                         int                      height,
+                                                                         GDesktopBackgroundStyle  style,
+                                                                         const GdkRGBA           *color);
 
 
 
@@ -298,6 +298,33 @@ create_background_for_monitor (PhoshBackgroundManager *self, PhoshMonitor *monit
 }
 
 
+/* Let the cache know the largest output size so it can decode images accordingly */
+static gboolean
+update_max_size (PhoshBackgroundManager *self)
+{
+  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
+  GHashTableIter iter;
+  gpointer key;
+  int max_size = 0;
+
+  g_hash_table_iter_init (&iter, self->backgrounds);
+  while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    PhoshMonitorMode *mode = phosh_monitor_get_current_mode (PHOSH_MONITOR (key));
+
+    if (mode == NULL)
+      continue;
+
+    max_size = MAX (max_size, MAX (mode->width, mode->height));
+  }
+
+  if (max_size == phosh_background_cache_get_max_size (cache))
+    return FALSE;
+
+  phosh_background_cache_set_max_size (cache, max_size);
+  return TRUE;
+}
+
+
 static void
 on_monitor_removed (PhoshBackgroundManager *self,
                     PhoshMonitor           *monitor,
@@ -311,6 +338,9 @@ on_monitor_removed (PhoshBackgroundManager *self,
 
   g_debug ("Monitor %p removed, removing background", monitor);
   g_hash_table_remove (self->backgrounds, monitor);
+
+  if (update_max_size (self))
+    g_hash_table_foreach (self->backgrounds, update_background, self);
 }
 
 
@@ -318,6 +348,7 @@ static void
 on_monitor_configured (PhoshBackgroundManager *self, PhoshMonitor *monitor)
 {
   PhoshBackground *background;
+  gboolean created = FALSE;
   float scale;
 
   g_return_if_fail (PHOSH_IS_MONITOR (monitor));
@@ -329,7 +360,13 @@ on_monitor_configured (PhoshBackgroundManager *self, PhoshMonitor *monitor)
   if (background == NULL) {
     background = create_background_for_monitor (self, monitor);
     g_hash_table_insert (self->backgrounds, g_object_ref (monitor), background);
-  } else {
+    created = TRUE;
+  }
+
+  if (update_max_size (self)) {
+    /* Cached images got dropped, so all backgrounds need to reload */
+    g_hash_table_foreach (self->backgrounds, update_background, self);
+  } else if (!created) {
     phosh_background_needs_update (background);
   }
 
@@ -32,10 +32,6 @@
 #include <math.h>
 #include <string.h>
 
-#define COLOR_TO_PIXEL(color)     ((((int)(color->red   * 255)) << 24) | \
-                                   (((int)(color->green * 255)) << 16) | \
-                                   (((int)(color->blue  * 255)) << 8)  | \
-                                   (((int)(color->alpha * 255))))
 /**
  * PhoshBackground:
  *
@@ -64,7 +60,8 @@ struct _PhoshBackground
   /* How the background in rendered */
   GDesktopBackgroundStyle  style;
   GdkRGBA                  color;
-  GdkPixbuf               *pixbuf;
+  cairo_surface_t         *surface;
+  cairo_surface_t         *draw_surface; /* surface optimized for the window */
   gboolean                 needs_update;
 
   /* The monitor backed by PhoshBackground */
@@ -122,82 +119,6 @@ phosh_background_get_property (GObject    *object,
 }
 
 
-static GdkPixbuf *
-pb_scale_to_fit (GdkPixbuf *src, int width, int height, GdkRGBA *color)
-{
-  int orig_width, orig_height;
-  int final_width, final_height;
-  int off_x, off_y;
-  double ratio_horiz, ratio_vert, ratio;
-  GdkPixbuf *bg;
-
-  bg = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
-  gdk_pixbuf_fill (bg, COLOR_TO_PIXEL(color));
-
-  orig_width = gdk_pixbuf_get_width (src);
-  orig_height = gdk_pixbuf_get_height (src);
-  ratio_horiz = (double) width / orig_width;
-  ratio_vert = (double) height / orig_height;
-
-  ratio = ratio_horiz > ratio_vert ? ratio_vert : ratio_horiz;
-  final_width = ceil (ratio * orig_width);
-  final_height = ceil (ratio * orig_height);
-
-  off_x = (width - final_width) / 2;
-  off_y = (height - final_height) / 2;
-  gdk_pixbuf_composite (src,
-                        bg,
-                        off_x, off_y, /* dest x,y */
-                        final_width,
-                        final_height,
-                        off_x, off_y, /* offset x, y */
-                        ratio,
-                        ratio,
-                        GDK_INTERP_BILINEAR,
-                        255);
-  return bg;
-}
-
-
-static GdkPixbuf *
-image_background (PhoshBackgroundImage    *image,
-                  guint                    width,
-                  guint                    height,
-                  GDesktopBackgroundStyle  style,
-                  GdkRGBA                 *color)
-{
-  GdkPixbuf *scaled_bg = NULL;;
-
-  if (image == NULL) {
-    g_debug ("No image, using 'none' desktop style");
-    style = G_DESKTOP_BACKGROUND_STYLE_NONE;
-  }
-
-  switch (style) {
-  case G_DESKTOP_BACKGROUND_STYLE_NONE:
-    /* Nothing to do */
-    break;
-  case G_DESKTOP_BACKGROUND_STYLE_SCALED:
-    scaled_bg = pb_scale_to_fit (phosh_background_image_get_pixbuf (image), width, height, color);
-    break;
-  case G_DESKTOP_BACKGROUND_STYLE_WALLPAPER:
-  case G_DESKTOP_BACKGROUND_STYLE_CENTERED:
-  case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
-  case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
-    g_warning ("Unimplemented style %d, using zoom", style);
-    G_GNUC_FALLTHROUGH;
-  case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
-  default:
-    scaled_bg = phosh_utils_pixbuf_scale_to_min (phosh_background_image_get_pixbuf (image),
-                                                 width,
-                                                 height);
-    break;
-  }
-
-  return scaled_bg;
-}
-
-
 static gboolean
 phosh_background_draw (GtkWidget *widget, cairo_t *cr)
 {
@@ -226,8 +147,11 @@ phosh_background_draw (GtkWidget *widget, cairo_t *cr)
     cairo_paint (cr);
   }
 
-  if (self->pixbuf) {
-    gdk_cairo_set_source_pixbuf (cr, self->pixbuf, x, y);
+  if (self->surface) {
+    /* Only convert once so redraws are plain copies */
+    if (self->draw_surface == NULL)
+      self->draw_surface = phosh_util_create_similar_surface (widget, self->surface);
+    cairo_set_source_surface (cr, self->draw_surface, x, y);
     cairo_paint (cr);
   }
 
@@ -237,9 +161,18 @@ phosh_background_draw (GtkWidget *widget, cairo_t *cr)
 }
 
 
+static void on_background_cache_fetch_ready (GObject      *source_object,
+                                             GAsyncResult *res,
+                                             gpointer      data);
+static void on_load_scaled_ready            (GObject      *source_object,
+                                             GAsyncResult *res,
+                                             gpointer      data);
+
 static void
 update_image (PhoshBackground *self)
 {
+  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
+  cairo_surface_t *surface = NULL;
   int width, height;
 
   if (!self->configured)
@@ -254,17 +187,81 @@ update_image (PhoshBackground *self)
 
   g_return_if_fail (width > 0 && height > 0);
 
-  g_debug ("Scaling background %p to %dx%d", self, width, height);
+  g_debug ("Updating background %p for %dx%d", self, width, height);
+
+  if (self->uri && self->style != G_DESKTOP_BACKGROUND_STYLE_NONE) {
+    /* Prefer an already scaled image so we don't need to decode at all */
+    surface = phosh_background_cache_lookup_scaled (cache,
+                                                    self->uri,
+                                                    width,
+                                                    height,
+                                                    self->style,
+                                                    &self->color);
+    if (surface == NULL && self->cached_bg_image == NULL) {
+      /* Keep the current image until the new one is loaded */
+      phosh_background_cache_load_scaled_async (cache,
+                                                self->uri,
+                                                width,
+                                                height,
+                                                self->style,
+                                                &self->color,
+                                                self->cancel_load,
+                                                on_load_scaled_ready,
+                                                self);
+      return;
+    }
+
+    if (surface == NULL) {
+      surface = phosh_background_cache_get_scaled (cache,
+                                                   self->cached_bg_image,
+                                                   width,
+                                                   height,
+                                                   self->style,
+                                                   &self->color);
+    }
+  }
 
-  g_clear_object (&self->pixbuf);
-  self->pixbuf = image_background (self->cached_bg_image, width, height,
-                                   self->style, &self->color);
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  g_clear_pointer (&self->surface, cairo_surface_destroy);
+  self->surface = surface;
 
   self->needs_update = FALSE;
   gtk_widget_queue_draw (GTK_WIDGET (self));
 }
 
 
+static void
+on_load_scaled_ready (GObject *source_object, GAsyncResult *res, gpointer data)
+{
+  g_autoptr (GError) err = NULL;
+  PhoshBackground *self = PHOSH_BACKGROUND (data);
+  PhoshBackgroundCache *cache = PHOSH_BACKGROUND_CACHE (source_object);
+  cairo_surface_t *surface;
+
+  surface = phosh_background_cache_load_scaled_finish (cache, res, &err);
+  if (err) {
+    phosh_async_error_warn (err, "Failed to load scaled background");
+    return;
+  }
+
+  g_assert (PHOSH_IS_BACKGROUND (self));
+
+  if (surface) {
+    /* Now in memory so picked up right away */
+    cairo_surface_destroy (surface);
+    update_image (self);
+    return;
+  }
+
+  /* Not on disk either, need to decode the image */
+  phosh_background_cache_fetch_async (cache,
+                                      self->uri,
+                                      self->cancel_load,
+                                      on_background_cache_fetch_ready,
+                                      self);
+}
+
+
 static void
 on_background_cache_fetch_ready (GObject *source_object, GAsyncResult *res, gpointer data)
 {
@@ -290,7 +287,6 @@ on_background_cache_fetch_ready (GObject *source_object, GAsyncResult *res, gpoi
 static void
 trigger_update (PhoshBackground *self)
 {
-  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
   PhoshBackgroundManager *manager = phosh_shell_get_background_manager (phosh_shell_get_default ());
   g_autoptr (PhoshBackgroundData) bg_data = NULL;
 
@@ -306,16 +302,29 @@ trigger_update (PhoshBackground *self)
   g_clear_object (&self->cancel_load);
   self->cancel_load = g_cancellable_new ();
 
-  if (self->uri) {
-    phosh_background_cache_fetch_async (cache,
-                                        self->uri,
-                                        self->cancel_load,
-                                        on_background_cache_fetch_ready,
-                                        self);
-  } else {
-    g_clear_object (&self->cached_bg_image);
-    update_image (self);
-  }
+  /* The cache might have dropped the image (e.g. due to a file
+   * change) so only ever fetch it from there */
+  g_clear_object (&self->cached_bg_image);
+  update_image (self);
+}
+
+
+static void
+on_scale_factor_changed (PhoshBackground *self, GParamSpec *pspec, gpointer unused)
+{
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+
+static void
+phosh_background_unrealize (GtkWidget *widget)
+{
+  PhoshBackground *self = PHOSH_BACKGROUND (widget);
+
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+
+  GTK_WIDGET_CLASS (phosh_background_parent_class)->unrealize (widget);
 }
 
 
@@ -338,7 +347,8 @@ phosh_background_finalize (GObject *object)
 
   g_cancellable_cancel (self->cancel_load);
   g_clear_object (&self->cancel_load);
-  g_clear_object (&self->pixbuf);
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  g_clear_pointer (&self->surface, cairo_surface_destroy);
   g_clear_object (&self->cached_bg_image);
 
   G_OBJECT_CLASS (phosh_background_parent_class)->finalize (object);
@@ -357,6 +367,7 @@ phosh_background_class_init (PhoshBackgroundClass *klass)
   object_class->get_property = phosh_background_get_property;
 
   widget_class->draw = phosh_background_draw;
+  widget_class->unrealize = phosh_background_unrealize;
 
   layer_surface_class->configured = phosh_background_configured;
 
@@ -384,6 +395,7 @@ phosh_background_class_init (PhoshBackgroundClass *klass)
 static void
 phosh_background_init (PhoshBackground *self)
 {
+  g_signal_connect (self, "notify::scale-factor", G_CALLBACK (on_scale_factor_changed), NULL);
 }
 
 
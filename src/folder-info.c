@@ -8,6 +8,7 @@
 
 #define G_LOG_DOMAIN "phosh-folder-info"
 
+#include "app-list-model.h"
 #include "folder-info.h"
 #include "util.h"
 
@@ -18,6 +19,8 @@
 
 #include <gio/gdesktopappinfo.h>
 
+#include <string.h>
+
 #define FOLDER_SCHEMA_ID "org.gnome.desktop.app-folders.folder"
 #define FOLDERS_PREFIX "/org/gnome/desktop/app-folders/folders"
 
@@ -59,6 +62,8 @@ struct _PhoshFolderInfo {
 
   /* The current search term (only valid during refilter) */
   const char             *search;
+  /* The search term of the last refilter */
+  char                   *last_search;
 };
 
 static void folder_info_iface_init (GAppInfoIface *iface);
@@ -226,6 +231,8 @@ static void
 on_settings_apps_changed (PhoshFolderInfo *self, GSettings *settings, char *key)
 {
   g_signal_emit (self, signals[APPS_CHANGED], 0);
+  /* New apps aren't filtered by the last search term */
+  g_clear_pointer (&self->last_search, g_free);
   g_list_store_remove_all (self->app_infos);
   load_apps (self);
 }
@@ -245,7 +252,7 @@ filter_app (gpointer item, gpointer data)
   if (gm_str_is_null_or_empty (self->search))
     show = !phosh_favorite_list_model_app_is_favorite (self->favorites, app_info);
   else
-    show = phosh_util_matches_app_info (app_info, self->search);
+    show = phosh_app_list_model_matches (phosh_app_list_model_get_default (), app_info, self->search);
 
   return show;
 }
@@ -258,6 +265,7 @@ phosh_folder_info_dispose (GObject *object)
 
   g_clear_pointer (&self->path, g_free);
   g_clear_pointer (&self->name, g_free);
+  g_clear_pointer (&self->last_search, g_free);
   g_clear_object (&self->filtered_app_infos);
   g_clear_object (&self->app_infos);
   g_clear_object (&self->settings);
@@ -370,6 +378,15 @@ phosh_folder_info_new_from_folder_path (char *path)
 }
 
 
+const char *
+phosh_folder_info_get_path (PhoshFolderInfo *self)
+{
+  g_return_val_if_fail (PHOSH_IS_FOLDER_INFO (self), NULL);
+
+  return self->path;
+}
+
+
 char *
 phosh_folder_info_get_name (PhoshFolderInfo *self)
 {
@@ -416,6 +433,33 @@ phosh_folder_info_contains (PhoshFolderInfo *self, GAppInfo *app_info)
 }
 
 
+/**
+ * phosh_folder_info_collect_app_ids:
+ * @self: A folder info
+ * @ids: (element-type utf8 utf8): A set of app ids
+ *
+ * Adds the ids of all apps in this folder to the @ids set. The set
+ * needs to free its keys with `g_free()`.
+ */
+void
+phosh_folder_info_collect_app_ids (PhoshFolderInfo *self, GHashTable *ids)
+{
+  guint n_items;
+
+  g_return_if_fail (PHOSH_IS_FOLDER_INFO (self));
+  g_return_if_fail (ids);
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (self->app_infos));
+  for (guint i = 0; i < n_items; i++) {
+    g_autoptr (GAppInfo) app_info = g_list_model_get_item (G_LIST_MODEL (self->app_infos), i);
+    const char *id = g_app_info_get_id (app_info);
+
+    if (id)
+      g_hash_table_add (ids, g_strdup (id));
+  }
+}
+
+
 gboolean
 phosh_folder_info_refilter (PhoshFolderInfo *self, const char *search)
 {
@@ -423,9 +467,18 @@ phosh_folder_info_refilter (PhoshFolderInfo *self, const char *search)
   g_return_val_if_fail (PHOSH_IS_FOLDER_INFO (self), FALSE);
 
   self->search = search;
-  gtk_filter_list_model_refilter (self->filtered_app_infos);
+  /* A search term containing the last one can only match fewer apps */
+  if (!gm_str_is_null_or_empty (search) && !gm_str_is_null_or_empty (self->last_search) &&
+      strstr (search, self->last_search)) {
+    gtk_filter_list_model_refilter_more_strict (self->filtered_app_infos);
+  } else {
+    gtk_filter_list_model_refilter (self->filtered_app_infos);
+  }
   self->search = NULL;
 
+  g_free (self->last_search);
+  self->last_search = g_strdup (search);
+
   item = g_list_model_get_item (G_LIST_MODEL (self->filtered_app_infos), 0);
   return item != NULL;
 }
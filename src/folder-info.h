@@ -17,10 +17,12 @@ G_DECLARE_FINAL_TYPE (PhoshFolderInfo, phosh_folder_info, PHOSH, FOLDER_INFO, GO
 
 PhoshFolderInfo *phosh_folder_info_new_from_folder_path (char *path);
 
+const char *phosh_folder_info_get_path (PhoshFolderInfo *self);
 char       *phosh_folder_info_get_name (PhoshFolderInfo *self);
 void        phosh_folder_info_set_name (PhoshFolderInfo *self, const char *name);
 GListModel *phosh_folder_info_get_app_infos (PhoshFolderInfo *self);
 gboolean    phosh_folder_info_contains (PhoshFolderInfo *self, GAppInfo *app_info);
+void        phosh_folder_info_collect_app_ids (PhoshFolderInfo *self, GHashTable *ids);
 gboolean    phosh_folder_info_refilter (PhoshFolderInfo *self, const char *search);
 void        phosh_folder_info_add_app_info (PhoshFolderInfo *self, GAppInfo *app_info);
 gboolean    phosh_folder_info_remove_app_info (PhoshFolderInfo *self, GAppInfo *app_info);
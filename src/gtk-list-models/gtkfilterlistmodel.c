@@ -709,3 +709,57 @@ gtk_filter_list_model_refilter (GtkFilterListModel *self)
     }
 }
 
+/**
+ * gtk_filter_list_model_refilter_more_strict:
+ * @self: a #GtkFilterListModel
+ *
+ * Like gtk_filter_list_model_refilter() but only runs the filter
+ * function on the currently visible items. Hidden items are skipped
+ * without being visited so this is O(visible items * log(items)).
+ *
+ * Use this when the filter function changed such that it can only
+ * filter out more items, e.g. when a search term got extended. This
+ * is the equivalent of GTK_FILTER_CHANGE_MORE_STRICT in GTK 4.
+ **/
+void
+gtk_filter_list_model_refilter_more_strict (GtkFilterListModel *self)
+{
+  FilterNode *node;
+  guint position, unfiltered, n_removed;
+  guint first_change, last_change;
+
+  g_return_if_fail (GTK_IS_FILTER_LIST_MODEL (self));
+
+  if (self->items == NULL || self->model == NULL)
+    return;
+
+  /* Positions are in the filtered model before any item got removed */
+  first_change = G_MAXUINT;
+  last_change = 0;
+  n_removed = 0;
+  position = 0;
+  /* Hidden nodes drop out of the augmented counts so the next lookup
+   * at the same position finds the next visible item */
+  while ((node = gtk_filter_list_model_get_nth_filtered (self->items, position, &unfiltered)))
+    {
+      if (gtk_filter_list_model_run_filter (self, unfiltered))
+        {
+          position++;
+          continue;
+        }
+
+      node->visible = FALSE;
+      gtk_rb_tree_node_mark_dirty (node);
+      first_change = MIN (position + n_removed, first_change);
+      last_change = position + n_removed;
+      n_removed++;
+    }
+
+  if (n_removed > 0)
+    {
+      g_list_model_items_changed (G_LIST_MODEL (self),
+                                  first_change,
+                                  last_change - first_change + 1,
+                                  last_change - first_change + 1 - n_removed);
+    }
+}
@@ -68,6 +68,8 @@ gboolean                gtk_filter_list_model_has_filter        (GtkFilterListMo
 
 GDK_AVAILABLE_IN_ALL
 void                    gtk_filter_list_model_refilter          (GtkFilterListModel     *self);
+GDK_AVAILABLE_IN_ALL
+void                    gtk_filter_list_model_refilter_more_strict (GtkFilterListModel  *self);
 
 G_END_DECLS
 
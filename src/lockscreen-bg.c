@@ -10,6 +10,7 @@
 
 #include "phosh-config.h"
 
+#include "background-cache.h"
 #include "shell-priv.h"
 #include "lockscreen-bg.h"
 #include "style-manager.h"
@@ -30,8 +31,10 @@
 struct _PhoshLockscreenBg {
   PhoshLayerSurface     parent;
 
-  GdkPixbuf            *pixbuf;
-  PhoshBackgroundImage *bg_image;
+  cairo_surface_t      *surface;
+  cairo_surface_t      *draw_surface; /* surface optimized for the window */
+  GFile                *file;
+  GCancellable         *cancel;
 
   gboolean              configured;
   gboolean              use_background;
@@ -39,28 +42,122 @@ struct _PhoshLockscreenBg {
 G_DEFINE_TYPE (PhoshLockscreenBg, phosh_lockscreen_bg, PHOSH_TYPE_LAYER_SURFACE)
 
 
+static void
+set_surface (PhoshLockscreenBg *self, cairo_surface_t *surface)
+{
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  g_clear_pointer (&self->surface, cairo_surface_destroy);
+  self->surface = surface;
+
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+
+static void
+on_background_cache_fetch_ready (GObject *source_object, GAsyncResult *res, gpointer data)
+{
+  PhoshBackgroundCache *cache = PHOSH_BACKGROUND_CACHE (source_object);
+  g_autoptr (PhoshBackgroundImage) image = NULL;
+  g_autoptr (GError) err = NULL;
+  PhoshLockscreenBg *self;
+  int width, height;
+
+  image = phosh_background_cache_fetch_finish (cache, res, &err);
+  if (!image) {
+    phosh_async_error_warn (err, "Failed to load background image");
+    return;
+  }
+
+  self = PHOSH_LOCKSCREEN_BG (data);
+  width = phosh_layer_surface_get_configured_width (PHOSH_LAYER_SURFACE (self));
+  height = phosh_layer_surface_get_configured_height (PHOSH_LAYER_SURFACE (self));
+
+  g_debug ("Scaling lockscreen background %p to %dx%d", self, width, height);
+  /* Zoom matches what the backgrounds use so the scaled image can be shared */
+  set_surface (self, phosh_background_cache_get_scaled (cache,
+                                                        image,
+                                                        width,
+                                                        height,
+                                                        G_DESKTOP_BACKGROUND_STYLE_ZOOM,
+                                                        NULL));
+}
+
+
+static void
+on_load_scaled_ready (GObject *source_object, GAsyncResult *res, gpointer data)
+{
+  PhoshBackgroundCache *cache = PHOSH_BACKGROUND_CACHE (source_object);
+  g_autoptr (GError) err = NULL;
+  PhoshLockscreenBg *self;
+  cairo_surface_t *surface;
+
+  surface = phosh_background_cache_load_scaled_finish (cache, res, &err);
+  if (err) {
+    phosh_async_error_warn (err, "Failed to load scaled background");
+    return;
+  }
+
+  self = PHOSH_LOCKSCREEN_BG (data);
+  if (surface) {
+    set_surface (self, surface);
+    return;
+  }
+
+  /* Not scaled yet, need to decode the image */
+  phosh_background_cache_fetch_async (cache,
+                                      self->file,
+                                      self->cancel,
+                                      on_background_cache_fetch_ready,
+                                      self);
+}
+
+
 static void
 update_image (PhoshLockscreenBg *self)
 {
+  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
+  cairo_surface_t *surface;
   int width, height;
 
   if (!self->configured)
     return;
 
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+
+  if (self->file == NULL) {
+    set_surface (self, NULL);
+    return;
+  }
+
   width = phosh_layer_surface_get_configured_width (PHOSH_LAYER_SURFACE (self));
   height = phosh_layer_surface_get_configured_height (PHOSH_LAYER_SURFACE (self));
 
   g_return_if_fail (width > 0 && height > 0);
 
-  g_debug ("Scaling lockscreen background %p to %dx%d", self, width, height);
-
-  g_clear_object (&self->pixbuf);
-  if (self->bg_image) {
-    GdkPixbuf *pixbuf = phosh_background_image_get_pixbuf (self->bg_image);
-    self->pixbuf = phosh_utils_pixbuf_scale_to_min (pixbuf, width, height);
+  /* Zoom matches what the backgrounds use so the scaled image can be shared */
+  surface = phosh_background_cache_lookup_scaled (cache,
+                                                  self->file,
+                                                  width,
+                                                  height,
+                                                  G_DESKTOP_BACKGROUND_STYLE_ZOOM,
+                                                  NULL);
+  if (surface) {
+    set_surface (self, surface);
+    return;
   }
 
-  gtk_widget_queue_draw (GTK_WIDGET (self));
+  /* Keep the current image until the new one is loaded */
+  self->cancel = g_cancellable_new ();
+  phosh_background_cache_load_scaled_async (cache,
+                                            self->file,
+                                            width,
+                                            height,
+                                            G_DESKTOP_BACKGROUND_STYLE_ZOOM,
+                                            NULL,
+                                            self->cancel,
+                                            on_load_scaled_ready,
+                                            self);
 }
 
 
@@ -95,8 +192,11 @@ phosh_lockscreen_bg_draw (GtkWidget *widget, cairo_t *cr)
   height = gtk_widget_get_allocated_height (GTK_WIDGET (self));
   gtk_render_background (context, cr, 0, 0, width, height);
 
-  if (self->pixbuf && self->use_background) {
-    gdk_cairo_set_source_pixbuf (cr, self->pixbuf, x, y);
+  if (self->surface && self->use_background) {
+    /* Only convert once so redraws are plain copies */
+    if (self->draw_surface == NULL)
+      self->draw_surface = phosh_util_create_similar_surface (widget, self->surface);
+    cairo_set_source_surface (cr, self->draw_surface, x, y);
     cairo_paint (cr);
   }
 
@@ -117,13 +217,35 @@ on_theme_name_changed (PhoshLockscreenBg *self, GParamSpec *pspec, PhoshStyleMan
 }
 
 
+static void
+on_scale_factor_changed (PhoshLockscreenBg *self, GParamSpec *pspec, gpointer unused)
+{
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  gtk_widget_queue_draw (GTK_WIDGET (self));
+}
+
+
+static void
+phosh_lockscreen_bg_unrealize (GtkWidget *widget)
+{
+  PhoshLockscreenBg *self = PHOSH_LOCKSCREEN_BG (widget);
+
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+
+  GTK_WIDGET_CLASS (phosh_lockscreen_bg_parent_class)->unrealize (widget);
+}
+
+
 static void
 phosh_lockscreen_bg_finalize (GObject *object)
 {
   PhoshLockscreenBg *self = PHOSH_LOCKSCREEN_BG (object);
 
-  g_clear_object (&self->bg_image);
-  g_clear_object (&self->pixbuf);
+  g_cancellable_cancel (self->cancel);
+  g_clear_object (&self->cancel);
+  g_clear_object (&self->file);
+  g_clear_pointer (&self->draw_surface, cairo_surface_destroy);
+  g_clear_pointer (&self->surface, cairo_surface_destroy);
 
   G_OBJECT_CLASS (phosh_lockscreen_bg_parent_class)->finalize (object);
 }
@@ -139,6 +261,7 @@ phosh_lockscreen_bg_class_init (PhoshLockscreenBgClass *klass)
   object_class->finalize = phosh_lockscreen_bg_finalize;
 
   widget_class->draw = phosh_lockscreen_bg_draw;
+  widget_class->unrealize = phosh_lockscreen_bg_unrealize;
 
   layer_surface_class->configured = phosh_lockscreen_bg_configured;
 
@@ -158,6 +281,7 @@ phosh_lockscreen_bg_init (PhoshLockscreenBg *self)
                            G_CALLBACK (on_theme_name_changed),
                            self,
                            G_CONNECT_SWAPPED);
+  g_signal_connect (self, "notify::scale-factor", G_CALLBACK (on_scale_factor_changed), NULL);
 }
 
 
@@ -179,15 +303,20 @@ phosh_lockscreen_bg_new (struct zwlr_layer_shell_v1 *layer_shell, struct wl_outp
 }
 
 
+/**
+ * phosh_lockscreen_bg_set_file:
+ * @self: The lockscreen background
+ * @file:(nullable): The background image's file
+ *
+ * Sets the image to show. The image is (re)loaded even if the file
+ * didn't change as the cache might have dropped it.
+ */
 void
-phosh_lockscreen_bg_set_image (PhoshLockscreenBg *self, PhoshBackgroundImage *image)
+phosh_lockscreen_bg_set_file (PhoshLockscreenBg *self, GFile *file)
 {
   g_return_if_fail (PHOSH_IS_LOCKSCREEN_BG (self));
-  g_return_if_fail (image == NULL || PHOSH_IS_BACKGROUND_IMAGE (image));
-
-  if (self->bg_image == image)
-    return;
+  g_return_if_fail (file == NULL || G_IS_FILE (file));
 
-  g_set_object (&self->bg_image, image);
+  g_set_object (&self->file, file);
   update_image (self);
 }
@@ -7,9 +7,8 @@
 #pragma once
 
 #include "layersurface-priv.h"
-#include "background-image.h"
 
-#include <glib-object.h>
+#include <gio/gio.h>
 
 G_BEGIN_DECLS
 
@@ -20,7 +19,7 @@ G_DECLARE_FINAL_TYPE (PhoshLockscreenBg, phosh_lockscreen_bg, PHOSH, LOCKSCREEN_
 
 PhoshLockscreenBg *     phosh_lockscreen_bg_new (struct zwlr_layer_shell_v1 *layer_shell,
                                                  struct wl_output           *wl_output);
-void                    phosh_lockscreen_bg_set_image (PhoshLockscreenBg    *self,
-                                                       PhoshBackgroundImage *image);
+void                    phosh_lockscreen_bg_set_file (PhoshLockscreenBg *self,
+                                                      GFile             *file);
 
 G_END_DECLS
@@ -10,7 +10,6 @@
 #define G_LOG_DOMAIN "phosh-lockscreen-manager"
 
 #include "background-cache.h"
-#include "background-image.h"
 #include "lockscreen-manager-priv.h"
 #include "lockscreen-priv.h"
 #include "lockshield.h"
@@ -63,8 +62,6 @@ struct _PhoshLockscreenManager {
   GFile                   *bg_file;
   GFileMonitor            *bg_file_monitor;
   GDesktopBackgroundStyle  bg_style;
-  PhoshBackgroundImage    *cached_bg_image;
-  GCancellable            *bg_load_cancel;
 
   gboolean                 locked;
   gboolean                 locking;
@@ -77,42 +74,11 @@ G_DEFINE_TYPE (PhoshLockscreenManager, phosh_lockscreen_manager, G_TYPE_OBJECT)
 
 
 static void
-on_background_cache_fetch_ready (GObject *source_object, GAsyncResult *res, gpointer data)
+update_background (PhoshLockscreenManager *self)
 {
-  PhoshLockscreenManager *self = PHOSH_LOCKSCREEN_MANAGER (data);
-  PhoshBackgroundCache *cache = PHOSH_BACKGROUND_CACHE (source_object);
-  g_autoptr (PhoshBackgroundImage) image = NULL;
-  g_autoptr (GError) err = NULL;
-
-  image = phosh_background_cache_fetch_finish (cache, res, &err);
-  if (!image) {
-    phosh_async_error_warn (err, "Failed to load background image");
-    return;
-  }
-
-  g_assert (PHOSH_IS_LOCKSCREEN_MANAGER (self));
-  g_assert (PHOSH_IS_BACKGROUND_CACHE (cache));
-
-  g_set_object (&self->cached_bg_image, image);
+  /* The lockscreen looks up the scaled image first and only decodes on a miss */
   if (self->lockscreen)
-    phosh_lockscreen_set_bg_image (self->lockscreen, self->cached_bg_image);
-}
-
-
-static void
-load_background (PhoshLockscreenManager *self)
-{
-  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
-
-  g_cancellable_cancel (self->bg_load_cancel);
-  g_clear_object (&self->bg_load_cancel);
-  self->bg_load_cancel = g_cancellable_new ();
-
-  phosh_background_cache_fetch_async (cache,
-                                      self->bg_file,
-                                      self->bg_load_cancel,
-                                      on_background_cache_fetch_ready,
-                                      self);
+    phosh_lockscreen_set_bg_file (self->lockscreen, self->bg_file);
 }
 
 
@@ -131,7 +97,7 @@ on_file_changed (PhoshLockscreenManager *self,
   g_debug ("Lockscreen bg file %s changed, clearing cache", g_file_peek_path (self->bg_file));
   phosh_background_cache_remove (cache, self->bg_file);
 
-  load_background (self);
+  update_background (self);
 }
 
 
@@ -158,6 +124,18 @@ monitor_bg_file (PhoshLockscreenManager *self)
 }
 
 
+static void
+on_max_size_changed (PhoshLockscreenManager *self)
+{
+  if (!self->bg_file)
+    return;
+
+  /* The cache dropped the image as it was decoded for different outputs */
+  g_debug ("Max background size changed, reloading '%s'", g_file_peek_path (self->bg_file));
+  update_background (self);
+}
+
+
 static void
 on_picture_params_changed (PhoshLockscreenManager *self)
 {
@@ -182,15 +160,14 @@ on_picture_params_changed (PhoshLockscreenManager *self)
     phosh_background_cache_remove (cache, self->bg_file);
   g_clear_object (&self->bg_file);
   g_clear_object (&self->bg_file_monitor);
-  g_clear_object (&self->cached_bg_image);
 
-  if (!file)
-    return;
+  if (file) {
+    g_set_object (&self->bg_file, file);
+    g_debug ("Loading '%s'", g_file_peek_path (self->bg_file));
+    monitor_bg_file (self);
+  }
 
-  g_set_object (&self->bg_file, file);
-  g_debug ("Loading '%s'", g_file_peek_path (self->bg_file));
-  monitor_bg_file (self);
-  load_background (self);
+  update_background (self);
 }
 
 
@@ -326,7 +303,7 @@ lock_primary_monitor (PhoshLockscreenManager *self)
                     "swapped-object-signal::lockscreen-unlock", on_lockscreen_unlock, self,
                     "swapped-object-signal::wakeup-output", on_lockscreen_wakeup_output, self,
                     NULL);
-  phosh_lockscreen_set_bg_image (self->lockscreen, self->cached_bg_image);
+  phosh_lockscreen_set_bg_file (self->lockscreen, self->bg_file);
 
   gtk_widget_set_visible (GTK_WIDGET (self->lockscreen), TRUE);
   /* Old lockscreen gets remove due to `layer_surface_closed` */
@@ -473,13 +450,9 @@ phosh_lockscreen_manager_dispose (GObject *object)
   g_clear_pointer (&self->lockscreen, phosh_cp_widget_destroy);
   g_clear_object (&self->calls_manager);
 
-  g_cancellable_cancel (self->bg_load_cancel);
-  g_clear_object (&self->bg_load_cancel);
-
   g_clear_object (&self->bg_file_monitor);
   g_clear_object (&self->bg_file);
   g_clear_object (&self->bg_settings);
-  g_clear_object (&self->cached_bg_image);
 
   G_OBJECT_CLASS (phosh_lockscreen_manager_parent_class)->dispose (object);
 }
@@ -554,6 +527,11 @@ phosh_lockscreen_manager_init (PhoshLockscreenManager *self)
                     G_CALLBACK (on_picture_params_changed),
                     self,
                     NULL);
+  g_signal_connect_object (phosh_background_cache_get_default (),
+                           "notify::max-size",
+                           G_CALLBACK (on_max_size_changed),
+                           self,
+                           G_CONNECT_SWAPPED);
   on_picture_params_changed (self);
 }
 
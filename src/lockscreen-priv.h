@@ -6,7 +6,6 @@
 
 #pragma once
 
-#include "background-image.h"
 #include "calls-manager.h"
 #include "lockscreen.h"
 
@@ -14,6 +13,6 @@ G_BEGIN_DECLS
 
 GtkWidget *phosh_lockscreen_new (GType lockscreen_type, gpointer layer_shell, gpointer wl_output,
                                  PhoshCallsManager *calls_manager);
-void       phosh_lockscreen_set_bg_image (PhoshLockscreen *self, PhoshBackgroundImage *image);
+void       phosh_lockscreen_set_bg_file (PhoshLockscreen *self, GFile *file);
 
 G_END_DECLS
@@ -1316,17 +1316,17 @@ phosh_lockscreen_set_unlock_status (PhoshLockscreen *self, const char *status)
 }
 
 /**
- * phosh_lockscreen_set_bg_image:
+ * phosh_lockscreen_set_bg_file:
  * @self: The lockscrenn
- * @image: The background image to set
+ * @file:(nullable): The background image's file
  */
 void
-phosh_lockscreen_set_bg_image (PhoshLockscreen *self, PhoshBackgroundImage *image)
+phosh_lockscreen_set_bg_file (PhoshLockscreen *self, GFile *file)
 {
   PhoshLockscreenPrivate *priv = phosh_lockscreen_get_instance_private (self);
 
   g_return_if_fail (PHOSH_IS_LOCKSCREEN (self));
-  g_return_if_fail (image == NULL || PHOSH_IS_BACKGROUND_IMAGE (image));
+  g_return_if_fail (file == NULL || G_IS_FILE (file));
 
-  phosh_lockscreen_bg_set_image (priv->background, image);
+  phosh_lockscreen_bg_set_file (priv->background, file);
 }
@@ -0,0 +1,781 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-media-art-cache"
+
+#include "phosh-config.h"
+
+#include "media-art-cache.h"
+
+#include <gdk/gdk.h>
+#include <gio/gio.h>
+
+#include <errno.h>
+#include <math.h>
+
+/* Upper bound for the memory used by the cached art */
+#define MEM_MAX_BYTES  (4 * 1024 * 1024)
+/* Upper bound for the cached art stored on disk */
+#define DISK_MAX_BYTES (16 * 1024 * 1024)
+
+#define DISK_SUFFIX    ".png"
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (cairo_t, cairo_destroy)
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (cairo_surface_t, cairo_surface_destroy)
+
+/**
+ * PhoshMediaArtCache:
+ *
+ * A cache of album art
+ *
+ * Media players tend to re-emit identical metadata frequently and the
+ * same art is shown in several media player widgets (e.g. in the
+ * quick settings and on the lock screen). The cache hence stores the
+ * art already squared, scaled and with rounded corners so it only
+ * needs to be fetched, decoded and processed once.
+ *
+ * Entries are keyed by the art's URL and the requested size. For
+ * `file://` URLs the file's modification time and size are part of the
+ * key too as players often reuse the same file for different
+ * tracks. `data:` URLs are keyed by a hash of their contents. Entries
+ * are evicted in least recently used order once they exceed
+ * `MEM_MAX_BYTES`.
+ *
+ * Art from files and the network is also stored as PNG in
+ * `$XDG_CACHE_HOME/phosh/media-art` so it's available right away on the
+ * next start.
+ *
+ * As building the key of `file://` URLs and loading from disk block,
+ * lookups and storing happen in a thread. Art from other URLs can also
+ * be looked up in memory right away.
+ */
+
+typedef struct {
+  char      *key;
+  GdkPixbuf *pixbuf;
+  gsize      size;
+} ArtEntry;
+
+
+typedef struct {
+  char      *url;
+  int        size;
+  GdkPixbuf *pixbuf;
+} ArtTaskData;
+
+
+struct _PhoshMediaArtCache {
+  GObject     parent;
+
+  /* Protects the in memory cache as it's accessed from threads */
+  GMutex      lock;
+  GHashTable *art;       /* key: checksum, value: GList link in art_lru */
+  GQueue      art_lru;   /* ArtEntry, most recently used first */
+  gsize       art_bytes;
+
+  char       *disk_dir;
+};
+G_DEFINE_TYPE (PhoshMediaArtCache, phosh_media_art_cache, G_TYPE_OBJECT)
+
+
+static void
+art_entry_free (ArtEntry *entry)
+{
+  g_free (entry->key);
+  g_clear_object (&entry->pixbuf);
+  g_free (entry);
+}
+
+
+static void
+drop_art_link (PhoshMediaArtCache *self, GList *link)
+{
+  ArtEntry *entry = link->data;
+
+  g_hash_table_remove (self->art, entry->key);
+  g_queue_delete_link (&self->art_lru, link);
+  self->art_bytes -= entry->size;
+  art_entry_free (entry);
+}
+
+
+static void
+evict_art (PhoshMediaArtCache *self)
+{
+  /* Always keep the most recently used one */
+  while (self->art_bytes > MEM_MAX_BYTES && self->art_lru.length > 1)
+    drop_art_link (self, self->art_lru.tail);
+}
+
+
+static void
+art_task_data_free (ArtTaskData *data)
+{
+  g_free (data->url);
+  g_clear_object (&data->pixbuf);
+  g_free (data);
+}
+
+
+static gboolean
+is_cacheable (const char *url)
+{
+  const char *scheme = g_uri_peek_scheme (url);
+
+  return (g_strcmp0 (scheme, "file") == 0 ||
+          g_strcmp0 (scheme, "http") == 0 ||
+          g_strcmp0 (scheme, "https") == 0 ||
+          g_strcmp0 (scheme, "data") == 0);
+}
+
+
+/*
+ * Build the cache key for URLs that don't need any I/O for that.
+ * Returns %NULL for all other URLs.
+ */
+static char *
+get_url_key (const char *url, int size, gboolean *on_disk)
+{
+  const char *scheme = g_uri_peek_scheme (url);
+  g_autofree char *id = NULL;
+
+  *on_disk = FALSE;
+
+  if (g_strcmp0 (scheme, "http") == 0 || g_strcmp0 (scheme, "https") == 0) {
+    id = g_strdup_printf ("%s|%d", url, size);
+    *on_disk = TRUE;
+  } else if (g_strcmp0 (scheme, "data") == 0) {
+    /* Cheap to decode, no need to store on disk */
+    id = g_strdup_printf ("%s|%d", url, size);
+  } else {
+    return NULL;
+  }
+
+  return g_compute_checksum_for_string (G_CHECKSUM_SHA256, id, -1);
+}
+
+
+/*
+ * Build the cache key for the given url. Returns %NULL if the art
+ * can't be cached. @on_disk is set when the art should be stored on
+ * disk as well. Might block so only invoke in a thread.
+ */
+static char *
+get_key (const char *url, int size, gboolean *on_disk)
+{
+  const char *scheme = g_uri_peek_scheme (url);
+  g_autofree char *id = NULL;
+
+  *on_disk = FALSE;
+
+  if (g_strcmp0 (scheme, "file") == 0) {
+    g_autoptr (GFile) file = g_file_new_for_uri (url);
+    g_autoptr (GFileInfo) info = NULL;
+
+    info = g_file_query_info (file,
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED ","
+                              G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC ","
+                              G_FILE_ATTRIBUTE_STANDARD_SIZE,
+                              G_FILE_QUERY_INFO_NONE,
+                              NULL,
+                              NULL);
+    if (info == NULL)
+      return NULL;
+
+    id = g_strdup_printf ("%s|%" G_GUINT64_FORMAT ".%u|%" G_GOFFSET_FORMAT "|%d",
+                          url,
+                          g_file_info_get_attribute_uint64 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED),
+                          g_file_info_get_attribute_uint32 (info, G_FILE_ATTRIBUTE_TIME_MODIFIED_USEC),
+                          g_file_info_get_size (info),
+                          size);
+    *on_disk = TRUE;
+  } else {
+    return get_url_key (url, size, on_disk);
+  }
+
+  return g_compute_checksum_for_string (G_CHECKSUM_SHA256, id, -1);
+}
+
+
+static char *
+get_disk_path (PhoshMediaArtCache *self, const char *key)
+{
+  g_autofree char *name = g_strconcat (key, DISK_SUFFIX, NULL);
+
+  return g_build_filename (self->disk_dir, name, NULL);
+}
+
+
+static int
+cmp_mtime (gconstpointer a, gconstpointer b)
+{
+  GFileInfo *info_a = *(GFileInfo **) a;
+  GFileInfo *info_b = *(GFileInfo **) b;
+  guint64 mtime_a, mtime_b;
+
+  mtime_a = g_file_info_get_attribute_uint64 (info_a, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+  mtime_b = g_file_info_get_attribute_uint64 (info_b, G_FILE_ATTRIBUTE_TIME_MODIFIED);
+
+  return (mtime_a > mtime_b) - (mtime_a < mtime_b);
+}
+
+
+/* Drop the oldest files until we're within the budget. Runs in a thread. */
+static void
+prune_disk (const char *path)
+{
+  g_autoptr (GFile) dir = g_file_new_for_path (path);
+  g_autoptr (GFileEnumerator) enumerator = NULL;
+  g_autoptr (GPtrArray) infos = g_ptr_array_new_with_free_func (g_object_unref);
+  g_autoptr (GError) err = NULL;
+  goffset total = 0;
+  GFileInfo *info;
+
+  enumerator = g_file_enumerate_children (dir,
+                                          G_FILE_ATTRIBUTE_STANDARD_NAME ","
+                                          G_FILE_ATTRIBUTE_STANDARD_SIZE ","
+                                          G_FILE_ATTRIBUTE_TIME_MODIFIED,
+                                          G_FILE_QUERY_INFO_NOFOLLOW_SYMLINKS,
+                                          NULL,
+                                          &err);
+  if (enumerator == NULL) {
+    g_warning ("Failed to list %s: %s", path, err->message);
+    return;
+  }
+
+  while ((info = g_file_enumerator_next_file (enumerator, NULL, NULL))) {
+    if (!g_str_has_suffix (g_file_info_get_name (info), DISK_SUFFIX)) {
+      g_object_unref (info);
+      continue;
+    }
+    total += g_file_info_get_size (info);
+    g_ptr_array_add (infos, info);
+  }
+
+  if (total <= DISK_MAX_BYTES)
+    return;
+
+  g_ptr_array_sort (infos, cmp_mtime);
+  for (guint i = 0; i < infos->len && total > DISK_MAX_BYTES; i++) {
+    g_autoptr (GFile) file = NULL;
+
+    info = g_ptr_array_index (infos, i);
+    file = g_file_get_child (dir, g_file_info_get_name (info));
+    g_debug ("Pruning %s from media art cache", g_file_info_get_name (info));
+    if (g_file_delete (file, NULL, NULL))
+      total -= g_file_info_get_size (info);
+  }
+}
+
+
+/* Runs in a thread */
+static gboolean
+save_to_disk (const char *dir, const char *path, GdkPixbuf *pixbuf, GError **err)
+{
+  g_autofree char *buffer = NULL;
+  gsize len;
+
+  if (g_mkdir_with_parents (dir, 0700) < 0) {
+    g_set_error (err, G_IO_ERROR, g_io_error_from_errno (errno),
+                 "Failed to create %s: %s", dir, g_strerror (errno));
+    return FALSE;
+  }
+
+  /* g_file_set_contents () writes to a temporary file first so readers never see partial data */
+  if (!gdk_pixbuf_save_to_buffer (pixbuf, &buffer, &len, "png", err, NULL) ||
+      !g_file_set_contents (path, buffer, len, err)) {
+    return FALSE;
+  }
+
+  prune_disk (dir);
+
+  return TRUE;
+}
+
+
+static GdkPixbuf *
+load_from_disk (const char *path, int size)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+
+  pixbuf = gdk_pixbuf_new_from_file (path, &err);
+  if (pixbuf == NULL) {
+    if (!g_error_matches (err, G_FILE_ERROR, G_FILE_ERROR_NOENT))
+      g_debug ("Failed to load %s: %s", path, err->message);
+    return NULL;
+  }
+
+  if (gdk_pixbuf_get_width (pixbuf) != size || gdk_pixbuf_get_height (pixbuf) != size) {
+    g_debug ("Ignoring %s with unexpected size", path);
+    return NULL;
+  }
+
+  return g_steal_pointer (&pixbuf);
+}
+
+
+/* Needs to be invoked with the lock held */
+static GdkPixbuf *
+insert_art (PhoshMediaArtCache *self, const char *key, GdkPixbuf *pixbuf)
+{
+  ArtEntry *entry;
+  GList *link;
+
+  link = g_hash_table_lookup (self->art, key);
+  if (link)
+    drop_art_link (self, link);
+
+  entry = g_new0 (ArtEntry, 1);
+  entry->key = g_strdup (key);
+  entry->pixbuf = g_object_ref (pixbuf);
+  entry->size = gdk_pixbuf_get_byte_length (pixbuf);
+
+  g_queue_push_head (&self->art_lru, entry);
+  g_hash_table_insert (self->art, entry->key, self->art_lru.head);
+  self->art_bytes += entry->size;
+
+  evict_art (self);
+
+  return g_object_ref (pixbuf);
+}
+
+
+/* Takes the lock, invoke without holding it */
+static GdkPixbuf *
+lookup_memory (PhoshMediaArtCache *self, const char *key)
+{
+  GdkPixbuf *pixbuf = NULL;
+  GList *link;
+
+  g_mutex_lock (&self->lock);
+  link = g_hash_table_lookup (self->art, key);
+  if (link) {
+    ArtEntry *entry = link->data;
+
+    g_queue_unlink (&self->art_lru, link);
+    g_queue_push_head_link (&self->art_lru, link);
+    pixbuf = g_object_ref (entry->pixbuf);
+  }
+  g_mutex_unlock (&self->lock);
+
+  return pixbuf;
+}
+
+
+static void
+lookup_thread (GTask        *task,
+               gpointer      source_object,
+               gpointer      task_data,
+               GCancellable *cancel)
+{
+  PhoshMediaArtCache *self = PHOSH_MEDIA_ART_CACHE (source_object);
+  ArtTaskData *data = task_data;
+  g_autofree char *key = NULL;
+  g_autofree char *path = NULL;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  gboolean on_disk;
+
+  key = get_key (data->url, data->size, &on_disk);
+  if (key == NULL) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  pixbuf = lookup_memory (self, key);
+  if (pixbuf) {
+    g_debug ("Media art cache hit for %.64s at %d", data->url, data->size);
+    g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+    return;
+  }
+
+  if (!on_disk) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  path = get_disk_path (self, key);
+  pixbuf = load_from_disk (path, data->size);
+  if (pixbuf == NULL) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  g_debug ("Media art disk cache hit for %.64s at %d", data->url, data->size);
+  g_mutex_lock (&self->lock);
+  g_object_unref (insert_art (self, key, pixbuf));
+  g_mutex_unlock (&self->lock);
+
+  g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+
+static void
+store_thread (GTask        *task,
+              gpointer      source_object,
+              gpointer      task_data,
+              GCancellable *cancel)
+{
+  PhoshMediaArtCache *self = PHOSH_MEDIA_ART_CACHE (source_object);
+  ArtTaskData *data = task_data;
+  g_autofree char *key = NULL;
+  g_autofree char *path = NULL;
+  GError *err = NULL;
+  gboolean on_disk;
+
+  key = get_key (data->url, data->size, &on_disk);
+  if (key == NULL) {
+    g_task_return_boolean (task, TRUE);
+    return;
+  }
+
+  g_mutex_lock (&self->lock);
+  g_object_unref (insert_art (self, key, data->pixbuf));
+  g_mutex_unlock (&self->lock);
+
+  if (!on_disk) {
+    g_task_return_boolean (task, TRUE);
+    return;
+  }
+
+  path = get_disk_path (self, key);
+  if (!save_to_disk (self->disk_dir, path, data->pixbuf, &err)) {
+    g_task_return_error (task, err);
+    return;
+  }
+
+  g_task_return_boolean (task, TRUE);
+}
+
+
+static void
+on_store_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  g_autoptr (GError) err = NULL;
+
+  if (!g_task_propagate_boolean (G_TASK (res), &err))
+    g_warning ("Failed to store media art: %s", err->message);
+}
+
+
+static GdkPixbuf *
+center_pixbuf (GdkPixbuf *pixbuf)
+{
+  int width, height, size;
+  g_autoptr (cairo_t) cr = NULL;
+  g_autoptr (cairo_surface_t) surface = NULL;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  if (width == height)
+    return g_object_ref (pixbuf);
+
+  size = MAX (width, height);
+  /* gdk_pixbuf_copy_area would work as well but that goes via gdk_pixbuf_scale, …*/
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
+  cr = cairo_create (surface);
+  if (width > height)
+    gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, (width - height) / 2.0);
+  else
+    gdk_cairo_set_source_pixbuf (cr, pixbuf, (height - width) / 2.0, 0);
+  cairo_paint (cr);
+
+  return gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
+}
+
+
+static GdkPixbuf *
+round_corners (GdkPixbuf *pixbuf)
+{
+  g_autoptr (cairo_t) cr = NULL;
+  g_autoptr (cairo_surface_t) surface = NULL;
+  int width, height, size;
+  double radius;
+  const double degrees = M_PI / 180.0;
+
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+
+  width = gdk_pixbuf_get_width (pixbuf);
+  height = gdk_pixbuf_get_height (pixbuf);
+
+  /* We only round square images */
+  g_return_val_if_fail (width == height, NULL);
+
+  size = width;
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
+  cr = cairo_create (surface);
+
+  radius = size / 8.0;
+  cairo_new_path (cr);
+  cairo_arc (cr, size - radius, radius, radius, -90 * degrees, 0 * degrees);
+  cairo_arc (cr, size - radius, size - radius, radius, 0 * degrees, 90 * degrees);
+  cairo_arc (cr, radius, size - radius, radius, 90 * degrees, 180 * degrees);
+  cairo_arc (cr, radius, radius, radius, 180 * degrees, 270 * degrees);
+  cairo_close_path (cr);
+  cairo_clip (cr);
+
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+  cairo_paint (cr);
+
+  return gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
+}
+
+
+static void
+phosh_media_art_cache_finalize (GObject *object)
+{
+  PhoshMediaArtCache *self = PHOSH_MEDIA_ART_CACHE (object);
+
+  g_queue_clear_full (&self->art_lru, (GDestroyNotify) art_entry_free);
+  g_clear_pointer (&self->art, g_hash_table_destroy);
+  g_clear_pointer (&self->disk_dir, g_free);
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (phosh_media_art_cache_parent_class)->finalize (object);
+}
+
+
+static void
+phosh_media_art_cache_class_init (PhoshMediaArtCacheClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = phosh_media_art_cache_finalize;
+}
+
+
+static void
+phosh_media_art_cache_init (PhoshMediaArtCache *self)
+{
+  g_mutex_init (&self->lock);
+  self->art = g_hash_table_new (g_str_hash, g_str_equal);
+  g_queue_init (&self->art_lru);
+  self->disk_dir = g_build_filename (g_get_user_cache_dir (), "phosh", "media-art", NULL);
+}
+
+/**
+ * phosh_media_art_cache_get_default:
+ *
+ * Gets the media art cache singleton.
+ *
+ * Returns:(transfer none): The media art cache singleton.
+ */
+PhoshMediaArtCache *
+phosh_media_art_cache_get_default (void)
+{
+  static PhoshMediaArtCache *instance;
+
+  if (instance == NULL) {
+    g_debug ("Creating media art cache");
+    instance = g_object_new (PHOSH_TYPE_MEDIA_ART_CACHE, NULL);
+    g_object_add_weak_pointer (G_OBJECT (instance), (gpointer *)&instance);
+  }
+  return instance;
+}
+
+/**
+ * phosh_media_art_cache_lookup:
+ * @self: The media art cache
+ * @url: The art's URL
+ * @size: The size in pixels
+ *
+ * Looks up processed art in memory without blocking. As checking
+ * whether a file changed needs I/O art from `file://` URLs is never
+ * found this way, use [method@MediaArtCache.lookup_async] for these.
+ *
+ * Returns:(transfer full)(nullable): The art or %NULL if not in memory
+ */
+GdkPixbuf *
+phosh_media_art_cache_lookup (PhoshMediaArtCache *self, const char *url, int size)
+{
+  g_autofree char *key = NULL;
+  gboolean on_disk;
+  GdkPixbuf *pixbuf;
+
+  g_return_val_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self), NULL);
+  g_return_val_if_fail (url, NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  key = get_url_key (url, size, &on_disk);
+  if (key == NULL)
+    return NULL;
+
+  pixbuf = lookup_memory (self, key);
+  if (pixbuf)
+    g_debug ("Media art cache hit for %.64s at %d", url, size);
+
+  return pixbuf;
+}
+
+/**
+ * phosh_media_art_cache_lookup_async:
+ * @self: The media art cache
+ * @url: The art's URL
+ * @size: The size in pixels
+ * @cancellable: (nullable): A cancellable
+ * @callback: The callback to invoke when done
+ * @user_data: The user data for the callback
+ *
+ * Looks up processed art in memory and on disk.
+ */
+void
+phosh_media_art_cache_lookup_async (PhoshMediaArtCache  *self,
+                                    const char          *url,
+                                    int                  size,
+                                    GCancellable        *cancellable,
+                                    GAsyncReadyCallback  callback,
+                                    gpointer             user_data)
+{
+  g_autoptr (GTask) task = NULL;
+  ArtTaskData *data;
+
+  g_return_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self));
+  g_return_if_fail (url);
+  g_return_if_fail (size > 0);
+
+  task = g_task_new (self, cancellable, callback, user_data);
+  g_task_set_source_tag (task, phosh_media_art_cache_lookup_async);
+
+  if (!is_cacheable (url)) {
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  data = g_new0 (ArtTaskData, 1);
+  data->url = g_strdup (url);
+  data->size = size;
+  g_task_set_task_data (task, data, (GDestroyNotify) art_task_data_free);
+  g_task_run_in_thread (task, lookup_thread);
+}
+
+/**
+ * phosh_media_art_cache_lookup_finish:
+ * @self: The media art cache
+ * @res: The async result
+ * @error: The return location for an error
+ *
+ * Finishes looking up art. A cache miss isn't an error.
+ *
+ * Returns:(transfer full)(nullable): The art or %NULL if not in the cache
+ */
+GdkPixbuf *
+phosh_media_art_cache_lookup_finish (PhoshMediaArtCache  *self,
+                                     GAsyncResult        *res,
+                                     GError             **error)
+{
+  g_return_val_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self), NULL);
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), error);
+}
+
+/**
+ * phosh_media_art_cache_add:
+ * @self: The media art cache
+ * @url: The art's URL
+ * @size: The size in pixels
+ * @pixbuf: The art as loaded from @url
+ * @cancellable: (nullable): A cancellable
+ * @callback: (nullable): The callback to invoke once the art is stored
+ * @user_data: The user data for the callback
+ *
+ * Squares the given art, scales it to @size and rounds its corners. The
+ * result is added to the cache in a thread if @url can be cached. Use
+ * [method@MediaArtCache.add_finish] in @callback to find out whether
+ * storing succeeded. Without @callback failures are only logged.
+ *
+ * Returns:(transfer full): The processed art
+ */
+GdkPixbuf *
+phosh_media_art_cache_add (PhoshMediaArtCache  *self,
+                           const char          *url,
+                           int                  size,
+                           GdkPixbuf           *pixbuf,
+                           GCancellable        *cancellable,
+                           GAsyncReadyCallback  callback,
+                           gpointer             user_data)
+{
+  g_autoptr (GdkPixbuf) centered = NULL;
+  g_autoptr (GdkPixbuf) rounded = NULL;
+  g_autoptr (GTask) task = NULL;
+  ArtTaskData *data;
+
+  g_return_val_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self), NULL);
+  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
+  g_return_val_if_fail (size > 0, NULL);
+
+  centered = center_pixbuf (pixbuf);
+  if (gdk_pixbuf_get_width (centered) != size) {
+    GdkPixbuf *scaled = gdk_pixbuf_scale_simple (centered, size, size, GDK_INTERP_BILINEAR);
+
+    g_object_unref (centered);
+    centered = scaled;
+  }
+  rounded = round_corners (centered);
+
+  task = g_task_new (self, cancellable, callback ?: on_store_ready, user_data);
+  g_task_set_source_tag (task, phosh_media_art_cache_add);
+
+  if (url == NULL || !is_cacheable (url)) {
+    g_task_return_boolean (task, TRUE);
+    return g_steal_pointer (&rounded);
+  }
+
+  data = g_new0 (ArtTaskData, 1);
+  data->url = g_strdup (url);
+  data->size = size;
+  data->pixbuf = g_object_ref (rounded);
+
+  g_task_set_task_data (task, data, (GDestroyNotify) art_task_data_free);
+  g_task_run_in_thread (task, store_thread);
+
+  return g_steal_pointer (&rounded);
+}
+
+/**
+ * phosh_media_art_cache_add_finish:
+ * @self: The media art cache
+ * @res: The async result
+ * @error: The return location for an error
+ *
+ * Finishes storing art. Art that can't be cached isn't an error.
+ *
+ * Returns: %TRUE if the art was stored, otherwise %FALSE
+ */
+gboolean
+phosh_media_art_cache_add_finish (PhoshMediaArtCache  *self,
+                                  GAsyncResult        *res,
+                                  GError             **error)
+{
+  g_return_val_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self), FALSE);
+  g_return_val_if_fail (g_task_is_valid (res, self), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (res), error);
+}
+
+/**
+ * phosh_media_art_cache_clear:
+ * @self: The media art cache
+ *
+ * Drops all art from memory. Art stored on disk is kept.
+ */
+void
+phosh_media_art_cache_clear (PhoshMediaArtCache *self)
+{
+  g_return_if_fail (PHOSH_IS_MEDIA_ART_CACHE (self));
+
+  g_mutex_lock (&self->lock);
+  g_queue_clear_full (&self->art_lru, (GDestroyNotify) art_entry_free);
+  g_hash_table_remove_all (self->art);
+  self->art_bytes = 0;
+  g_mutex_unlock (&self->lock);
+}
@@ -0,0 +1,43 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#pragma once
+
+#include <gio/gio.h>
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+G_BEGIN_DECLS
+
+#define PHOSH_TYPE_MEDIA_ART_CACHE (phosh_media_art_cache_get_type ())
+
+G_DECLARE_FINAL_TYPE (PhoshMediaArtCache, phosh_media_art_cache, PHOSH, MEDIA_ART_CACHE, GObject)
+
+PhoshMediaArtCache *phosh_media_art_cache_get_default   (void);
+GdkPixbuf          *phosh_media_art_cache_lookup        (PhoshMediaArtCache  *self,
+                                                         const char          *url,
+                                                         int                  size);
+void                phosh_media_art_cache_lookup_async  (PhoshMediaArtCache  *self,
+                                                         const char          *url,
+                                                         int                  size,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+GdkPixbuf          *phosh_media_art_cache_lookup_finish (PhoshMediaArtCache  *self,
+                                                         GAsyncResult        *res,
+                                                         GError             **error);
+GdkPixbuf          *phosh_media_art_cache_add           (PhoshMediaArtCache  *self,
+                                                         const char          *url,
+                                                         int                  size,
+                                                         GdkPixbuf           *pixbuf,
+                                                         GCancellable        *cancellable,
+                                                         GAsyncReadyCallback  callback,
+                                                         gpointer             user_data);
+gboolean            phosh_media_art_cache_add_finish    (PhoshMediaArtCache  *self,
+                                                         GAsyncResult        *res,
+                                                         GError             **error);
+void                phosh_media_art_cache_clear         (PhoshMediaArtCache  *self);
+
+G_END_DECLS
@@ -11,6 +11,7 @@
 
 #include "phosh-config.h"
 
+#include "media-art-cache.h"
 #include "mpris-dbus.h"
 #include "mpris-manager.h"
 #include "media-player.h"
@@ -28,9 +29,8 @@
 #define SEEK_SECOND 1000000
 #define SEEK_BACK (-10 * SEEK_SECOND)
 #define SEEK_FORWARD (30 * SEEK_SECOND)
-
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (cairo_t, cairo_destroy)
-G_DEFINE_AUTOPTR_CLEANUP_FUNC (cairo_surface_t, cairo_surface_destroy)
+/* How often to check the extrapolated position against the player's */
+#define DRIFT_CHECK_INTERVAL 30 /* seconds */
 
 /**
  * PhoshMediaPlayer:
@@ -45,6 +45,11 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC (cairo_surface_t, cairo_surface_destroy)
  * property is set to %TRUE. This can e.g. be used with
  * #g_object_bind_property() to toggle the widget's visibility.
  *
+ * The track position isn't polled from the player. It's extrapolated
+ * from the last known position using the playback status and rate
+ * and only synced on seeks, track changes and occasionally to correct
+ * drift. The position is only updated while the widget is mapped.
+ *
  * # Example
  *
  * |[
@@ -95,7 +100,13 @@ typedef struct _PhoshMediaPlayerPrivate {
   gboolean                     playable;
   gint64                       track_length;
   gint64                       track_position;
-  guint                        pos_poller_id;
+
+  /* Position model: Position at pos_base_time (monotonic) advancing at rate */
+  gint64                       pos_base;
+  gint64                       pos_base_time;
+  double                       rate;
+  guint                        pos_tick_id;
+  guint                        drift_check_id;
 } PhoshMediaPlayerPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (PhoshMediaPlayer, phosh_media_player, GTK_TYPE_GRID);
@@ -155,6 +166,26 @@ set_attached (PhoshMediaPlayer *self, gboolean attached)
 }
 
 
+static gint64
+get_position (PhoshMediaPlayer *self)
+{
+  PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
+  gint64 position;
+
+  if (priv->pos_base < 0)
+    return -1;
+
+  if (priv->status != PHOSH_MEDIA_PLAYER_STATUS_PLAYING)
+    return priv->pos_base;
+
+  position = priv->pos_base + (g_get_monotonic_time () - priv->pos_base_time) * priv->rate;
+  if (priv->track_length > 0)
+    position = CLAMP (position, 0, priv->track_length);
+
+  return position;
+}
+
+
 static void
 update_position (PhoshMediaPlayer *self)
 {
@@ -162,6 +193,8 @@ update_position (PhoshMediaPlayer *self)
   g_autofree char *position_text = NULL;
   double level;
 
+  priv->track_position = get_position (self);
+
   if (priv->track_position >= 0)
     position_text = cui_call_format_duration ((double) priv->track_position / G_USEC_PER_SEC);
 
@@ -173,21 +206,53 @@ update_position (PhoshMediaPlayer *self)
 
 
 static void
-stop_pos_poller (PhoshMediaPlayer *self)
+stop_pos_tracking (PhoshMediaPlayer *self)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
 
-  if (priv->pos_poller_id <= 0)
+  if (priv->pos_tick_id == 0 && priv->drift_check_id == 0)
     return;
 
-  g_debug ("Stopping position poller");
-  g_source_remove (priv->pos_poller_id);
-  priv->pos_poller_id = 0;
+  g_debug ("Stopping position tracking");
+  g_clear_handle_id (&priv->pos_tick_id, g_source_remove);
+  g_clear_handle_id (&priv->drift_check_id, g_source_remove);
+}
+
+
+static void update_pos_tracking (PhoshMediaPlayer *self);
+
+
+static gboolean
+on_pos_tick (gpointer data)
+{
+  PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (data);
+  PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
+
+  priv->pos_tick_id = 0;
+  update_position (self);
+  update_pos_tracking (self);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
+set_position (PhoshMediaPlayer *self, gint64 position)
+{
+  PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
+
+  priv->pos_base = position;
+  priv->pos_base_time = g_get_monotonic_time ();
+
+  /* Position changed, reschedule the next update */
+  g_clear_handle_id (&priv->pos_tick_id, g_source_remove);
+  update_position (self);
+  update_pos_tracking (self);
 }
 
 
 static void
-on_poll_position_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
+on_sync_position_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
 {
   GDBusProxy *proxy = G_DBUS_PROXY (source_object);
   PhoshMediaPlayer *self;
@@ -205,70 +270,137 @@ on_poll_position_done (GObject *source_object, GAsyncResult *res, gpointer user_
 
   if (var) {
     g_autoptr (GVariant) var2 = NULL;
+    gint64 position;
 
     /* Return variant has type "(v)" where v has type x (i.e. gint64) */
     g_variant_get_child (var, 0, "v", &var2);
-    priv->track_position = g_variant_get_int64 (var2);
-    g_debug ("MPRIS Position: %" G_GINT64_FORMAT, priv->track_position);
+    position = g_variant_get_int64 (var2);
+    g_debug ("MPRIS Position: %" G_GINT64_FORMAT ", drift: %" G_GINT64_FORMAT,
+             position, priv->pos_base >= 0 ? get_position (self) - position : 0);
+    set_position (self, position);
   } else {
     g_warning ("Could not get Position from MPRIS player, hiding box_pos_len: %s", err->message);
-    priv->track_position = -1;
+    priv->pos_base = -1;
     gtk_widget_set_visible (priv->box_pos_len, FALSE);
-    stop_pos_poller (self);
+    stop_pos_tracking (self);
+    update_position (self);
   }
-
-  update_position (self);
 }
 
 
-static gboolean
-poll_position (PhoshMediaPlayer *self)
+static void
+sync_position (PhoshMediaPlayer *self)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
 
-  g_return_val_if_fail (PHOSH_IS_MEDIA_PLAYER (self), G_SOURCE_CONTINUE);
+  g_return_if_fail (PHOSH_IS_MEDIA_PLAYER (self));
 
   if (!priv->attached || priv->player == NULL) {
     g_debug ("No MPRIS player attached");
-    priv->pos_poller_id = 0;
-    return G_SOURCE_REMOVE;
+    return;
   }
 
-  if (!gtk_widget_is_visible (priv->lbl_position)) {
-    g_debug ("Widget hidden, not updating Position");
-    return G_SOURCE_CONTINUE;
+  /* No need to know the position if we can't show it */
+  if (!gtk_widget_get_visible (priv->box_pos_len) || !gtk_widget_get_mapped (GTK_WIDGET (self))) {
+    g_debug ("Widget hidden, not syncing Position");
+    return;
   }
 
   g_dbus_proxy_call (G_DBUS_PROXY (priv->player),
                      "org.freedesktop.DBus.Properties.Get",
                      g_variant_new ("(ss)", "org.mpris.MediaPlayer2.Player", "Position"),
                      G_DBUS_CALL_FLAGS_NONE, -1, priv->cancel,
-                     on_poll_position_done, self);
+                     on_sync_position_done, self);
+}
+
+
+static gboolean
+on_drift_check (gpointer data)
+{
+  PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (data);
+
+  sync_position (self);
 
   return G_SOURCE_CONTINUE;
 }
 
 
-#define POLLER_INTERVAL 1 /* seconds */
+/**
+ * update_pos_tracking:
+ * @self: The media player
+ *
+ * Starts or stops updating the position depending on whether it's
+ * visible and advancing. The position label only changes once a
+ * second so schedule the next update for the next full second of
+ * the track.
+ */
 static void
-start_pos_poller (PhoshMediaPlayer *self)
+update_pos_tracking (PhoshMediaPlayer *self)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
-
-  if (!gtk_widget_get_visible (priv->box_pos_len)) {
-    g_debug ("box_pos_len not visible, not starting position poller");
+  gint64 position, timeout;
+
+  if (!priv->attached ||
+      priv->status != PHOSH_MEDIA_PLAYER_STATUS_PLAYING ||
+      priv->pos_base < 0 ||
+      !gtk_widget_get_visible (priv->box_pos_len) ||
+      !gtk_widget_get_mapped (GTK_WIDGET (self))) {
+    stop_pos_tracking (self);
     return;
   }
-  if (priv->pos_poller_id != 0) {
-    g_debug ("Position poller already running");
-    return;
+
+  if (priv->drift_check_id == 0) {
+    g_debug ("Starting position tracking");
+    priv->drift_check_id = g_timeout_add_seconds (DRIFT_CHECK_INTERVAL, on_drift_check, self);
+    g_source_set_name_by_id (priv->drift_check_id, "[PhoshMediaPlayer] drift check");
   }
-  g_debug ("Starting position poller");
-  poll_position (self);
-  priv->pos_poller_id = g_timeout_add_seconds (POLLER_INTERVAL,
-                                               (GSourceFunc) poll_position,
-                                               self);
-  g_source_set_name_by_id (priv->pos_poller_id, "[PhoshMediaPlayer] pos_poller");
+
+  if (priv->pos_tick_id)
+    return;
+
+  position = get_position (self);
+  /* Wait for the player to move on to the next track */
+  if (priv->track_length > 0 && position >= priv->track_length)
+    return;
+
+  timeout = (G_USEC_PER_SEC - position % G_USEC_PER_SEC) / priv->rate;
+  priv->pos_tick_id = g_timeout_add (timeout / 1000 + 1, on_pos_tick, self);
+  g_source_set_name_by_id (priv->pos_tick_id, "[PhoshMediaPlayer] position tick");
+}
+
+
+static void
+on_seeked (PhoshMediaPlayer *self, gint64 position, PhoshDBusMediaPlayer2Player *player)
+{
+  g_return_if_fail (PHOSH_IS_MEDIA_PLAYER (self));
+
+  g_debug ("Seeked to %" G_GINT64_FORMAT, position);
+  set_position (self, position);
+}
+
+
+static void
+on_rate_changed (PhoshMediaPlayer *self, GParamSpec *pspec, PhoshDBusMediaPlayer2Player *player)
+{
+  PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
+  gint64 position;
+  double rate;
+
+  g_return_if_fail (PHOSH_IS_MEDIA_PLAYER (self));
+
+  /* A rate of 0.0 is invalid, players not implementing Rate play at normal speed */
+  rate = phosh_dbus_media_player2_player_get_rate (player);
+  if (rate <= 0.0)
+    rate = 1.0;
+
+  if (G_APPROX_VALUE (rate, priv->rate, FLT_EPSILON))
+    return;
+
+  g_debug ("Rate: %f", rate);
+  position = get_position (self);
+  priv->rate = rate;
+  if (position >= 0)
+    set_position (self, position);
 }
 
 
@@ -312,7 +444,8 @@ on_next_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
     phosh_async_error_warn (err, "Failed to trigger next");
     return;
   }
-  priv->track_position = 0;
+  if (priv->pos_base >= 0)
+    set_position (self, 0);
 }
 
 
@@ -343,7 +476,8 @@ on_previous_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
     phosh_async_error_warn (err, "Failed to trigger prev");
     return;
   }
-  priv->track_position = 0;
+  if (priv->pos_base >= 0)
+    set_position (self, 0);
 }
 
 
@@ -376,7 +510,8 @@ on_seek_done (GObject *source_object, GAsyncResult *res, gpointer user_data)
     g_warning ("Failed to trigger seek: %s", err->message);
     return;
   }
-  poll_position (self);
+  /* Players should emit Seeked but not all do */
+  sync_position (self);
 }
 
 
@@ -447,71 +582,12 @@ btn_details_clicked_cb (PhoshMediaPlayer *self, GtkButton *button)
 }
 
 
-static GdkPixbuf *
-center_pixbuf (GdkPixbuf *pixbuf)
+static void
+phosh_media_player_set_placeholder (PhoshMediaPlayer *self)
 {
-  int width, height, size;
-  g_autoptr (GdkPixbuf) centered = NULL;
-  g_autoptr (cairo_t) cr = NULL;
-  g_autoptr (cairo_surface_t) surface = NULL;
-
-  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
-
-  width = gdk_pixbuf_get_width (pixbuf);
-  height = gdk_pixbuf_get_height (pixbuf);
-
-  if (width == height)
-    return g_object_ref (pixbuf);
-
-  size = MAX (width, height);
-  /* gdk_pixbuf_copy_area would work as well but that goes via gdk_pixbuf_scale, …*/
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
-  cr = cairo_create (surface);
-  if (width > height)
-    gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, (width - height) / 2.0);
-  else
-    gdk_cairo_set_source_pixbuf (cr, pixbuf, (height - width) / 2.0, 0);
-  cairo_paint (cr);
-
-  return gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
-}
-
+  PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
 
-static GdkPixbuf *
-round_corners (GdkPixbuf *pixbuf)
-{
-  g_autoptr (GdkPixbuf) rounded = NULL;
-  g_autoptr (cairo_t) cr = NULL;
-  g_autoptr (cairo_surface_t) surface = NULL;
-  int width, height, size;
-  double radius;
-  const double degrees = M_PI / 180.0;
-
-  g_return_val_if_fail (GDK_IS_PIXBUF (pixbuf), NULL);
-
-  width = gdk_pixbuf_get_width (pixbuf);
-  height = gdk_pixbuf_get_height (pixbuf);
-
-  /* We only round square images */
-  g_return_val_if_fail (width == height, NULL);
-
-  size = width;
-  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, size, size);
-  cr = cairo_create (surface);
-
-  radius = size / 8.0;
-  cairo_new_path (cr);
-  cairo_arc (cr, size - radius, radius, radius, -90 * degrees, 0 * degrees);
-  cairo_arc (cr, size - radius, size - radius, radius, 0 * degrees, 90 * degrees);
-  cairo_arc (cr, radius, size - radius, radius, 90 * degrees, 180 * degrees);
-  cairo_arc (cr, radius, radius, radius, 180 * degrees, 270 * degrees);
-  cairo_close_path (cr);
-  cairo_clip (cr);
-
-  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
-  cairo_paint (cr);
-
-  return gdk_pixbuf_get_from_surface (surface, 0, 0, size, size);
+  g_object_set (priv->img_art, "icon-name", "audio-x-generic-symbolic", NULL);
 }
 
 
@@ -519,12 +595,15 @@ static void
 phosh_media_player_set_image (PhoshMediaPlayer *self, GdkPixbuf *pixbuf)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
-  g_autoptr (GdkPixbuf) centered = NULL;
-  g_autoptr (GdkPixbuf) rounded = NULL;
+  PhoshMediaArtCache *cache = phosh_media_art_cache_get_default ();
+  g_autoptr (GdkPixbuf) art = NULL;
+  int size;
+
+  g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
 
-  centered = center_pixbuf (pixbuf);
-  rounded = round_corners (centered);
-  g_object_set (priv->img_art, "gicon", rounded, NULL);
+  size = ART_PIXEL_SIZE * gtk_widget_get_scale_factor (priv->img_art);
+  art = phosh_media_art_cache_add (cache, priv->url, size, pixbuf, NULL, NULL, NULL);
+  g_object_set (priv->img_art, "gicon", art, NULL);
 }
 
 
@@ -540,7 +619,8 @@ on_fetch_icon_ready (GObject *source_object, GAsyncResult *res, gpointer user_da
 
   stream = g_loadable_icon_load_finish (G_LOADABLE_ICON (source_object), res, &type, &err);
   if (!stream) {
-    g_warning ("Failed to fetch icon: %s", err->message);
+    if (!phosh_async_error_warn (err, "Failed to fetch icon"))
+      phosh_media_player_set_placeholder (PHOSH_MEDIA_PLAYER (user_data));
     return;
   }
 
@@ -548,6 +628,11 @@ on_fetch_icon_ready (GObject *source_object, GAsyncResult *res, gpointer user_da
   self = PHOSH_MEDIA_PLAYER (user_data);
   priv = phosh_media_player_get_instance_private (self);
   pixbuf = gdk_pixbuf_new_from_stream (stream, priv->fetch_icon_cancel, &err);
+  if (!pixbuf) {
+    if (!phosh_async_error_warn (err, "Failed to load icon"))
+      phosh_media_player_set_placeholder (self);
+    return;
+  }
 
   phosh_media_player_set_image (self, pixbuf);
 }
@@ -584,7 +669,8 @@ on_load_icon_from_file_ready (GObject *source_object, GAsyncResult *res, gpointe
 
   pixbuf = gdk_pixbuf_new_from_stream_finish (res, &err);
   if (!pixbuf) {
-    phosh_async_error_warn (err, "Failed to load image");
+    if (!phosh_async_error_warn (err, "Failed to load image"))
+      phosh_media_player_set_placeholder (PHOSH_MEDIA_PLAYER (user_data));
     return;
   }
 
@@ -593,7 +679,7 @@ on_load_icon_from_file_ready (GObject *source_object, GAsyncResult *res, gpointe
 }
 
 
-static void
+static gboolean
 phosh_media_player_load_icon_from_file_async (PhoshMediaPlayer *self, GFile *file)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
@@ -605,7 +691,7 @@ phosh_media_player_load_icon_from_file_async (PhoshMediaPlayer *self, GFile *fil
     g_autofree char *path = g_file_get_path (file);
 
     g_warning ("Failed to open '%s': %s", path, err->message);
-    return;
+    return FALSE;
   }
 
   if (!priv->fetch_icon_cancel)
@@ -615,6 +701,76 @@ phosh_media_player_load_icon_from_file_async (PhoshMediaPlayer *self, GFile *fil
                                     priv->fetch_icon_cancel,
                                     on_load_icon_from_file_ready,
                                     self);
+  return TRUE;
+}
+
+
+static gboolean
+is_remote_or_file (const char *url)
+{
+  const char *scheme = g_uri_peek_scheme (url);
+
+  return (g_strcmp0 (scheme, "file") == 0 ||
+          g_strcmp0 (scheme, "http") == 0 ||
+          g_strcmp0 (scheme, "https") == 0);
+}
+
+
+/*
+ * Loads the art from @url. Returns %TRUE if the art was set or is
+ * being loaded.
+ */
+static gboolean
+phosh_media_player_load_art (PhoshMediaPlayer *self, const char *url)
+{
+  if (g_strcmp0 (g_uri_peek_scheme (url), "file") == 0) {
+    g_autoptr (GFile) file = g_file_new_for_uri (url);
+
+    return phosh_media_player_load_icon_from_file_async (self, file);
+  } else if (g_strcmp0 (g_uri_peek_scheme (url), "http") == 0 ||
+             g_strcmp0 (g_uri_peek_scheme (url), "https") == 0) {
+    fetch_icon_async (self, url);
+    return TRUE;
+  } else if (g_strcmp0 (g_uri_peek_scheme (url), "data") == 0) {
+    g_autoptr (GdkPixbuf) pixbuf = NULL;
+    g_autoptr (GError) error = NULL;
+
+    pixbuf = phosh_util_data_uri_to_pixbuf (url, &error);
+    if (pixbuf) {
+      phosh_media_player_set_image (self, pixbuf);
+      return TRUE;
+    }
+    g_warning_once ("Failed to load album art from base64 string: %s", error->message);
+  }
+
+  return FALSE;
+}
+
+
+static void
+on_art_lookup_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  PhoshMediaPlayer *self;
+  PhoshMediaPlayerPrivate *priv;
+  g_autoptr (GdkPixbuf) art = NULL;
+  g_autoptr (GError) err = NULL;
+
+  art = phosh_media_art_cache_lookup_finish (PHOSH_MEDIA_ART_CACHE (source_object), res, &err);
+  if (err) {
+    phosh_async_error_warn (err, "Failed to look up album art");
+    return;
+  }
+
+  self = PHOSH_MEDIA_PLAYER (user_data);
+  priv = phosh_media_player_get_instance_private (self);
+
+  if (art) {
+    g_object_set (priv->img_art, "gicon", art, NULL);
+    return;
+  }
+
+  if (!phosh_media_player_load_art (self, priv->url))
+    phosh_media_player_set_placeholder (self);
 }
 
 
@@ -622,7 +778,9 @@ static gboolean
 phosh_media_player_load_icon (PhoshMediaPlayer *self, const char *url)
 {
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
-  gboolean has_art = FALSE;
+  PhoshMediaArtCache *cache = phosh_media_art_cache_get_default ();
+  g_autoptr (GdkPixbuf) art = NULL;
+  int size;
 
   if (!g_set_str (&priv->url, url)) {
     g_debug ("Media URL did not change, skippig load");
@@ -634,27 +792,29 @@ phosh_media_player_load_icon (PhoshMediaPlayer *self, const char *url)
   g_cancellable_cancel (priv->fetch_icon_cancel);
   g_clear_object (&priv->fetch_icon_cancel);
 
-  if (url && g_strcmp0 (g_uri_peek_scheme (url), "file") == 0) {
-    g_autoptr (GFile) file = g_file_new_for_uri (url);
-
-    phosh_media_player_load_icon_from_file_async (self, file);
-  } else if (url && (g_strcmp0 (g_uri_peek_scheme (url), "http") == 0 ||
-                     g_strcmp0 (g_uri_peek_scheme (url), "https") == 0)) {
-    fetch_icon_async (self, url);
-  } else if (url && g_strcmp0 (g_uri_peek_scheme (url), "data") == 0) {
-    g_autoptr (GdkPixbuf) pixbuf = NULL;
-    g_autoptr (GError) error = NULL;
+  if (url == NULL)
+    return FALSE;
 
-    pixbuf = phosh_util_data_uri_to_pixbuf (url, &error);
-    if (pixbuf) {
-      phosh_media_player_set_image (self, pixbuf);
-      has_art = TRUE;
-    } else {
-      g_warning_once ("Failed to load album art from base64 string: %s", error->message);
-    }
+  size = ART_PIXEL_SIZE * gtk_widget_get_scale_factor (priv->img_art);
+  art = phosh_media_art_cache_lookup (cache, url, size);
+  if (art) {
+    g_object_set (priv->img_art, "gicon", art, NULL);
+    return TRUE;
   }
 
-  return has_art;
+  /* data: URLs are only cached in memory and cheap to decode */
+  if (!is_remote_or_file (url))
+    return phosh_media_player_load_art (self, url);
+
+  /* Keep the current art until the lookup or the load finishes */
+  priv->fetch_icon_cancel = g_cancellable_new ();
+  phosh_media_art_cache_lookup_async (cache,
+                                      url,
+                                      size,
+                                      priv->fetch_icon_cancel,
+                                      on_art_lookup_ready,
+                                      self);
+  return TRUE;
 }
 
 
@@ -703,18 +863,18 @@ on_metadata_changed (PhoshMediaPlayer *self, GParamSpec *psepc, PhoshDBusMediaPl
     gtk_label_set_label (GTK_LABEL (priv->lbl_length), length_text);
     g_debug ("Metadata has length, showing box_pos_len");
     gtk_widget_set_visible (priv->box_pos_len, TRUE);
-    if (priv->status == PHOSH_MEDIA_PLAYER_STATUS_PLAYING)
-      start_pos_poller (self);
   } else {
     gtk_label_set_label (GTK_LABEL (priv->lbl_length), "-");
   }
   priv->track_length = length;
   update_position (self);
+  /* Might be a new track */
+  sync_position (self);
 
   has_art = phosh_media_player_load_icon (self, url);
 
   if (!has_art)
-    g_object_set (priv->img_art, "icon-name", "audio-x-generic-symbolic", NULL);
+    phosh_media_player_set_placeholder (self);
 }
 
 
@@ -726,6 +886,7 @@ on_playback_status_changed (PhoshMediaPlayer            *self,
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
   const char *status, *icon = "media-playback-start-symbolic";
   PhoshMediaPlayerStatus current;
+  gint64 position;
 
   g_return_if_fail (PHOSH_IS_MEDIA_PLAYER (self));
 
@@ -737,19 +898,22 @@ on_playback_status_changed (PhoshMediaPlayer            *self,
 
   g_debug ("Status: '%s'", status);
   current = priv->status;
+  /* Position up to now, continue from there with the new status */
+  position = get_position (self);
   if (!g_strcmp0 ("Playing", status)) {
     priv->status = PHOSH_MEDIA_PLAYER_STATUS_PLAYING;
     icon = "media-playback-pause-symbolic";
-    start_pos_poller (self);
+    if (position >= 0)
+      set_position (self, position);
+    sync_position (self);
   } else if (!g_strcmp0 ("Paused", status)) {
     priv->status = PHOSH_MEDIA_PLAYER_STATUS_PAUSED;
-    stop_pos_poller (self);
-    poll_position (self);
+    if (position >= 0)
+      set_position (self, position);
+    sync_position (self);
   } else if (!g_strcmp0 ("Stopped", status)) {
     priv->status = PHOSH_MEDIA_PLAYER_STATUS_STOPPED;
-    stop_pos_poller (self);
-    priv->track_position = 0;
-    update_position (self);
+    set_position (self, 0);
   } else {
     g_warning ("Unknown status %s", status);
     g_warn_if_reached ();
@@ -826,7 +990,7 @@ phosh_media_player_dispose (GObject *object)
   PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (object);
   PhoshMediaPlayerPrivate *priv = phosh_media_player_get_instance_private (self);
 
-  stop_pos_poller (self);
+  stop_pos_tracking (self);
   g_cancellable_cancel (priv->cancel);
   g_clear_object (&priv->cancel);
 
@@ -842,6 +1006,30 @@ phosh_media_player_dispose (GObject *object)
 }
 
 
+static void
+phosh_media_player_map (GtkWidget *widget)
+{
+  PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (widget);
+
+  GTK_WIDGET_CLASS (phosh_media_player_parent_class)->map (widget);
+
+  /* We don't track the position while unmapped */
+  sync_position (self);
+  update_pos_tracking (self);
+}
+
+
+static void
+phosh_media_player_unmap (GtkWidget *widget)
+{
+  PhoshMediaPlayer *self = PHOSH_MEDIA_PLAYER (widget);
+
+  stop_pos_tracking (self);
+
+  GTK_WIDGET_CLASS (phosh_media_player_parent_class)->unmap (widget);
+}
+
+
 static void
 phosh_media_player_class_init (PhoshMediaPlayerClass *klass)
 {
@@ -851,6 +1039,9 @@ phosh_media_player_class_init (PhoshMediaPlayerClass *klass)
   object_class->dispose = phosh_media_player_dispose;
   object_class->get_property = phosh_media_player_get_property;
 
+  widget_class->map = phosh_media_player_map;
+  widget_class->unmap = phosh_media_player_unmap;
+
   /**
    * PhoshMediaPlayer:attached
    *
@@ -932,7 +1123,8 @@ phosh_media_player_init (PhoshMediaPlayer *self)
   priv->cancel = g_cancellable_new ();
   priv->track_length = -1;
   priv->track_position = -1;
-  priv->pos_poller_id = 0;
+  priv->pos_base = -1;
+  priv->rate = 1.0;
 
   if (manager) {
     priv->manager = g_object_ref (manager);
@@ -1027,9 +1219,15 @@ phosh_media_player_set_player (PhoshMediaPlayer *self, PhoshDBusMediaPlayer2Play
                     "swapped-object-signal::notify::can-seek",
                     G_CALLBACK (on_can_seek),
                     self,
+                    "swapped-object-signal::notify::rate",
+                    G_CALLBACK (on_rate_changed),
+                    self,
+                    "swapped-object-signal::seeked",
+                    G_CALLBACK (on_seeked),
+                    self,
                     NULL);
 
-  /* Set 'attached' before running notifiers, since we check it on e.g. start_pos_poller() */
+  /* Set 'attached' before running notifiers, since we check it on e.g. sync_position() */
   set_attached (self, TRUE);
   /* Hide progress bar box by default, it's shown if track length is given in metadata */
   gtk_widget_set_visible (priv->box_pos_len, FALSE);
@@ -1040,4 +1238,5 @@ phosh_media_player_set_player (PhoshMediaPlayer *self, PhoshDBusMediaPlayer2Play
   g_object_notify (G_OBJECT (priv->player), "can-go-previous");
   g_object_notify (G_OBJECT (priv->player), "can-play");
   g_object_notify (G_OBJECT (priv->player), "can-seek");
+  g_object_notify (G_OBJECT (priv->player), "rate");
 }
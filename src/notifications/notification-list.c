@@ -12,6 +12,12 @@
 #include "notification-source.h"
 #include "notification-list.h"
 
+#include <gdk-pixbuf/gdk-pixbuf.h>
+
+#define DEFAULT_MAX_PER_SOURCE  50
+#define DEFAULT_MAX_TOTAL       200
+#define DEFAULT_MAX_IMAGE_BYTES (16 * 1024 * 1024)
+
 /**
  * PhoshNotificationList:
  *
@@ -19,8 +25,29 @@
  *
  * #PhoshNotificationList maps between #PhoshNotificationSource objects and their
  * notifications creating and removing sources on the fly.
+ *
+ * To keep memory use bounded the number of notifications per source
+ * and in total is limited, as is the memory used by the notifications'
+ * images. When a limit is exceeded the oldest notifications are closed.
  */
 
+enum {
+  PROP_0,
+  PROP_MAX_PER_SOURCE,
+  PROP_MAX_TOTAL,
+  PROP_MAX_IMAGE_BYTES,
+  PROP_IMAGE_BYTES,
+  LAST_PROP
+};
+static GParamSpec *props[LAST_PROP];
+
+/* A notification in the list in the order they were added */
+typedef struct {
+  PhoshNotification *notification;
+  /* The image we accounted for */
+  GIcon             *image;
+} NotificationEntry;
+
 
 struct _PhoshNotificationList {
   GObject     parent;
@@ -38,8 +65,18 @@ struct _PhoshNotificationList {
   /* Map of source name -> iter in source_list */
   GHashTable *source_map;
 
-  /* Map of id -> notification */
+  /* Map of id -> link in entries */
   GHashTable *notifications;
+  /* Queue of NotificationEntry, oldest first */
+  GQueue      entries;
+
+  /* Map of image -> number of notifications using it */
+  GHashTable *images;
+  guint64     image_bytes;
+
+  guint       max_per_source;
+  guint       max_total;
+  guint64     max_image_bytes;
 };
 typedef struct _PhoshNotificationList PhoshNotificationList;
 
@@ -50,10 +87,86 @@ G_DEFINE_TYPE_WITH_CODE (PhoshNotificationList, phosh_notification_list, G_TYPE_
                          G_IMPLEMENT_INTERFACE (G_TYPE_LIST_MODEL, list_iface_init))
 
 
+static void phosh_notification_list_evict (PhoshNotificationList   *self,
+                                           PhoshNotificationSource *source,
+                                           PhoshNotification       *keep);
+static void on_notification_image_changed (PhoshNotificationList   *self,
+                                           GParamSpec              *pspec,
+                                           PhoshNotification       *notification);
+
+
+static void
+phosh_notification_list_set_property (GObject      *object,
+                                      guint         property_id,
+                                      const GValue *value,
+                                      GParamSpec   *pspec)
+{
+  PhoshNotificationList *self = PHOSH_NOTIFICATION_LIST (object);
+
+  switch (property_id) {
+    case PROP_MAX_PER_SOURCE:
+      phosh_notification_list_set_max_per_source (self, g_value_get_uint (value));
+    break;
+    case PROP_MAX_TOTAL:
+      phosh_notification_list_set_max_total (self, g_value_get_uint (value));
+    break;
+    case PROP_MAX_IMAGE_BYTES:
+      phosh_notification_list_set_max_image_bytes (self, g_value_get_uint64 (value));
+    break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+
+static void
+phosh_notification_list_get_property (GObject    *object,
+                                      guint       property_id,
+                                      GValue     *value,
+                                      GParamSpec *pspec)
+{
+  PhoshNotificationList *self = PHOSH_NOTIFICATION_LIST (object);
+
+  switch (property_id) {
+    case PROP_MAX_PER_SOURCE:
+      g_value_set_uint (value, self->max_per_source);
+    break;
+    case PROP_MAX_TOTAL:
+      g_value_set_uint (value, self->max_total);
+    break;
+    case PROP_MAX_IMAGE_BYTES:
+      g_value_set_uint64 (value, self->max_image_bytes);
+    break;
+    case PROP_IMAGE_BYTES:
+      g_value_set_uint64 (value, self->image_bytes);
+    break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+      break;
+  }
+}
+
+
+static void
+notification_entry_free (NotificationEntry *entry)
+{
+  g_clear_object (&entry->image);
+  g_free (entry);
+}
+
+
 static void
 phosh_notification_list_finalize (GObject *object)
 {
   PhoshNotificationList *self = PHOSH_NOTIFICATION_LIST (object);
+  NotificationEntry *entry;
+
+  while ((entry = g_queue_pop_head (&self->entries))) {
+    g_signal_handlers_disconnect_by_data (entry->notification, self);
+    notification_entry_free (entry);
+  }
+  g_clear_pointer (&self->images, g_hash_table_unref);
 
   g_clear_pointer (&self->source_list, g_sequence_free);
   g_clear_pointer (&self->source_map, g_hash_table_unref);
@@ -70,6 +183,54 @@ phosh_notification_list_class_init (PhoshNotificationListClass *klass)
   GObjectClass *object_class = G_OBJECT_CLASS (klass);
 
   object_class->finalize = phosh_notification_list_finalize;
+  object_class->set_property = phosh_notification_list_set_property;
+  object_class->get_property = phosh_notification_list_get_property;
+
+  /**
+   * PhoshNotificationList:max-per-source:
+   *
+   * The maximum number of notifications kept per source. When
+   * exceeded the source's oldest notifications are closed. `0`
+   * means no limit.
+   */
+  props[PROP_MAX_PER_SOURCE] =
+    g_param_spec_uint ("max-per-source", "", "",
+                       0, G_MAXUINT, DEFAULT_MAX_PER_SOURCE,
+                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
+  /**
+   * PhoshNotificationList:max-total:
+   *
+   * The maximum number of notifications kept overall. When
+   * exceeded the oldest notifications are closed. `0` means no limit.
+   */
+  props[PROP_MAX_TOTAL] =
+    g_param_spec_uint ("max-total", "", "",
+                       0, G_MAXUINT, DEFAULT_MAX_TOTAL,
+                       G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
+  /**
+   * PhoshNotificationList:max-image-bytes:
+   *
+   * The maximum amount of memory in bytes the images of all
+   * notifications may use. When exceeded the oldest notifications are
+   * closed. `0` means no limit.
+   */
+  props[PROP_MAX_IMAGE_BYTES] =
+    g_param_spec_uint64 ("max-image-bytes", "", "",
+                         0, G_MAXUINT64, DEFAULT_MAX_IMAGE_BYTES,
+                         G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
+  /**
+   * PhoshNotificationList:image-bytes:
+   *
+   * The amount of memory in bytes used by the images of the
+   * notifications in the list. Images shared between notifications
+   * are only accounted once.
+   */
+  props[PROP_IMAGE_BYTES] =
+    g_param_spec_uint64 ("image-bytes", "", "",
+                         0, G_MAXUINT64, 0,
+                         G_PARAM_READABLE | G_PARAM_STATIC_STRINGS | G_PARAM_EXPLICIT_NOTIFY);
+
+  g_object_class_install_properties (object_class, LAST_PROP, props);
 }
 
 
@@ -141,6 +302,13 @@ phosh_notification_list_init (PhoshNotificationList *self)
                                                g_direct_equal,
                                                NULL,
                                                NULL);
+  g_queue_init (&self->entries);
+
+  self->images = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  self->max_per_source = DEFAULT_MAX_PER_SOURCE;
+  self->max_total = DEFAULT_MAX_TOTAL;
+  self->max_image_bytes = DEFAULT_MAX_IMAGE_BYTES;
 }
 
 
@@ -195,6 +363,103 @@ empty (PhoshNotificationSource *source,
 }
 
 
+static gsize
+get_image_size (GIcon *image)
+{
+  /* Only in memory images use significant amounts of memory */
+  if (!GDK_IS_PIXBUF (image))
+    return 0;
+
+  return gdk_pixbuf_get_byte_length (GDK_PIXBUF (image));
+}
+
+
+/**
+ * account_image:
+ * @self: the #PhoshNotificationList
+ * @entry: The entry to update
+ * @image:(nullable): The entry's new image
+ *
+ * Update the image bytes for @entry now using @image. Images
+ * shared between notifications are only accounted once.
+ */
+static void
+account_image (PhoshNotificationList *self, NotificationEntry *entry, GIcon *image)
+{
+  guint64 image_bytes = self->image_bytes;
+  guint users;
+
+  if (entry->image == image)
+    return;
+
+  if (entry->image) {
+    users = GPOINTER_TO_UINT (g_hash_table_lookup (self->images, entry->image));
+    if (users > 1) {
+      g_hash_table_insert (self->images, entry->image, GUINT_TO_POINTER (users - 1));
+    } else {
+      g_hash_table_remove (self->images, entry->image);
+      self->image_bytes -= get_image_size (entry->image);
+    }
+  }
+
+  g_set_object (&entry->image, image);
+
+  if (entry->image) {
+    users = GPOINTER_TO_UINT (g_hash_table_lookup (self->images, entry->image));
+    g_hash_table_insert (self->images, entry->image, GUINT_TO_POINTER (users + 1));
+    if (users == 0)
+      self->image_bytes += get_image_size (entry->image);
+  }
+
+  if (self->image_bytes != image_bytes)
+    g_object_notify_by_pspec (G_OBJECT (self), props[PROP_IMAGE_BYTES]);
+}
+
+
+static int
+compare_entry (gconstpointer data, gconstpointer user_data)
+{
+  const NotificationEntry *entry = data;
+
+  return entry->notification == user_data ? 0 : 1;
+}
+
+
+static GList *
+find_entry (PhoshNotificationList *self, PhoshNotification *notification)
+{
+  GList *link;
+  guint id;
+
+  id = phosh_notification_get_id (notification);
+  link = g_hash_table_lookup (self->notifications, GUINT_TO_POINTER (id));
+  if (link && ((NotificationEntry *)link->data)->notification == notification)
+    return link;
+
+  /* Notification ids aren't necessarily unique when not added via the manager */
+  return g_queue_find_custom (&self->entries, notification, compare_entry);
+}
+
+
+static void
+on_notification_image_changed (PhoshNotificationList *self,
+                               GParamSpec            *pspec,
+                               PhoshNotification     *notification)
+{
+  NotificationEntry *entry;
+  GList *link;
+
+  link = find_entry (self, notification);
+  g_return_if_fail (link);
+
+  entry = link->data;
+  account_image (self, entry, phosh_notification_get_image (notification));
+
+  if (self->max_image_bytes && self->image_bytes > self->max_image_bytes)
+    phosh_notification_list_evict (self, NULL, notification);
+}
+
+
 /**
  * closed:
  * @notification: the #PhoshNotification
@@ -211,6 +476,8 @@ closed (PhoshNotification       *notification,
         PhoshNotificationReason  reason,
         PhoshNotificationList   *self)
 {
+  NotificationEntry *entry;
+  GList *link;
   guint id;
 
   g_return_if_fail (PHOSH_IS_NOTIFICATION_LIST (self));
@@ -218,7 +485,89 @@ closed (PhoshNotification       *notification,
 
   id = phosh_notification_get_id (notification);
 
-  g_hash_table_remove (self->notifications, GUINT_TO_POINTER (id));
+  link = find_entry (self, notification);
+  if (link == NULL)
+    return;
+
+  entry = link->data;
+
+  g_signal_handlers_disconnect_by_func (notification, on_notification_image_changed, self);
+  g_signal_handlers_disconnect_by_func (notification, closed, self);
+
+  account_image (self, entry, NULL);
+  g_queue_delete_link (&self->entries, link);
+  notification_entry_free (entry);
+
+  if (g_hash_table_lookup (self->notifications, GUINT_TO_POINTER (id)) == link)
+    g_hash_table_remove (self->notifications, GUINT_TO_POINTER (id));
+}
+
+
+static gboolean
+is_over_limit (PhoshNotificationList *self)
+{
+  if (self->max_total && g_queue_get_length (&self->entries) > self->max_total)
+    return TRUE;
+
+  if (self->max_image_bytes && self->image_bytes > self->max_image_bytes)
+    return TRUE;
+
+  return FALSE;
+}
+
+
+/**
+ * phosh_notification_list_evict:
+ * @self: the #PhoshNotificationList
+ * @source:(nullable): Only check the per source limit of this source
+ * @keep:(nullable): A notification that must not be evicted
+ *
+ * Close the oldest notifications until @self is within its limits again.
+ * @keep is usually the most recent notification so it's never evicted
+ * right away.
+ */
+static void
+phosh_notification_list_evict (PhoshNotificationList   *self,
+                               PhoshNotificationSource *source,
+                               PhoshNotification       *keep)
+{
+  guint n_items;
+
+  /* Oldest notifications are at the end of the source */
+  while (source && self->max_per_source &&
+         (n_items = g_list_model_get_n_items (G_LIST_MODEL (source))) > self->max_per_source) {
+    g_autoptr (PhoshNotification) oldest = g_list_model_get_item (G_LIST_MODEL (source),
+                                                                  n_items - 1);
+    if (oldest == keep)
+      break;
+
+    g_debug ("Evicting notification %u, too many notifications from %s",
+             phosh_notification_get_id (oldest),
+             phosh_notification_source_get_name (source));
+    phosh_notification_close (oldest, PHOSH_NOTIFICATION_REASON_EXPIRED);
+
+    if (g_list_model_get_n_items (G_LIST_MODEL (source)) == n_items)
+      break;
+  }
+
+  while (is_over_limit (self)) {
+    NotificationEntry *entry = g_queue_peek_head (&self->entries);
+    g_autoptr (PhoshNotification) oldest = NULL;
+
+    if (entry == NULL || entry->notification == keep)
+      break;
+
+    oldest = g_object_ref (entry->notification);
+    g_debug ("Evicting notification %u, %u notifications, %" G_GUINT64_FORMAT " image bytes",
+             phosh_notification_get_id (oldest),
+             g_queue_get_length (&self->entries),
+             self->image_bytes);
+    phosh_notification_close (oldest, PHOSH_NOTIFICATION_REASON_EXPIRED);
+
+    /* Don't loop forever if the notification didn't go away */
+    if (g_queue_peek_head (&self->entries) == entry)
+      break;
+  }
 }
 
 
@@ -238,6 +587,7 @@ phosh_notification_list_add (PhoshNotificationList *self,
                              PhoshNotification     *notification)
 {
   PhoshNotificationSource *source;
+  NotificationEntry *entry;
   GSequenceIter *source_iter;
   guint id;
 
@@ -246,9 +596,14 @@ phosh_notification_list_add (PhoshNotificationList *self,
 
   id = phosh_notification_get_id (notification);
 
+  entry = g_new0 (NotificationEntry, 1);
+  entry->notification = notification;
+  g_queue_push_tail (&self->entries, entry);
+  account_image (self, entry, phosh_notification_get_image (notification));
+
   g_hash_table_insert (self->notifications,
                        GUINT_TO_POINTER (id),
-                       notification);
+                       g_queue_peek_tail_link (&self->entries));
 
   /* Lookup an existing entry for source id */
   source_iter = g_hash_table_lookup (self->source_map, source_id);
@@ -295,6 +650,10 @@ phosh_notification_list_add (PhoshNotificationList *self,
   phosh_notification_source_add (source, notification);
 
   g_signal_connect (notification, "closed", G_CALLBACK (closed), self);
+  g_signal_connect_swapped (notification, "notify::image",
+                            G_CALLBACK (on_notification_image_changed), self);
+
+  phosh_notification_list_evict (self, source, notification);
 }
 
 
@@ -311,12 +670,109 @@ PhoshNotification *
 phosh_notification_list_get_by_id (PhoshNotificationList *self,
                                    guint                  id)
 {
-  PhoshNotification *notification = NULL;
+  NotificationEntry *entry;
+  GList *link;
 
   g_return_val_if_fail (PHOSH_IS_NOTIFICATION_LIST (self), NULL);
 
-  notification = g_hash_table_lookup (self->notifications,
-                                      GUINT_TO_POINTER (id));
+  link = g_hash_table_lookup (self->notifications, GUINT_TO_POINTER (id));
+  if (link == NULL)
+    return NULL;
+
+  entry = link->data;
+  return entry->notification;
+}
+
+
+/**
+ * phosh_notification_list_set_max_per_source:
+ * @self: the #PhoshNotificationList
+ * @max_per_source: The maximum number of notifications per source or `0`
+ *
+ * Sets the maximum number of notifications kept per source.
+ */
+void
+phosh_notification_list_set_max_per_source (PhoshNotificationList *self, guint max_per_source)
+{
+  g_return_if_fail (PHOSH_IS_NOTIFICATION_LIST (self));
+
+  if (self->max_per_source == max_per_source)
+    return;
+
+  self->max_per_source = max_per_source;
+
+  if (self->max_per_source) {
+    for (GSequenceIter *iter = g_sequence_get_begin_iter (self->source_list);
+         !g_sequence_iter_is_end (iter);) {
+      g_autoptr (PhoshNotificationSource) source = g_object_ref (g_sequence_get (iter));
+
+      /* Evicting can remove the source */
+      iter = g_sequence_iter_next (iter);
+      phosh_notification_list_evict (self, source, NULL);
+    }
+  }
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_MAX_PER_SOURCE]);
+}
+
+
+/**
+ * phosh_notification_list_set_max_total:
+ * @self: the #PhoshNotificationList
+ * @max_total: The maximum number of notifications or `0`
+ *
+ * Sets the maximum number of notifications kept overall.
+ */
+void
+phosh_notification_list_set_max_total (PhoshNotificationList *self, guint max_total)
+{
+  g_return_if_fail (PHOSH_IS_NOTIFICATION_LIST (self));
+
+  if (self->max_total == max_total)
+    return;
+
+  self->max_total = max_total;
+  phosh_notification_list_evict (self, NULL, NULL);
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_MAX_TOTAL]);
+}
+
+
+/**
+ * phosh_notification_list_set_max_image_bytes:
+ * @self: the #PhoshNotificationList
+ * @max_image_bytes: The maximum memory used by images or `0`
+ *
+ * Sets the maximum amount of memory the images of all notifications
+ * may use.
+ */
+void
+phosh_notification_list_set_max_image_bytes (PhoshNotificationList *self, guint64 max_image_bytes)
+{
+  g_return_if_fail (PHOSH_IS_NOTIFICATION_LIST (self));
+
+  if (self->max_image_bytes == max_image_bytes)
+    return;
+
+  self->max_image_bytes = max_image_bytes;
+  phosh_notification_list_evict (self, NULL, NULL);
+
+  g_object_notify_by_pspec (G_OBJECT (self), props[PROP_MAX_IMAGE_BYTES]);
+}
+
+
+/**
+ * phosh_notification_list_get_image_bytes:
+ * @self: the #PhoshNotificationList
+ *
+ * Get the memory used by the images of the notifications in @self.
+ *
+ * Returns: The image memory in bytes
+ */
+guint64
+phosh_notification_list_get_image_bytes (PhoshNotificationList *self)
+{
+  g_return_val_if_fail (PHOSH_IS_NOTIFICATION_LIST (self), 0);
 
-  return notification;
+  return self->image_bytes;
 }
@@ -27,5 +27,12 @@ void                   phosh_notification_list_add       (PhoshNotificationList
                                                           PhoshNotification     *notification);
 PhoshNotification     *phosh_notification_list_get_by_id (PhoshNotificationList *self,
                                                           guint                  id);
+void                   phosh_notification_list_set_max_per_source  (PhoshNotificationList *self,
+                                                                    guint                  max_per_source);
+void                   phosh_notification_list_set_max_total       (PhoshNotificationList *self,
+                                                                    guint                  max_total);
+void                   phosh_notification_list_set_max_image_bytes (PhoshNotificationList *self,
+                                                                    guint64                max_image_bytes);
+guint64                phosh_notification_list_get_image_bytes     (PhoshNotificationList *self);
 
 G_END_DECLS
@@ -33,6 +33,20 @@
 
 #define NOTIFICATIONS_SPEC_VERSION "1.2"
 
+#define PHOSH_NOTIFICATIONS_SCHEMA "sm.puri.phosh.notifications"
+#define PHOSH_NOTIFICATIONS_KEY_MAX_PER_APP "max-per-app"
+#define PHOSH_NOTIFICATIONS_KEY_MAX_TOTAL "max-total"
+
+/* More than RATE_LIMIT_BURST notifications from a D-Bus sender for the same
+ * source within RATE_LIMIT_WINDOW_US are coalesced into the last one */
+#define RATE_LIMIT_BURST     5
+#define RATE_LIMIT_WINDOW_US (2 * G_USEC_PER_SEC)
+/* Upper bound of sender/source pairs we track for rate limiting */
+#define RATE_LIMIT_MAX       128
+
+/* Images are shown at 32px, leave room for scaled outputs */
+#define NOTIFICATION_IMAGE_MAX_SIZE (32 * 3)
+
 /**
  * PhoshNotifyManager:
  *
@@ -65,6 +79,10 @@ typedef struct _PhoshNotifyManager
   GStrv app_children;
 
   GSettings *settings;
+  GSettings *phosh_settings;
+
+  /* Map of D-Bus sender (or source id) -> RateLimit */
+  GHashTable *rate_limits;
 
   /* Notification to be handled on unlock */
   struct {
@@ -74,6 +92,9 @@ typedef struct _PhoshNotifyManager
 
   PhoshNotificationList *list;
   PhoshNotifyFeedback *feedback;
+
+  /* Images currently in use by notifications, key: content hash, value: GIcon (weak) */
+  GHashTable *images;
 } PhoshNotifyManager;
 
 static void phosh_notify_manager_notify_iface_init (PhoshDBusNotificationsIface *iface);
@@ -292,11 +313,123 @@ phosh_notify_manager_is_notification_enabled (PhoshNotification *notification)
 }
 
 
+typedef struct {
+  gint64 window_start;
+  guint  count;
+  guint  last_id;
+} RateLimit;
+
+
+static gboolean
+is_rate_limit_expired (gpointer key, gpointer value, gpointer user_data)
+{
+  RateLimit *limit = value;
+  gint64 now = *(gint64 *)user_data;
+
+  return now - limit->window_start > RATE_LIMIT_WINDOW_US;
+}
+
+
+static void
+drop_oldest_rate_limit (PhoshNotifyManager *self)
+{
+  GHashTableIter iter;
+  gpointer key, value, oldest_key = NULL;
+  gint64 oldest = G_MAXINT64;
+
+  g_hash_table_iter_init (&iter, self->rate_limits);
+  while (g_hash_table_iter_next (&iter, &key, &value)) {
+    RateLimit *limit = value;
+
+    if (limit->window_start < oldest) {
+      oldest = limit->window_start;
+      oldest_key = key;
+    }
+  }
+
+  if (oldest_key)
+    g_hash_table_remove (self->rate_limits, oldest_key);
+}
+
+
+/**
+ * get_coalesce_id:
+ * @self: The notify manager
+ * @sender: The D-Bus sender and source id a new notification is sent from
+ *
+ * Checks whether @sender sent too many notifications in a short
+ * amount of time. If so the new notification should replace the
+ * last one rather than adding another notification.
+ *
+ * Returns: The id of the notification to replace or `0`
+ */
+static guint
+get_coalesce_id (PhoshNotifyManager *self, const char *sender)
+{
+  gint64 now = g_get_monotonic_time ();
+  RateLimit *limit;
+
+  limit = g_hash_table_lookup (self->rate_limits, sender);
+  if (limit == NULL) {
+    if (g_hash_table_size (self->rate_limits) >= RATE_LIMIT_MAX)
+      g_hash_table_foreach_remove (self->rate_limits, is_rate_limit_expired, &now);
+    if (g_hash_table_size (self->rate_limits) >= RATE_LIMIT_MAX)
+      drop_oldest_rate_limit (self);
+
+    limit = g_new0 (RateLimit, 1);
+    g_hash_table_insert (self->rate_limits, g_strdup (sender), limit);
+  }
+
+  if (now - limit->window_start > RATE_LIMIT_WINDOW_US) {
+    limit->window_start = now;
+    limit->count = 0;
+  }
+
+  limit->count++;
+  if (limit->count <= RATE_LIMIT_BURST || limit->last_id == 0)
+    return 0;
+
+  if (!phosh_notification_list_get_by_id (self->list, limit->last_id))
+    return 0;
+
+  g_debug ("Coalescing notification from %s into %u", sender, limit->last_id);
+  return limit->last_id;
+}
+
+
+static void
+set_last_id (PhoshNotifyManager *self, const char *sender, guint id)
+{
+  RateLimit *limit = g_hash_table_lookup (self->rate_limits, sender);
+
+  if (limit)
+    limit->last_id = id;
+}
+
+
+static gboolean
+is_image (gpointer key, gpointer value, gpointer user_data)
+{
+  return value == user_data;
+}
+
+
+static void
+on_image_finalized (gpointer data, GObject *where_the_object_was)
+{
+  PhoshNotifyManager *self = PHOSH_NOTIFY_MANAGER (data);
+
+  g_hash_table_foreach_remove (self->images, is_image, where_the_object_was);
+}
+
+
 static GIcon *
-parse_icon_data (GVariant *variant)
+parse_icon_data (PhoshNotifyManager *self, GVariant *variant)
 {
-  GVariant *wrapped_data = NULL;
-  guchar *data = NULL;
+  g_autoptr (GVariant) wrapped_data = NULL;
+  g_autoptr (GBytes) bytes = NULL;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autofree char *hash = NULL;
   GIcon *icon = NULL;
   int width = 0;
   int height = 0;
@@ -304,44 +437,82 @@ parse_icon_data (GVariant *variant)
   int has_alpha = 0;
   int sample_size = 0;
   int channels = 0;
+  gsize size_should_be;
+
+  if (!g_variant_is_of_type (variant, G_VARIANT_TYPE ("(iiibiiay)")))
+    return NULL;
 
-  if (g_variant_is_of_type (variant, G_VARIANT_TYPE ("(iiibiiay)"))) {
-    gsize size_should_be;
+  g_variant_get (variant,
+                 "(iiibii@ay)",
+                 &width,
+                 &height,
+                 &row_stride,
+                 &has_alpha,
+                 &sample_size,
+                 &channels,
+                 &wrapped_data);
+
+  if (width <= 0 || height <= 0 || sample_size != 8 || channels != (has_alpha ? 4 : 3)) {
+    g_warning ("Rejecting image, unsupported format %dx%d, %d bits, %d channels",
+               width, height, sample_size, channels);
+    return NULL;
+  }
 
-    g_variant_get (variant,
-                   "(iiibii@ay)",
-                   &width,
-                   &height,
-                   &row_stride,
-                   &has_alpha,
-                   &sample_size,
-                   &channels,
-                   &wrapped_data);
+  if (row_stride < width * channels) {
+    g_warning ("Rejecting image, row stride %d too small for width %d", row_stride, width);
+    return NULL;
+  }
+
+  size_should_be = (gsize) (height - 1) * row_stride + (gsize) width * channels;
+
+  if (size_should_be != g_variant_get_size (wrapped_data)) {
+    g_warning ("Rejecting image, %" G_GSIZE_FORMAT
+               " (expected) != %" G_GSIZE_FORMAT,
+               size_should_be, g_variant_get_size (wrapped_data));
+
+    return NULL;
+  }
 
-    size_should_be = (height - 1) * row_stride + width * ((channels * sample_size + 7) / 8);
+  /* Apps tend to send the same image (e.g. an avatar) over and over again */
+  hash = g_compute_checksum_for_data (G_CHECKSUM_SHA256,
+                                      g_variant_get_data (variant),
+                                      g_variant_get_size (variant));
+  icon = g_hash_table_lookup (self->images, hash);
+  if (icon)
+    return g_object_ref (icon);
+
+  /* Use the data without copying it */
+  bytes = g_variant_get_data_as_bytes (wrapped_data);
+  pixbuf = gdk_pixbuf_new_from_bytes (bytes,
+                                      GDK_COLORSPACE_RGB,
+                                      has_alpha,
+                                      sample_size,
+                                      width,
+                                      height,
+                                      row_stride);
+  if (pixbuf == NULL)
+    return NULL;
 
-    if (size_should_be != g_variant_get_size (wrapped_data)) {
-      g_warning ("Rejecting image, %" G_GSIZE_FORMAT
-                 " (expected) != %" G_GSIZE_FORMAT,
-                 size_should_be, g_variant_get_size (wrapped_data));
+  /* Scale down once so we don't keep large images around */
+  if (width > NOTIFICATION_IMAGE_MAX_SIZE || height > NOTIFICATION_IMAGE_MAX_SIZE) {
+    double scale = (double) NOTIFICATION_IMAGE_MAX_SIZE / MAX (width, height);
+    GdkPixbuf *scaled;
 
+    scaled = gdk_pixbuf_scale_simple (pixbuf,
+                                      MAX (1, (int) (width * scale + 0.5)),
+                                      MAX (1, (int) (height * scale + 0.5)),
+                                      GDK_INTERP_BILINEAR);
+    if (scaled == NULL)
       return NULL;
-    }
 
-    /* Extract a copy of the raw data */
-    data = (guchar *) g_memdup2 (g_variant_get_data (wrapped_data), size_should_be);
-
-    icon = G_ICON (gdk_pixbuf_new_from_data (data,
-                                             GDK_COLORSPACE_RGB,
-                                             has_alpha,
-                                             sample_size,
-                                             width,
-                                             height,
-                                             row_stride,
-                                             (GdkPixbufDestroyNotify) g_free,
-                                             NULL));
+    g_object_unref (pixbuf);
+    pixbuf = scaled;
   }
 
+  icon = G_ICON (g_steal_pointer (&pixbuf));
+  g_hash_table_insert (self->images, g_steal_pointer (&hash), icon);
+  g_object_weak_ref (G_OBJECT (icon), on_image_finalized, self);
+
   return icon;
 }
 
@@ -433,6 +604,8 @@ handle_notify (PhoshDBusNotifications *skeleton,
   g_autofree char *sound_file = NULL;
   GIcon *icon = NULL;
   GIcon *image = NULL;
+  const char *sender = g_dbus_method_invocation_get_sender (invocation);
+  g_autofree char *rate_key = NULL;
 
   g_return_val_if_fail (PHOSH_IS_NOTIFY_MANAGER (self), FALSE);
 
@@ -455,14 +628,14 @@ handle_notify (PhoshDBusNotifications *skeleton,
       }
     } else if ((g_strcmp0 (key, "image-data") == 0) ||
                (g_strcmp0 (key, "image_data") == 0)) {
-      data_gicon = parse_icon_data (value);
+      data_gicon = parse_icon_data (self, value);
     } else if ((g_strcmp0 (key, "image-path") == 0) ||
                (g_strcmp0 (key, "image_path") == 0)) {
       if (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING)) {
         path_gicon = parse_icon_string (g_variant_get_string (value, NULL));
       }
     } else if (g_strcmp0 (key, "icon_data") == 0) {
-      old_data_gicon = parse_icon_data (value);
+      old_data_gicon = parse_icon_data (self, value);
     } else if ((g_strcmp0 (key, "desktop_entry") == 0) ||
                (g_strcmp0 (key, "desktop-entry") == 0)) {
       if (g_variant_is_of_type (value, G_VARIANT_TYPE_STRING))
@@ -515,12 +688,21 @@ handle_notify (PhoshDBusNotifications *skeleton,
     /* When the app name is set (and isn't notify-send) use that
        as it's better than nothing  */
     source_id = g_strdup_printf ("legacy-app-%s", app_name);
+  } else if (sender) {
+    /* Worse case: We don't know the app, group by connection */
+    source_id = g_strdup_printf ("unknown-app-%s", sender);
   } else {
-    /* Worse case: The notification gets it's own group, we don't know
-       where it came from */
+    /* The notification gets it's own group, we don't know where it came from */
     source_id = g_strdup_printf ("unknown-app-%i", self->unknown_source++);
   }
 
+  /* Coalesce bursts from the same sender and source. Senders like the portal
+   * forward for many apps so never coalesce across sources. Critical
+   * notifications always get their own notification. */
+  rate_key = g_strdup_printf ("%s\n%s", sender ?: "", source_id);
+  if (!replaces_id && urgency != PHOSH_NOTIFICATION_URGENCY_CRITICAL)
+    replaces_id = get_coalesce_id (self, rate_key);
+
   if (replaces_id)
     notification = phosh_notification_list_get_by_id (self->list, replaces_id);
 
@@ -568,6 +750,8 @@ handle_notify (PhoshDBusNotifications *skeleton,
                                            source_id,
                                            expire_timeout,
                                            PHOSH_NOTIFICATION (dbus_notification));
+    if (urgency != PHOSH_NOTIFICATION_URGENCY_CRITICAL)
+      set_last_id (self, rate_key, id);
   }
 
   phosh_dbus_notifications_complete_notify (skeleton, invocation, id);
@@ -657,9 +841,20 @@ phosh_notify_manager_dispose (GObject *object)
     g_dbus_interface_skeleton_unexport (G_DBUS_INTERFACE_SKELETON (self));
 
   g_clear_object (&self->settings);
+  g_clear_object (&self->phosh_settings);
   g_clear_object (&self->feedback);
   g_clear_object (&self->list);
 
+  if (self->images) {
+    GHashTableIter iter;
+    gpointer icon;
+
+    g_hash_table_iter_init (&iter, self->images);
+    while (g_hash_table_iter_next (&iter, NULL, &icon))
+      g_object_weak_unref (G_OBJECT (icon), on_image_finalized, self);
+    g_clear_pointer (&self->images, g_hash_table_destroy);
+  }
+
   G_OBJECT_CLASS (phosh_notify_manager_parent_class)->dispose (object);
 }
 
@@ -670,6 +865,7 @@ phosh_notify_manager_finalize (GObject *object)
   PhoshNotifyManager *self = PHOSH_NOTIFY_MANAGER (object);
 
   g_strfreev (self->app_children);
+  g_hash_table_destroy (self->rate_limits);
 
   G_OBJECT_CLASS (phosh_notify_manager_parent_class)->finalize (object);
 }
@@ -704,6 +900,14 @@ phosh_notify_manager_constructed (GObject *object)
 
   g_signal_connect_swapped (shell, "notify::locked", G_CALLBACK (on_shell_lock_changed), self);
 
+  self->phosh_settings = g_settings_new (PHOSH_NOTIFICATIONS_SCHEMA);
+  g_settings_bind (self->phosh_settings, PHOSH_NOTIFICATIONS_KEY_MAX_PER_APP,
+                   self->list, "max-per-source",
+                   G_SETTINGS_BIND_GET);
+  g_settings_bind (self->phosh_settings, PHOSH_NOTIFICATIONS_KEY_MAX_TOTAL,
+                   self->list, "max-total",
+                   G_SETTINGS_BIND_GET);
+
   self->feedback = phosh_notify_feedback_new (self->list);
 }
 
@@ -762,6 +966,8 @@ phosh_notify_manager_init (PhoshNotifyManager *self)
   self->next_id = 1;
 
   self->list = phosh_notification_list_new ();
+  self->images = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, NULL);
+  self->rate_limits = g_hash_table_new_full (g_str_hash, g_str_equal, g_free, g_free);
 }
 
 /**
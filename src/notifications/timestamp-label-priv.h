@@ -11,6 +11,7 @@
 
 G_BEGIN_DECLS
 
-char *phosh_time_diff_in_words (GDateTime *dt, GDateTime *dt_now);
+char   *phosh_time_diff_in_words    (GDateTime *dt, GDateTime *dt_now);
+gint64  phosh_time_diff_next_update (gint64 dt_us, gint64 now_us, guint *granularity);
 
 G_END_DECLS
@@ -18,15 +18,40 @@
  *
  * The #PhoshTimestampLabel is used to display the time difference between
  * the timestamp stored in the #PhoshTimestampLabel and the current time.
+ *
+ * All labels share a tick per refresh granularity so the labels of
+ * many notifications get updated together rather than each label
+ * waking up on its own. The minute tick is aligned with the wall
+ * clock's minutes.
+ */
+
+/**
+ * TickBucket:
+ *
+ * Labels that refresh at the same granularity. The bucket's timeout is
+ * armed for the earliest label that needs an update.
  */
+typedef struct {
+  guint       granularity;
+  guint       timeout_id;
+  gint64      armed_for;
+  GHashTable *labels;
+} TickBucket;
+
+static TickBucket buckets[] = {
+  { .granularity = 1 },
+  { .granularity = 60 },
+};
 
 
 struct _PhoshTimestampLabel {
-  GtkBin     parent;
+  GtkBin      parent;
+
+  GtkLabel   *label;
+  GDateTime  *date;
 
-  GtkLabel  *label;
-  GDateTime *date;
-  guint      refresh_time;
+  TickBucket *bucket;
+  gint64      next_update;
 };
 
 
@@ -182,90 +207,216 @@ phosh_time_ago_in_words (GDateTime *dt)
   return phosh_time_diff_in_words (dt, dt_now);
 }
 
-static GTimeSpan
-phosh_timestamp_label_calc_timeout (PhoshTimestampLabel *self)
+/**
+ * phosh_time_diff_next_update:
+ * @dt_us: The target time in µs since the epoch
+ * @now_us: The current time in µs since the epoch
+ * @granularity:(out): How precise the update needs to happen in seconds
+ *
+ * Calculates when the text returned by `phosh_time_diff_in_words ()`
+ * for @dt_us changes next.
+ *
+ * Returns: The time of the next update in µs since the epoch
+ */
+gint64
+phosh_time_diff_next_update (gint64 dt_us, gint64 now_us, guint *granularity)
 {
+  gint64 seconds, minutes, hours, days, months;
+  gint64 next;
 
-  g_autoptr (GDateTime) time_now = g_date_time_new_now_local ();
-  g_autoptr (GDateTime) timeout_time = NULL;
-  int seconds, minutes, hours, days, months;
-  double dist_in_seconds;
-  GTimeSpan timeout_diff;
-
-  dist_in_seconds = g_date_time_difference (time_now, self->date) / G_TIME_SPAN_SECOND;
-  seconds = (int) dist_in_seconds;
-  minutes = (int) (dist_in_seconds / SECONDS_PER_MINUTE);
-  hours   = (int) (dist_in_seconds / SECONDS_PER_HOUR);
-  days    = (int) (dist_in_seconds / SECONDS_PER_DAY);
-  months  = (int) (dist_in_seconds / SECONDS_PER_MONTH);
+  seconds = MAX (0, (now_us - dt_us) / G_USEC_PER_SEC);
+  minutes = seconds / SECONDS_PER_MINUTE;
+  hours   = seconds / SECONDS_PER_HOUR;
+  days    = seconds / SECONDS_PER_DAY;
+  months  = seconds / SECONDS_PER_MONTH;
 
   switch (minutes) {
   case 0 ... 1:
-
     switch (seconds) {
     case 0 ... 14:
-      timeout_time = g_date_time_add_seconds (self->date, 15);
+      next = 15;
       break;
     case 15 ... 29:
-      timeout_time = g_date_time_add_seconds (self->date, 30);
+      next = 30;
       break;
     case 30 ... 59:
-      timeout_time = g_date_time_add_minutes (self->date, 1);
+      next = SECONDS_PER_MINUTE;
       break;
     default:
-      timeout_time = g_date_time_add_minutes (self->date, 2);
+      next = 2 * SECONDS_PER_MINUTE;
       break;
     }
     break;
-
   case 2 ... 44:
-    timeout_time = g_date_time_add_minutes (self->date, minutes + 1);
+    next = (minutes + 1) * SECONDS_PER_MINUTE;
     break;
   case 45 ... 89:
-    timeout_time = g_date_time_add_minutes (self->date, 90);
+    next = 90 * SECONDS_PER_MINUTE;
     break;
   case 90 ... 1439:
-    timeout_time = g_date_time_add_hours (self->date, hours + 1);
+    next = (hours + 1) * SECONDS_PER_HOUR;
     break;
   case 1440 ... 43199:
-    timeout_time = g_date_time_add_days (self->date, days + 1);
-    break;
-  case 43200 ... 525600:
-    timeout_time = g_date_time_add_months (self->date, months + 1);
+    next = (days + 1) * SECONDS_PER_DAY;
     break;
   default:
-    timeout_time = g_date_time_add_months (self->date, months + 1);
+    next = (months + 1) * SECONDS_PER_MONTH;
     break;
   }
-  timeout_diff = g_date_time_difference (timeout_time, time_now);
-  g_debug ("time out duration: %" G_GINT64_FORMAT, timeout_diff);
-  return timeout_diff;
+
+  /* Only recent timestamps need updates to the second */
+  *granularity = next <= 2 * SECONDS_PER_MINUTE ? 1 : 60;
+
+  return dt_us + next * G_USEC_PER_SEC;
+}
+
+
+static gboolean on_bucket_tick (gpointer data);
+
+
+static void
+tick_bucket_arm (TickBucket *bucket)
+{
+  GHashTableIter iter;
+  gpointer key;
+  gint64 next = G_MAXINT64;
+  gint64 now, timeout;
+
+  g_hash_table_iter_init (&iter, bucket->labels);
+  while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    PhoshTimestampLabel *label = key;
+
+    next = MIN (next, label->next_update);
+  }
+
+  if (next == bucket->armed_for && bucket->timeout_id)
+    return;
+
+  g_clear_handle_id (&bucket->timeout_id, g_source_remove);
+  bucket->armed_for = 0;
+
+  if (next == G_MAXINT64)
+    return;
+
+  /* Recheck at least hourly in case the wall clock changed */
+  now = g_get_real_time ();
+  timeout = CLAMP (next - now, 0, G_USEC_PER_SEC * SECONDS_PER_HOUR);
+
+  bucket->armed_for = next;
+  bucket->timeout_id = g_timeout_add (timeout / 1000, on_bucket_tick, bucket);
+  g_source_set_name_by_id (bucket->timeout_id, "[PhoshTimestampLabel] tick");
+}
+
+
+static void
+tick_bucket_remove (PhoshTimestampLabel *self)
+{
+  TickBucket *bucket = self->bucket;
+
+  if (bucket == NULL)
+    return;
+
+  self->bucket = NULL;
+  g_hash_table_remove (bucket->labels, self);
+  tick_bucket_arm (bucket);
+}
+
+
+static void
+tick_bucket_add (PhoshTimestampLabel *self, gint64 next_update, guint granularity)
+{
+  TickBucket *bucket = NULL;
+  gint64 step;
+
+  for (int i = 0; i < G_N_ELEMENTS (buckets); i++) {
+    if (buckets[i].granularity == granularity)
+      bucket = &buckets[i];
+  }
+  g_return_if_fail (bucket);
+
+  if (self->bucket != bucket)
+    tick_bucket_remove (self);
+
+  /* Round up to the bucket's granularity so labels get updated together */
+  step = (gint64) granularity * G_USEC_PER_SEC;
+  self->next_update = ((next_update + step - 1) / step) * step;
+  self->bucket = bucket;
+
+  if (bucket->labels == NULL)
+    bucket->labels = g_hash_table_new (g_direct_hash, g_direct_equal);
+  g_hash_table_add (bucket->labels, self);
+
+  tick_bucket_arm (bucket);
 }
 
 
+static void phosh_timestamp_label_update (PhoshTimestampLabel *self);
+
+
 static gboolean
+on_bucket_tick (gpointer data)
+{
+  TickBucket *bucket = data;
+  g_autoptr (GPtrArray) due = g_ptr_array_new_with_free_func (g_object_unref);
+  GHashTableIter iter;
+  gpointer key;
+  gint64 now;
+
+  bucket->timeout_id = 0;
+  bucket->armed_for = 0;
+
+  /* The wall clock and the main loop's clock can drift a bit apart */
+  now = g_get_real_time () + G_USEC_PER_SEC / 2;
+
+  g_hash_table_iter_init (&iter, bucket->labels);
+  while (g_hash_table_iter_next (&iter, &key, NULL)) {
+    PhoshTimestampLabel *label = key;
+
+    if (label->next_update <= now) {
+      g_ptr_array_add (due, g_object_ref (label));
+      label->bucket = NULL;
+      g_hash_table_iter_remove (&iter);
+    }
+  }
+
+  g_debug ("Updating %u timestamp labels, granularity %us", due->len, bucket->granularity);
+  for (guint i = 0; i < due->len; i++) {
+    PhoshTimestampLabel *label = g_ptr_array_index (due, i);
+
+    /* Updating a label might have disposed another one */
+    if (label->date == NULL)
+      continue;
+
+    phosh_timestamp_label_update (label);
+  }
+
+  tick_bucket_arm (bucket);
+
+  return G_SOURCE_REMOVE;
+}
+
+
+static void
 phosh_timestamp_label_update (PhoshTimestampLabel *self)
 {
   g_autofree char *str = NULL;
 
   if (self->date != NULL) {
-    GTimeSpan time;
+    gint64 date_us, next_update;
+    guint granularity;
 
     str = phosh_time_ago_in_words (self->date);
     gtk_label_set_label (self->label, str);
 
-    g_clear_handle_id (&(self->refresh_time), g_source_remove);
-    time = phosh_timestamp_label_calc_timeout (self);
-    self->refresh_time = g_timeout_add (time / G_TIME_SPAN_MILLISECOND,
-                                        (GSourceFunc) phosh_timestamp_label_update,
-                                        self);
-    g_source_set_name_by_id (self->refresh_time, "[PhoshTimestampLable] refresh");
+    date_us = g_date_time_to_unix (self->date) * G_USEC_PER_SEC +
+      g_date_time_get_microsecond (self->date);
+    next_update = phosh_time_diff_next_update (date_us, g_get_real_time (), &granularity);
+    tick_bucket_add (self, next_update, granularity);
   } else {
     gtk_label_set_label (self->label, "");
 
-    g_clear_handle_id (&(self->refresh_time), g_source_remove);
+    tick_bucket_remove (self);
   }
-  return G_SOURCE_REMOVE;
 }
 
 
@@ -313,7 +464,7 @@ phosh_timestamp_label_dispose (GObject *object)
   PhoshTimestampLabel *self = PHOSH_TIMESTAMP_LABEL (object);
 
   g_clear_pointer (&self->date, g_date_time_unref);
-  g_clear_handle_id (&(self->refresh_time), g_source_remove);
+  tick_bucket_remove (self);
 
   G_OBJECT_CLASS (phosh_timestamp_label_parent_class)->dispose (object);
 }
@@ -0,0 +1,518 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#define G_LOG_DOMAIN "phosh-pixel-convert"
+
+#include "phosh-config.h"
+
+#include "pixel-convert.h"
+
+#include <string.h>
+
+#if (defined (__x86_64__) || defined (__i386__)) && defined (__GNUC__)
+# define PHOSH_PIXEL_CONVERT_X86
+# include <immintrin.h>
+#endif
+
+#if defined (__ARM_NEON) && G_BYTE_ORDER == G_LITTLE_ENDIAN
+# define PHOSH_PIXEL_CONVERT_ARM_NEON
+# include <arm_neon.h>
+#endif
+
+/* Edge length of the blocks used when rotating by 90 or 270 degrees */
+#define TILE_SIZE 32
+
+/**
+ * PhoshPixelConvert:
+ *
+ * Conversion of 32 bit pixels as delivered by e.g. wlr-screencopy
+ * into the formats used by cairo and GdkPixbuf.
+ *
+ * The per pixel operations (channel swaps, alpha handling) are done by
+ * row kernels that use SIMD instructions when the CPU supports them,
+ * the best implementation is picked at runtime. Flips and rotations
+ * are done while copying rows so a whole conversion is a single pass
+ * over the data.
+ */
+
+typedef void (*ConvertRowFunc) (guint32                *dest,
+                                const guint32          *src,
+                                gsize                   n_pixels,
+                                PhoshPixelConvertFlags  flags);
+
+static PhoshPixelConvertImpl impl = -1;
+static ConvertRowFunc convert_row;
+
+
+static inline guint32
+mul_div_255 (guint32 c, guint32 a)
+{
+  guint32 t = c * a + 128;
+
+  return (t + (t >> 8)) >> 8;
+}
+
+
+static inline guint32
+convert_pixel (guint32 px, PhoshPixelConvertFlags flags)
+{
+  if (flags & PHOSH_PIXEL_CONVERT_SWAP_RB)
+    px = (px & 0xFF00FF00) | ((px >> 16) & 0xFF) | ((px & 0xFF) << 16);
+
+  if (flags & PHOSH_PIXEL_CONVERT_OPAQUE) {
+    px |= 0xFF000000;
+  } else if (flags & PHOSH_PIXEL_CONVERT_PREMULTIPLY) {
+    guint32 a = px >> 24;
+
+    px = (a << 24) |
+      (mul_div_255 ((px >> 16) & 0xFF, a) << 16) |
+      (mul_div_255 ((px >> 8) & 0xFF, a) << 8) |
+      mul_div_255 (px & 0xFF, a);
+  }
+
+  return px;
+}
+
+
+static void
+convert_row_scalar (guint32                *dest,
+                    const guint32          *src,
+                    gsize                   n_pixels,
+                    PhoshPixelConvertFlags  flags)
+{
+  for (gsize i = 0; i < n_pixels; i++)
+    dest[i] = convert_pixel (src[i], flags);
+}
+
+#ifdef PHOSH_PIXEL_CONVERT_X86
+
+__attribute__ ((target ("sse2")))
+static inline __m128i
+premultiply_sse2 (__m128i px)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i bias = _mm_set1_epi16 (128);
+  const __m128i alpha_mask = _mm_set1_epi32 (0xFF000000);
+  __m128i lo, hi, alo, ahi;
+
+  /* Widen to 16 bit, two pixels per register */
+  lo = _mm_unpacklo_epi8 (px, zero);
+  hi = _mm_unpackhi_epi8 (px, zero);
+  alo = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (lo, 0xFF), 0xFF);
+  ahi = _mm_shufflehi_epi16 (_mm_shufflelo_epi16 (hi, 0xFF), 0xFF);
+
+  lo = _mm_add_epi16 (_mm_mullo_epi16 (lo, alo), bias);
+  lo = _mm_srli_epi16 (_mm_add_epi16 (lo, _mm_srli_epi16 (lo, 8)), 8);
+  hi = _mm_add_epi16 (_mm_mullo_epi16 (hi, ahi), bias);
+  hi = _mm_srli_epi16 (_mm_add_epi16 (hi, _mm_srli_epi16 (hi, 8)), 8);
+
+  return _mm_or_si128 (_mm_andnot_si128 (alpha_mask, _mm_packus_epi16 (lo, hi)),
+                       _mm_and_si128 (px, alpha_mask));
+}
+
+
+__attribute__ ((target ("sse2")))
+static void
+convert_row_sse2 (guint32                *dest,
+                  const guint32          *src,
+                  gsize                   n_pixels,
+                  PhoshPixelConvertFlags  flags)
+{
+  const __m128i mask_ag = _mm_set1_epi32 (0xFF00FF00);
+  const __m128i mask_low = _mm_set1_epi32 (0x000000FF);
+  const __m128i alpha = _mm_set1_epi32 (0xFF000000);
+  gsize i = 0;
+
+  for (; i + 4 <= n_pixels; i += 4) {
+    __m128i px = _mm_loadu_si128 ((const __m128i *)(src + i));
+
+    if (flags & PHOSH_PIXEL_CONVERT_SWAP_RB) {
+      px = _mm_or_si128 (_mm_and_si128 (px, mask_ag),
+                         _mm_or_si128 (_mm_and_si128 (_mm_srli_epi32 (px, 16), mask_low),
+                                       _mm_slli_epi32 (_mm_and_si128 (px, mask_low), 16)));
+    }
+
+    if (flags & PHOSH_PIXEL_CONVERT_OPAQUE)
+      px = _mm_or_si128 (px, alpha);
+    else if (flags & PHOSH_PIXEL_CONVERT_PREMULTIPLY)
+      px = premultiply_sse2 (px);
+
+    _mm_storeu_si128 ((__m128i *)(dest + i), px);
+  }
+
+  convert_row_scalar (dest + i, src + i, n_pixels - i, flags);
+}
+
+
+__attribute__ ((target ("avx2")))
+static inline __m256i
+premultiply_avx2 (__m256i px)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i bias = _mm256_set1_epi16 (128);
+  const __m256i alpha_mask = _mm256_set1_epi32 (0xFF000000);
+  __m256i lo, hi, alo, ahi;
+
+  /* Unpacking and packing both work per 128 bit lane so the pixel order is kept */
+  lo = _mm256_unpacklo_epi8 (px, zero);
+  hi = _mm256_unpackhi_epi8 (px, zero);
+  alo = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (lo, 0xFF), 0xFF);
+  ahi = _mm256_shufflehi_epi16 (_mm256_shufflelo_epi16 (hi, 0xFF), 0xFF);
+
+  lo = _mm256_add_epi16 (_mm256_mullo_epi16 (lo, alo), bias);
+  lo = _mm256_srli_epi16 (_mm256_add_epi16 (lo, _mm256_srli_epi16 (lo, 8)), 8);
+  hi = _mm256_add_epi16 (_mm256_mullo_epi16 (hi, ahi), bias);
+  hi = _mm256_srli_epi16 (_mm256_add_epi16 (hi, _mm256_srli_epi16 (hi, 8)), 8);
+
+  return _mm256_or_si256 (_mm256_andnot_si256 (alpha_mask, _mm256_packus_epi16 (lo, hi)),
+                          _mm256_and_si256 (px, alpha_mask));
+}
+
+
+__attribute__ ((target ("avx2")))
+static void
+convert_row_avx2 (guint32                *dest,
+                  const guint32          *src,
+                  gsize                   n_pixels,
+                  PhoshPixelConvertFlags  flags)
+{
+  const __m256i swap_rb = _mm256_setr_epi8 (2, 1, 0, 3, 6, 5, 4, 7,
+                                            10, 9, 8, 11, 14, 13, 12, 15,
+                                            2, 1, 0, 3, 6, 5, 4, 7,
+                                            10, 9, 8, 11, 14, 13, 12, 15);
+  const __m256i alpha = _mm256_set1_epi32 (0xFF000000);
+  gsize i = 0;
+
+  for (; i + 8 <= n_pixels; i += 8) {
+    __m256i px = _mm256_loadu_si256 ((const __m256i *)(src + i));
+
+    if (flags & PHOSH_PIXEL_CONVERT_SWAP_RB)
+      px = _mm256_shuffle_epi8 (px, swap_rb);
+
+    if (flags & PHOSH_PIXEL_CONVERT_OPAQUE)
+      px = _mm256_or_si256 (px, alpha);
+    else if (flags & PHOSH_PIXEL_CONVERT_PREMULTIPLY)
+      px = premultiply_avx2 (px);
+
+    _mm256_storeu_si256 ((__m256i *)(dest + i), px);
+  }
+
+  convert_row_scalar (dest + i, src + i, n_pixels - i, flags);
+}
+
+#endif /* PHOSH_PIXEL_CONVERT_X86 */
+
+#ifdef PHOSH_PIXEL_CONVERT_ARM_NEON
+
+static inline uint8x8_t
+mul_div_255_neon (uint8x8_t c, uint8x8_t a)
+{
+  uint16x8_t t = vmlal_u8 (vdupq_n_u16 (128), c, a);
+
+  return vshrn_n_u16 (vsraq_n_u16 (t, t, 8), 8);
+}
+
+
+static void
+convert_row_neon (guint32                *dest,
+                  const guint32          *src,
+                  gsize                   n_pixels,
+                  PhoshPixelConvertFlags  flags)
+{
+  gsize i = 0;
+
+  for (; i + 8 <= n_pixels; i += 8) {
+    /* De-interleaves into B, G, R, A planes (little endian byte order) */
+    uint8x8x4_t px = vld4_u8 ((const uint8_t *)(src + i));
+
+    if (flags & PHOSH_PIXEL_CONVERT_SWAP_RB) {
+      uint8x8_t tmp = px.val[0];
+
+      px.val[0] = px.val[2];
+      px.val[2] = tmp;
+    }
+
+    if (flags & PHOSH_PIXEL_CONVERT_OPAQUE) {
+      px.val[3] = vdup_n_u8 (0xFF);
+    } else if (flags & PHOSH_PIXEL_CONVERT_PREMULTIPLY) {
+      px.val[0] = mul_div_255_neon (px.val[0], px.val[3]);
+      px.val[1] = mul_div_255_neon (px.val[1], px.val[3]);
+      px.val[2] = mul_div_255_neon (px.val[2], px.val[3]);
+    }
+
+    vst4_u8 ((uint8_t *)(dest + i), px);
+  }
+
+  convert_row_scalar (dest + i, src + i, n_pixels - i, flags);
+}
+
+#endif /* PHOSH_PIXEL_CONVERT_ARM_NEON */
+
+
+static gboolean
+impl_supported (PhoshPixelConvertImpl candidate)
+{
+  switch (candidate) {
+  case PHOSH_PIXEL_CONVERT_IMPL_SCALAR:
+    return TRUE;
+#ifdef PHOSH_PIXEL_CONVERT_X86
+  case PHOSH_PIXEL_CONVERT_IMPL_SSE2:
+    return __builtin_cpu_supports ("sse2");
+  case PHOSH_PIXEL_CONVERT_IMPL_AVX2:
+    return __builtin_cpu_supports ("avx2");
+#endif
+#ifdef PHOSH_PIXEL_CONVERT_ARM_NEON
+  case PHOSH_PIXEL_CONVERT_IMPL_NEON:
+    return TRUE;
+#endif
+  default:
+    return FALSE;
+  }
+}
+
+
+static ConvertRowFunc
+impl_get_func (PhoshPixelConvertImpl candidate)
+{
+  switch (candidate) {
+#ifdef PHOSH_PIXEL_CONVERT_X86
+  case PHOSH_PIXEL_CONVERT_IMPL_SSE2:
+    return convert_row_sse2;
+  case PHOSH_PIXEL_CONVERT_IMPL_AVX2:
+    return convert_row_avx2;
+#endif
+#ifdef PHOSH_PIXEL_CONVERT_ARM_NEON
+  case PHOSH_PIXEL_CONVERT_IMPL_NEON:
+    return convert_row_neon;
+#endif
+  case PHOSH_PIXEL_CONVERT_IMPL_SCALAR:
+  default:
+    return convert_row_scalar;
+  }
+}
+
+
+static ConvertRowFunc
+get_convert_row (void)
+{
+  static gsize initialized;
+
+  if (g_once_init_enter (&initialized)) {
+    const PhoshPixelConvertImpl preferred[] = {
+      PHOSH_PIXEL_CONVERT_IMPL_AVX2,
+      PHOSH_PIXEL_CONVERT_IMPL_NEON,
+      PHOSH_PIXEL_CONVERT_IMPL_SSE2,
+    };
+
+    impl = PHOSH_PIXEL_CONVERT_IMPL_SCALAR;
+    for (int i = 0; i < G_N_ELEMENTS (preferred); i++) {
+      if (impl_supported (preferred[i])) {
+        impl = preferred[i];
+        break;
+      }
+    }
+    convert_row = impl_get_func (impl);
+    g_debug ("Using %s pixel conversion", phosh_pixel_convert_impl_to_string (impl));
+
+    g_once_init_leave (&initialized, 1);
+  }
+
+  return convert_row;
+}
+
+/**
+ * phosh_pixel_convert_row:
+ * @dest: The destination pixels
+ * @src: The source pixels
+ * @n_pixels: The number of pixels to convert
+ * @flags: The operations to apply
+ *
+ * Converts a row of pixels. @dest and @src may be the same. The
+ * %PHOSH_PIXEL_CONVERT_FLIP_Y flag is ignored.
+ */
+void
+phosh_pixel_convert_row (guint32                *dest,
+                         const guint32          *src,
+                         gsize                   n_pixels,
+                         PhoshPixelConvertFlags  flags)
+{
+  ConvertRowFunc func = get_convert_row ();
+
+  flags &= ~PHOSH_PIXEL_CONVERT_FLIP_Y;
+
+  if (flags == PHOSH_PIXEL_CONVERT_NONE) {
+    if (dest != src)
+      memcpy (dest, src, n_pixels * sizeof (guint32));
+    return;
+  }
+
+  func (dest, src, n_pixels, flags);
+}
+
+
+#define ROW(base, stride, y) ((guint32 *)((base) + (gssize)(y) * (stride)))
+
+/**
+ * phosh_pixel_convert:
+ * @dest: The destination image
+ * @dest_stride: The destination's stride in bytes
+ * @src: The source image
+ * @src_stride: The source's stride in bytes
+ * @width: The source's width in pixels
+ * @height: The source's height in pixels
+ * @rotation: The rotation to apply
+ * @flags: The operations to apply
+ *
+ * Converts a whole image in a single pass. The source is flipped
+ * (if requested) before being rotated. For rotations by 90 and 270
+ * degrees @dest is @height pixels wide and @width pixels high.
+ *
+ * The conversion can happen in place if @rotation is
+ * %PHOSH_PIXEL_ROTATE_0 and the strides match.
+ */
+void
+phosh_pixel_convert (guint8                 *dest,
+                     int                     dest_stride,
+                     const guint8           *src,
+                     int                     src_stride,
+                     int                     width,
+                     int                     height,
+                     PhoshPixelRotation      rotation,
+                     PhoshPixelConvertFlags  flags)
+{
+  gboolean in_place = (dest == src);
+  gssize stride = src_stride;
+
+  g_return_if_fail (dest);
+  g_return_if_fail (src);
+  g_return_if_fail (!in_place || (rotation == PHOSH_PIXEL_ROTATE_0 && dest_stride == src_stride));
+
+  if (width <= 0 || height <= 0)
+    return;
+
+  if (in_place && (flags & PHOSH_PIXEL_CONVERT_FLIP_Y)) {
+    g_autofree guint32 *tmp = g_new (guint32, width);
+
+    for (int y = 0; y < (height + 1) / 2; y++) {
+      guint32 *top = ROW (dest, dest_stride, y);
+      guint32 *bottom = ROW (dest, dest_stride, height - 1 - y);
+
+      phosh_pixel_convert_row (tmp, top, width, flags);
+      phosh_pixel_convert_row (top, bottom, width, flags);
+      memcpy (bottom, tmp, width * sizeof (guint32));
+    }
+    return;
+  }
+
+  if (flags & PHOSH_PIXEL_CONVERT_FLIP_Y) {
+    src = (const guint8 *)ROW (src, stride, height - 1);
+    stride = -stride;
+  }
+
+  switch (rotation) {
+  case PHOSH_PIXEL_ROTATE_0:
+    for (int y = 0; y < height; y++)
+      phosh_pixel_convert_row (ROW (dest, dest_stride, y), ROW (src, stride, y), width, flags);
+    break;
+
+  case PHOSH_PIXEL_ROTATE_180:
+    for (int y = 0; y < height; y++) {
+      guint32 *d = ROW (dest, dest_stride, y);
+      const guint32 *s = ROW (src, stride, height - 1 - y);
+
+      for (int x = 0; x < width; x++)
+        d[x] = s[width - 1 - x];
+      phosh_pixel_convert_row (d, d, width, flags);
+    }
+    break;
+
+  case PHOSH_PIXEL_ROTATE_90:
+  case PHOSH_PIXEL_ROTATE_270: {
+    /* Rotated dimensions */
+    int dw = height, dh = width;
+
+    /* Go over the destination in tiles to keep source reads cache friendly */
+    for (int ty = 0; ty < dh; ty += TILE_SIZE) {
+      for (int tx = 0; tx < dw; tx += TILE_SIZE) {
+        int ty_end = MIN (ty + TILE_SIZE, dh);
+        int tx_end = MIN (tx + TILE_SIZE, dw);
+
+        for (int y = ty; y < ty_end; y++) {
+          guint32 *d = ROW (dest, dest_stride, y);
+
+          if (rotation == PHOSH_PIXEL_ROTATE_90) {
+            for (int x = tx; x < tx_end; x++)
+              d[x] = ROW (src, stride, x)[width - 1 - y];
+          } else {
+            for (int x = tx; x < tx_end; x++)
+              d[x] = ROW (src, stride, height - 1 - x)[y];
+          }
+          phosh_pixel_convert_row (d + tx, d + tx, tx_end - tx, flags);
+        }
+      }
+    }
+    break;
+  }
+
+  default:
+    g_return_if_reached ();
+  }
+}
+
+/**
+ * phosh_pixel_convert_get_impl:
+ *
+ * Gets the implementation currently used for the conversion kernels.
+ *
+ * Returns: The implementation
+ */
+PhoshPixelConvertImpl
+phosh_pixel_convert_get_impl (void)
+{
+  get_convert_row ();
+
+  return impl;
+}
+
+/**
+ * phosh_pixel_convert_set_impl:
+ * @impl: The implementation to use
+ *
+ * Forces a specific implementation of the conversion kernels. This is
+ * meant for tests and benchmarks.
+ *
+ * Returns: %TRUE if the implementation is supported on this CPU
+ */
+gboolean
+phosh_pixel_convert_set_impl (PhoshPixelConvertImpl candidate)
+{
+  get_convert_row ();
+
+  if (!impl_supported (candidate))
+    return FALSE;
+
+  impl = candidate;
+  convert_row = impl_get_func (impl);
+  return TRUE;
+}
+
+
+const char *
+phosh_pixel_convert_impl_to_string (PhoshPixelConvertImpl candidate)
+{
+  switch (candidate) {
+  case PHOSH_PIXEL_CONVERT_IMPL_SCALAR:
+    return "scalar";
+  case PHOSH_PIXEL_CONVERT_IMPL_SSE2:
+    return "sse2";
+  case PHOSH_PIXEL_CONVERT_IMPL_AVX2:
+    return "avx2";
+  case PHOSH_PIXEL_CONVERT_IMPL_NEON:
+    return "neon";
+  default:
+    g_return_val_if_reached (NULL);
+  }
+}
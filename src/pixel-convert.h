@@ -0,0 +1,80 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+#pragma once
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+/**
+ * PhoshPixelConvertFlags:
+ * @PHOSH_PIXEL_CONVERT_NONE: Copy pixels as is
+ * @PHOSH_PIXEL_CONVERT_SWAP_RB: Swap the red and blue channels
+ * @PHOSH_PIXEL_CONVERT_OPAQUE: Make all pixels fully opaque
+ * @PHOSH_PIXEL_CONVERT_PREMULTIPLY: Premultiply color channels by alpha
+ * @PHOSH_PIXEL_CONVERT_FLIP_Y: Flip the source image vertically
+ *
+ * Operations applied when converting 32 bit pixels with the alpha
+ * channel in the most significant byte.
+ */
+typedef enum {
+  PHOSH_PIXEL_CONVERT_NONE        = 0,
+  PHOSH_PIXEL_CONVERT_SWAP_RB     = (1 << 0),
+  PHOSH_PIXEL_CONVERT_OPAQUE      = (1 << 1),
+  PHOSH_PIXEL_CONVERT_PREMULTIPLY = (1 << 2),
+  PHOSH_PIXEL_CONVERT_FLIP_Y      = (1 << 3),
+} PhoshPixelConvertFlags;
+
+/**
+ * PhoshPixelRotation:
+ * @PHOSH_PIXEL_ROTATE_0: No rotation
+ * @PHOSH_PIXEL_ROTATE_90: Rotate by 90 degrees counter clockwise
+ * @PHOSH_PIXEL_ROTATE_180: Rotate by 180 degrees
+ * @PHOSH_PIXEL_ROTATE_270: Rotate by 270 degrees counter clockwise
+ *
+ * Rotations, matching the ones of `gdk_pixbuf_rotate_simple()`.
+ */
+typedef enum {
+  PHOSH_PIXEL_ROTATE_0   = 0,
+  PHOSH_PIXEL_ROTATE_90  = 90,
+  PHOSH_PIXEL_ROTATE_180 = 180,
+  PHOSH_PIXEL_ROTATE_270 = 270,
+} PhoshPixelRotation;
+
+/**
+ * PhoshPixelConvertImpl:
+ * @PHOSH_PIXEL_CONVERT_IMPL_SCALAR: Plain C
+ * @PHOSH_PIXEL_CONVERT_IMPL_SSE2: x86 SSE2
+ * @PHOSH_PIXEL_CONVERT_IMPL_AVX2: x86 AVX2
+ * @PHOSH_PIXEL_CONVERT_IMPL_NEON: ARM NEON
+ *
+ * The implementations of the pixel conversion kernels.
+ */
+typedef enum {
+  PHOSH_PIXEL_CONVERT_IMPL_SCALAR = 0,
+  PHOSH_PIXEL_CONVERT_IMPL_SSE2,
+  PHOSH_PIXEL_CONVERT_IMPL_AVX2,
+  PHOSH_PIXEL_CONVERT_IMPL_NEON,
+} PhoshPixelConvertImpl;
+
+void                  phosh_pixel_convert_row (guint32                *dest,
+                                               const guint32          *src,
+                                               gsize                   n_pixels,
+                                               PhoshPixelConvertFlags  flags);
+void                  phosh_pixel_convert     (guint8                 *dest,
+                                               int                     dest_stride,
+                                               const guint8           *src,
+                                               int                     src_stride,
+                                               int                     width,
+                                               int                     height,
+                                               PhoshPixelRotation      rotation,
+                                               PhoshPixelConvertFlags  flags);
+
+PhoshPixelConvertImpl phosh_pixel_convert_get_impl (void);
+gboolean              phosh_pixel_convert_set_impl (PhoshPixelConvertImpl impl);
+const char           *phosh_pixel_convert_impl_to_string (PhoshPixelConvertImpl impl);
+
+G_END_DECLS
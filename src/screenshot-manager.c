@@ -12,6 +12,7 @@
 #include "phosh-config.h"
 #include "fader.h"
 #include "phosh-wayland.h"
+#include "pixel-convert.h"
 #include "notifications/notify-manager.h"
 #include "screenshot-manager.h"
 #include "shell-priv.h"
@@ -32,6 +33,11 @@
 
 #define FLASH_FADER_TIMEOUT 500
 
+/* Threads used to compose and encode screenshots */
+#define SCREENSHOT_MAX_WORKERS 2
+/* zlib level used for PNGs put on the clipboard */
+#define CLIPBOARD_PNG_COMPRESSION "1"
+
 /**
  * PhoshScreenshotManager:
  *
@@ -54,7 +60,6 @@ typedef struct _ScreencopyFrame {
   struct zwlr_screencopy_frame_v1 *frame;
   uint32_t                         flags;
   PhoshWlBuffer                   *buffer;
-  GdkPixbuf                       *pixbuf;
   PhoshMonitor                    *monitor;
   ScreencopyFrameState             state;
   PhoshScreenshotManager          *manager;
@@ -96,6 +101,7 @@ typedef struct _PhoshScreenshotManager {
   guint                              opaque_id;
 
   GdkPixbuf                         *for_clipboard;
+  GBytes                            *clipboard_png;
 
   GStrv                              action_names;
   GSettings                         *settings;
@@ -128,9 +134,8 @@ slurp_area_dispose (SlurpArea *slurp)
 static void
 screencopy_frame_dispose (ScreencopyFrame *frame)
 {
-  g_clear_pointer (&frame->buffer, phosh_wl_buffer_destroy);
+  g_clear_pointer (&frame->buffer, phosh_wl_buffer_release);
   g_clear_pointer (&frame->frame, zwlr_screencopy_frame_v1_destroy);
-  g_clear_object (&frame->pixbuf);
 
   if (frame->monitor) {
     g_object_remove_weak_pointer (G_OBJECT (frame->monitor), (gpointer)&frame->monitor);
@@ -164,7 +169,8 @@ screencopy_frame_handle_buffer (void                            *data,
   ScreencopyFrame *screencopy_frame = data;
 
   g_debug ("Handling buffer %dx%d for %s", width, height, screencopy_frame->monitor->name);
-  screencopy_frame->buffer = phosh_wl_buffer_new (format, width, height, stride);
+  screencopy_frame->buffer = phosh_wl_buffer_pool_acquire (phosh_wl_buffer_pool_get_default (),
+                                                            format, width, height, stride);
   g_return_if_fail (screencopy_frame->buffer);
 
   zwlr_screencopy_frame_v1_copy (frame, screencopy_frame->buffer->wl_buffer);
@@ -309,16 +315,186 @@ phosh_screenshot_manager_build_thumbnail_path (const char *uri)
 }
 
 
+typedef struct {
+  GTask           *task;
+  GTaskThreadFunc  func;
+} WorkerJob;
+
+
+static void
+worker_run (gpointer data, gpointer user_data)
+{
+  WorkerJob *job = data;
+  GTask *task = job->task;
+
+  job->func (task,
+             g_task_get_source_object (task),
+             g_task_get_task_data (task),
+             g_task_get_cancellable (task));
+
+  g_object_unref (task);
+  g_free (job);
+}
+
+/**
+ * run_in_worker:
+ * @task: The task to run
+ * @func: The function to run in the worker
+ *
+ * Like `g_task_run_in_thread()` but uses a pool limited to
+ * `SCREENSHOT_MAX_WORKERS` threads so that several large screenshots
+ * in a row don't compete with the rest of the shell for all CPUs.
+ */
+static void
+run_in_worker (GTask *task, GTaskThreadFunc func)
+{
+  static GThreadPool *workers;
+  WorkerJob *job;
+
+  if (workers == NULL)
+    workers = g_thread_pool_new (worker_run, NULL, SCREENSHOT_MAX_WORKERS, FALSE, NULL);
+
+  job = g_new0 (WorkerJob, 1);
+  job->task = g_object_ref (task);
+  job->func = func;
+
+  g_thread_pool_push (workers, job, NULL);
+}
+
+
+typedef struct {
+  GdkPixbuf     *pixbuf;
+  GOutputStream *stream;
+  /* Scale to this size before encoding if > 0 */
+  int            width;
+  int            height;
+  GStrv          keys;
+  GStrv          values;
+} EncodeData;
+
+
+static void
+encode_data_free (EncodeData *data)
+{
+  g_clear_object (&data->pixbuf);
+  g_clear_object (&data->stream);
+  g_strfreev (data->keys);
+  g_strfreev (data->values);
+  g_free (data);
+}
+
+
+static void
+encode_png_in_thread (GTask        *task,
+                      gpointer      source_object,
+                      gpointer      task_data,
+                      GCancellable *cancel)
+{
+  EncodeData *data = task_data;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+  g_autofree char *buffer = NULL;
+  gsize size;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  if (data->width > 0 && data->height > 0) {
+    pixbuf = gdk_pixbuf_scale_simple (data->pixbuf, data->width, data->height, GDK_INTERP_BILINEAR);
+  } else {
+    pixbuf = g_object_ref (data->pixbuf);
+  }
+
+  if (data->stream) {
+    if (!gdk_pixbuf_save_to_streamv (pixbuf, data->stream, "png", data->keys, data->values,
+                                     cancel, &err)) {
+      g_task_return_error (task, g_steal_pointer (&err));
+      return;
+    }
+    g_task_return_pointer (task, NULL, NULL);
+    return;
+  }
+
+  if (!gdk_pixbuf_save_to_bufferv (pixbuf, &buffer, &size, "png", data->keys, data->values, &err)) {
+    g_task_return_error (task, g_steal_pointer (&err));
+    return;
+  }
+
+  g_task_return_pointer (task,
+                         g_bytes_new_take (g_steal_pointer (&buffer), size),
+                         (GDestroyNotify) g_bytes_unref);
+}
+
+/**
+ * encode_png_async:
+ * @self: The screenshot manager
+ * @pixbuf: The image to encode
+ * @stream:(nullable): The stream to write to
+ * @width: The width to scale to or `0` to keep the size
+ * @height: The height to scale to or `0` to keep the size
+ * @keys:(nullable): The PNG options keys
+ * @values:(nullable): The PNG options values
+ * @callback: The callback
+ * @user_data: The callback's user data
+ *
+ * Scales (if requested) and encodes @pixbuf in a worker thread. If
+ * @stream is %NULL the encoded data is returned as `GBytes`.
+ */
+static void
+encode_png_async (PhoshScreenshotManager *self,
+                  GdkPixbuf              *pixbuf,
+                  GOutputStream          *stream,
+                  int                     width,
+                  int                     height,
+                  const char * const     *keys,
+                  const char * const     *values,
+                  GAsyncReadyCallback     callback,
+                  gpointer                user_data)
+{
+  g_autoptr (GTask) task = g_task_new (self, self->cancel, callback, user_data);
+  EncodeData *data = g_new0 (EncodeData, 1);
+
+  data->pixbuf = g_object_ref (pixbuf);
+  data->stream = stream ? g_object_ref (stream) : NULL;
+  data->width = width;
+  data->height = height;
+  data->keys = g_strdupv ((GStrv) keys);
+  data->values = g_strdupv ((GStrv) values);
+
+  g_task_set_source_tag (task, encode_png_async);
+  g_task_set_task_data (task, data, (GDestroyNotify) encode_data_free);
+  run_in_worker (task, encode_png_in_thread);
+}
+
+
+static GBytes *
+encode_png_finish (PhoshScreenshotManager *self, GAsyncResult *res, GError **err)
+{
+  g_return_val_if_fail (g_task_is_valid (res, self), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (res)) == encode_png_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (res), err);
+}
+
+
+static GdkPixbuf *
+encode_png_get_pixbuf (GAsyncResult *res)
+{
+  EncodeData *data = g_task_get_task_data (G_TASK (res));
+
+  return data->pixbuf;
+}
+
+
 static void
 on_save_thumbnail_ready (GObject      *source_object,
                          GAsyncResult *res,
                          gpointer      user_data)
 {
-  gboolean success;
   g_autoptr (GError) err = NULL;
 
-  success = gdk_pixbuf_save_to_stream_finish (res, &err);
-  if (!success)
+  encode_png_finish (PHOSH_SCREENSHOT_MANAGER (source_object), res, &err);
+  if (err && !g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
     g_warning ("Failed to save thumbnail: %s", err->message);
 }
 
@@ -332,7 +508,6 @@ phosh_screenshot_manager_save_thumbnail (PhoshScreenshotManager *self,
 {
   int width, height;
   double scale;
-  g_autoptr (GdkPixbuf) scaled = NULL;
   g_autoptr (GFile) file = NULL;
   g_autoptr (GFileOutputStream) stream = NULL;
   g_autoptr (GError) err = NULL;
@@ -362,58 +537,161 @@ phosh_screenshot_manager_save_thumbnail (PhoshScreenshotManager *self,
 
   width = gdk_pixbuf_get_width (pixbuf);
   height = gdk_pixbuf_get_height (pixbuf);
-
   scale = (double)THUMBNAIL_SIZE / MAX (width, height);
-  scaled = gdk_pixbuf_scale_simple (pixbuf,
-                                    floor (width * scale + 0.5),
-                                    floor (height * scale + 0.5),
-                                    GDK_INTERP_BILINEAR);
-  gdk_pixbuf_copy_options (pixbuf, scaled);
 
   now = g_date_time_new_now_local();
   mtime_str = g_strdup_printf ("%" G_GINT64_FORMAT, (gint64) g_date_time_to_unix (now));
   width_str = g_strdup_printf ("%d", width);
   height_str = g_strdup_printf ("%d", height);
-  gdk_pixbuf_save_to_stream_async (scaled,
-                                   G_OUTPUT_STREAM (stream),
-                                   "png",
-                                   NULL,
-                                   on_save_thumbnail_ready,
-                                   NULL,
-                                   "tEXt::Thumb::Image::Width", width_str,
-                                   "tEXt::Thumb::Image::Height", height_str,
-                                   "tEXt::Thumb::URI", uri,
-                                   "tEXt::Thumb::MTime", mtime_str,
-                                   "tEXt::Software", "Phosh::Shell",
-                                   NULL);
+
+  /* Scaling happens in the worker too */
+  encode_png_async (self,
+                    pixbuf,
+                    G_OUTPUT_STREAM (stream),
+                    floor (width * scale + 0.5),
+                    floor (height * scale + 0.5),
+                    (const char *[]) {
+                      "tEXt::Thumb::Image::Width",
+                      "tEXt::Thumb::Image::Height",
+                      "tEXt::Thumb::URI",
+                      "tEXt::Thumb::MTime",
+                      "tEXt::Software",
+                      NULL
+                    },
+                    (const char *[]) {
+                      width_str,
+                      height_str,
+                      uri,
+                      mtime_str,
+                      "Phosh::Shell",
+                      NULL
+                    },
+                    on_save_thumbnail_ready,
+                    NULL);
+}
+
+
+typedef struct {
+  GdkPixbuf *pixbuf;
+  GBytes    *png;
+} ClipboardData;
+
+
+static void
+clipboard_data_free (ClipboardData *data)
+{
+  g_clear_object (&data->pixbuf);
+  g_clear_pointer (&data->png, g_bytes_unref);
+  g_free (data);
+}
+
+
+static void
+on_clipboard_get (GtkClipboard     *clipboard,
+                  GtkSelectionData *selection_data,
+                  guint             info,
+                  gpointer          user_data)
+{
+  ClipboardData *data = user_data;
+  GdkAtom target = gtk_selection_data_get_target (selection_data);
+
+  /* Hand out the pre encoded PNG, other formats get encoded on demand */
+  if (data->png && target == gdk_atom_intern_static_string ("image/png")) {
+    gtk_selection_data_set (selection_data,
+                            target,
+                            8,
+                            g_bytes_get_data (data->png, NULL),
+                            g_bytes_get_size (data->png));
+    return;
+  }
+
+  gtk_selection_data_set_pixbuf (selection_data, data->pixbuf);
+}
+
+
+static void
+on_clipboard_clear (GtkClipboard *clipboard, gpointer user_data)
+{
+  clipboard_data_free (user_data);
 }
 
 
 static void
-on_opaque_timeout (gpointer data)
+on_opaque_timeout (gpointer user_data)
 {
-  PhoshScreenshotManager *self = data;
+  PhoshScreenshotManager *self = user_data;
   GdkDisplay *display = gdk_display_get_default ();
   GtkClipboard *clipboard;
+  g_autoptr (GtkTargetList) targets = NULL;
+  GtkTargetEntry *entries;
+  ClipboardData *data;
+  int n_entries;
 
   if (!display) {
     g_critical ("Couldn't get GDK display");
     goto out;
   }
 
+  data = g_new0 (ClipboardData, 1);
+  data->pixbuf = g_steal_pointer (&self->for_clipboard);
+  /* Might not be there yet in which case we encode on demand */
+  data->png = g_steal_pointer (&self->clipboard_png);
+
+  targets = gtk_target_list_new (NULL, 0);
+  gtk_target_list_add_image_targets (targets, 0, TRUE);
+  entries = gtk_target_table_new_from_list (targets, &n_entries);
+
   clipboard = gtk_clipboard_get_for_display (display, GDK_SELECTION_CLIPBOARD);
-  gtk_clipboard_set_image (clipboard, self->for_clipboard);
-  g_debug ("Updated clipboard");
+  if (!gtk_clipboard_set_with_data (clipboard,
+                                    entries,
+                                    n_entries,
+                                    on_clipboard_get,
+                                    on_clipboard_clear,
+                                    data)) {
+    g_warning ("Failed to update clipboard");
+    clipboard_data_free (data);
+  } else {
+    gtk_clipboard_set_can_store (clipboard, NULL, 0);
+    g_debug ("Updated clipboard");
+  }
+  gtk_target_table_free (entries, n_entries);
+
   self->frames->copy_to_clipboard = FALSE;
   screenshot_done (self, TRUE);
 
  out:
   g_clear_object (&self->for_clipboard);
+  g_clear_pointer (&self->clipboard_png, g_bytes_unref);
   g_clear_pointer (&self->opaque, phosh_cp_widget_destroy);
   self->opaque_id = 0;
 }
 
 
+static void
+on_clipboard_png_ready (GObject      *source_object,
+                        GAsyncResult *res,
+                        gpointer      user_data)
+{
+  PhoshScreenshotManager *self = PHOSH_SCREENSHOT_MANAGER (source_object);
+  g_autoptr (GBytes) png = NULL;
+  g_autoptr (GError) err = NULL;
+
+  png = encode_png_finish (self, res, &err);
+  if (!png) {
+    if (!g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+      g_warning ("Failed to encode screenshot for clipboard: %s", err->message);
+    return;
+  }
+
+  /* Clipboard was already updated or a different image is pending */
+  if (self->for_clipboard != encode_png_get_pixbuf (res))
+    return;
+
+  g_clear_pointer (&self->clipboard_png, g_bytes_unref);
+  self->clipboard_png = g_steal_pointer (&png);
+}
+
+
 static void
 copy_to_clipboard (PhoshScreenshotManager *self, GdkPixbuf *pixbuf)
 {
@@ -425,7 +703,21 @@ copy_to_clipboard (PhoshScreenshotManager *self, GdkPixbuf *pixbuf)
                                "style-class", "phosh-fader-screenshot-opaque",
                                "kbd-interactivity", TRUE,
                                NULL);
-  self->for_clipboard = g_object_ref (pixbuf);
+  g_set_object (&self->for_clipboard, pixbuf);
+  g_clear_pointer (&self->clipboard_png, g_bytes_unref);
+
+  /* Encode while the opaque surface is up. Size doesn't matter much
+   * for the clipboard so favour speed over compression */
+  encode_png_async (self,
+                    pixbuf,
+                    NULL,
+                    0,
+                    0,
+                    (const char *[]) { "compression", NULL },
+                    (const char *[]) { CLIPBOARD_PNG_COMPRESSION, NULL },
+                    on_clipboard_png_ready,
+                    NULL);
+
   /* FIXME: Would be better to trigger when the opaque window is up and got
      input focus but all such attempts failed */
   self->opaque_id = g_timeout_add_seconds_once (1, on_opaque_timeout, self);
@@ -440,15 +732,17 @@ on_save_pixbuf_ready (GObject      *source_object,
                       GAsyncResult *res,
                       gpointer      user_data)
 {
-  gboolean success;
+  PhoshScreenshotManager *self = PHOSH_SCREENSHOT_MANAGER (source_object);
+  GdkPixbuf *pixbuf = encode_png_get_pixbuf (res);
   g_autoptr (GError) err = NULL;
-  g_autoptr (PhoshScreenshotManager) self = PHOSH_SCREENSHOT_MANAGER (user_data);
 
-  g_return_if_fail (PHOSH_IS_SCREENSHOT_MANAGER (self));
+  encode_png_finish (self, res, &err);
+  if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
   g_return_if_fail (self->frames->filename);
 
-  success = gdk_pixbuf_save_to_stream_finish (res, &err);
-  if (!success) {
+  if (err) {
     g_warning ("Failed to save screenshot: %s", err->message);
     screenshot_done (self, FALSE);
     return;
@@ -457,14 +751,12 @@ on_save_pixbuf_ready (GObject      *source_object,
   if (!self->frames->invocation)
     update_recent_files (self);
 
-  phosh_screenshot_manager_save_thumbnail (self,
-                                           self->frames->filename,
-                                           GDK_PIXBUF (source_object));
+  phosh_screenshot_manager_save_thumbnail (self, self->frames->filename, pixbuf);
 
   if (self->frames->copy_to_clipboard)
-    copy_to_clipboard (self, GDK_PIXBUF (source_object));
+    copy_to_clipboard (self, pixbuf);
   else
-    screenshot_done (self, success);
+    screenshot_done (self, TRUE);
 }
 
 
@@ -586,79 +878,218 @@ create_internal_file (PhoshScreenshotManager *self, GError **err)
   return NULL;
 }
 
-/* Got all pixbufs, prepare result */
+typedef struct {
+  PhoshWlBuffer *buffer;
+  uint32_t       flags;
+  guint          angle;
+  /* The frame's output in screenshot coordinates */
+  GdkRectangle   output;
+  /* How much this output gets enlarged based on its scale, >= 1.0 */
+  double         zoom;
+} ComposeFrame;
+
+
+typedef struct {
+  GArray       *frames;
+  /* The part of the screenshot that ends up in the image */
+  GdkRectangle  region;
+} ComposeData;
+
+
+static void
+compose_data_free (ComposeData *data)
+{
+  /* Buffers are released in the main thread, see on_compose_ready */
+  g_array_free (data->frames, TRUE);
+  g_free (data);
+}
+
+/**
+ * compose_frame:
+ * @frame: The frame to compose
+ * @dest: The destination pixbuf
+ * @region: The part of the screenshot covered by @dest
+ *
+ * Copies the part of @frame that is visible in @region into
+ * @dest. Without scaling converting to RGBA, undoing the y-inversion
+ * and the output transform happen in a single pass reading directly
+ * from the frame's shm buffer so no intermediate copies are needed.
+ * Scaled outputs are converted once and then scaled bilinearly.
+ */
 static void
-submit_screenshot (PhoshScreenshotManager *self)
+compose_frame (ComposeFrame       *frame,
+               GdkPixbuf          *dest,
+               const GdkRectangle *region)
 {
-  g_autoptr (GError) err = NULL;
-  g_autoptr (GFileOutputStream) stream = NULL;
-  g_autoptr (GFile) file = NULL;
-  g_autoptr (GdkPixbuf) pixbuf = NULL;
-  GdkRectangle box;
-  float screenshot_scale = self->frames->max_scale;
+  PhoshWlBuffer *buffer = frame->buffer;
+  PhoshPixelConvertFlags flags = PHOSH_PIXEL_CONVERT_NONE;
+  const GdkRectangle *output = &frame->output;
+  double zoom = frame->zoom;
+  GdkRectangle rect;
+  guint angle = frame->angle;
+  int tw, th, dest_stride;
+  guint8 *dest_pixels;
+
+  if (!gdk_rectangle_intersect (output, region, &rect))
+    return;
 
-  box = get_output_layout (self);
-  g_debug ("Screenshot of %d,%d %dx%d", box.x, box.y, box.width, box.height);
+  if (angle == 90 || angle == 270) {
+    tw = buffer->height;
+    th = buffer->width;
+  } else {
+    tw = buffer->width;
+    th = buffer->height;
+  }
 
-  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
-                           TRUE,
-                           8,
-                           box.width * screenshot_scale,
-                           box.height * screenshot_scale);
+  /* (A|X)RGB8888 is BGRA in memory, GdkPixbuf wants RGBA */
+  if (buffer->format == WL_SHM_FORMAT_ARGB8888 || buffer->format == WL_SHM_FORMAT_XRGB8888)
+    flags |= PHOSH_PIXEL_CONVERT_SWAP_RB;
+  if (buffer->format == WL_SHM_FORMAT_XRGB8888 || buffer->format == WL_SHM_FORMAT_XBGR8888)
+    flags |= PHOSH_PIXEL_CONVERT_OPAQUE;
+  if (frame->flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT)
+    flags |= PHOSH_PIXEL_CONVERT_FLIP_Y;
 
-  /* TODO: Using cairo would avoid lots of copies */
-  for (GList *l = self->frames->frames; l; l = l->next) {
-    ScreencopyFrame *frame = l->data;
-    float scale;
-    /* how much this monitor gets enlarged based on its scale, >= 1.0 */
-    double zoom;
-    g_autoptr (GdkPixbuf) transformed = NULL;
+  if (zoom != 1.0) {
+    g_autoptr (GdkPixbuf) converted = NULL;
 
-    if (frame->monitor == NULL)
-      continue;
+    converted = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, tw, th);
+    if (converted == NULL) {
+      g_warning ("Failed to allocate %dx%d frame", tw, th);
+      return;
+    }
 
-    scale = phosh_monitor_get_fractional_scale (frame->monitor);
-    zoom = screenshot_scale / scale;
-    g_debug ("Screenshot of '%s' of %d,%d %dx%d, scale: %f",
-             frame->monitor->name,
-             frame->monitor->logical.x - box.x,
-             frame->monitor->logical.y - box.y,
-             frame->monitor->logical.width,
-             frame->monitor->logical.height,
-             scale);
+    phosh_pixel_convert (gdk_pixbuf_get_pixels (converted),
+                         gdk_pixbuf_get_rowstride (converted),
+                         buffer->data,
+                         buffer->stride,
+                         buffer->width,
+                         buffer->height,
+                         angle,
+                         flags);
+    gdk_pixbuf_scale (converted,
+                      dest,
+                      rect.x - region->x,
+                      rect.y - region->y,
+                      rect.width,
+                      rect.height,
+                      output->x - region->x,
+                      output->y - region->y,
+                      zoom, zoom,
+                      GDK_INTERP_BILINEAR);
+    return;
+  }
 
-    /* TODO: handle flips */
-    transformed = gdk_pixbuf_rotate_simple (frame->pixbuf,
-                                            get_angle (frame->monitor->transform));
-    gdk_pixbuf_composite (transformed,
-                          pixbuf,
-                          (frame->monitor->logical.x - box.x) * screenshot_scale,
-                          (frame->monitor->logical.y - box.y) * screenshot_scale,
-                          frame->monitor->logical.width * screenshot_scale,
-                          frame->monitor->logical.height * screenshot_scale,
-                          (frame->monitor->logical.x - box.x) * screenshot_scale,
-                          (frame->monitor->logical.y - box.y) * screenshot_scale,
-                          zoom, zoom,
-                          GDK_INTERP_BILINEAR,
-                          255);
+  dest_pixels = gdk_pixbuf_get_pixels (dest);
+  dest_stride = gdk_pixbuf_get_rowstride (dest);
+  dest_pixels += (rect.y - region->y) * dest_stride + (rect.x - region->x) * 4;
+
+  /* Whole output, the common case */
+  if (gdk_rectangle_equal (&rect, output) &&
+      tw == rect.width && th == rect.height) {
+    phosh_pixel_convert (dest_pixels,
+                         dest_stride,
+                         buffer->data,
+                         buffer->stride,
+                         buffer->width,
+                         buffer->height,
+                         angle,
+                         flags);
+    return;
   }
 
-  if (self->frames->area) {
-    g_autoptr (GdkPixbuf) tmp = pixbuf;
-
-    pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB,
-                             TRUE,
-                             8,
-                             self->frames->area->width * screenshot_scale,
-                             self->frames->area->height * screenshot_scale);
-    gdk_pixbuf_copy_area (tmp,
-                          (self->frames->area->x - box.x) * screenshot_scale,
-                          (self->frames->area->y - box.y) * screenshot_scale,
-                          self->frames->area->width * screenshot_scale,
-                          self->frames->area->height * screenshot_scale,
-                          pixbuf,
-                          0,
-                          0);
+  /* Only part of the output is visible, copy that */
+  for (int y = 0; y < rect.height; y++) {
+    guint32 *d = (guint32 *)(dest_pixels + y * dest_stride);
+    int ty = MIN (rect.y - output->y + y, th - 1);
+
+    for (int x = 0; x < rect.width; x++) {
+      int tx = MIN (rect.x - output->x + x, tw - 1), sx, sy;
+
+      /* gdk-pixbuf's angles are counter clockwise */
+      switch (angle) {
+      case 90:
+        sx = buffer->width - 1 - ty;
+        sy = tx;
+        break;
+      case 180:
+        sx = buffer->width - 1 - tx;
+        sy = buffer->height - 1 - ty;
+        break;
+      case 270:
+        sx = ty;
+        sy = buffer->height - 1 - tx;
+        break;
+      case 0:
+      default:
+        sx = tx;
+        sy = ty;
+        break;
+      }
+
+      if (flags & PHOSH_PIXEL_CONVERT_FLIP_Y)
+        sy = buffer->height - 1 - sy;
+
+      d[x] = *(guint32 *)((guint8 *)buffer->data + sy * buffer->stride + sx * 4);
+    }
+
+    phosh_pixel_convert_row (d, d, rect.width, flags);
+  }
+}
+
+static void
+compose_in_thread (GTask        *task,
+                   gpointer      source_object,
+                   gpointer      task_data,
+                   GCancellable *cancel)
+{
+  ComposeData *data = task_data;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+
+  if (g_task_return_error_if_cancelled (task))
+    return;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, data->region.width, data->region.height);
+  if (pixbuf == NULL) {
+    g_task_return_new_error (task, G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                             "Failed to allocate %dx%d screenshot",
+                             data->region.width, data->region.height);
+    return;
+  }
+
+  /* Areas not covered by any output stay transparent */
+  if (data->frames->len > 1)
+    gdk_pixbuf_fill (pixbuf, 0);
+
+  for (guint i = 0; i < data->frames->len; i++)
+    compose_frame (&g_array_index (data->frames, ComposeFrame, i), pixbuf, &data->region);
+
+  g_task_return_pointer (task, g_steal_pointer (&pixbuf), g_object_unref);
+}
+
+
+static void
+on_compose_ready (GObject      *source_object,
+                  GAsyncResult *res,
+                  gpointer      user_data)
+{
+  PhoshScreenshotManager *self = PHOSH_SCREENSHOT_MANAGER (source_object);
+  ComposeData *data = g_task_get_task_data (G_TASK (res));
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GFileOutputStream) stream = NULL;
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+
+  for (guint i = 0; i < data->frames->len; i++)
+    g_clear_pointer (&g_array_index (data->frames, ComposeFrame, i).buffer, phosh_wl_buffer_release);
+
+  pixbuf = g_task_propagate_pointer (G_TASK (res), &err);
+  if (g_error_matches (err, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+    return;
+
+  if (!pixbuf) {
+    g_warning ("Failed to compose screenshot: %s", err->message);
+    screenshot_done (self, FALSE);
+    return;
   }
 
   if (self->frames->filename) {
@@ -681,17 +1112,83 @@ submit_screenshot (PhoshScreenshotManager *self)
 
   if (stream) {
     /* on_save_to_pixbuf will trigger copy_to_clipboard if needed */
-    gdk_pixbuf_save_to_stream_async (pixbuf,
-                                     G_OUTPUT_STREAM (stream),
-                                     "png",
-                                     self->cancel,
-                                     on_save_pixbuf_ready,
-                                     g_object_ref (self),
-                                     NULL);
+    encode_png_async (self,
+                      pixbuf,
+                      G_OUTPUT_STREAM (stream),
+                      0,
+                      0,
+                      NULL,
+                      NULL,
+                      on_save_pixbuf_ready,
+                      NULL);
   } else if (self->frames->copy_to_clipboard) {
     /* Copy to clipboard only */
     copy_to_clipboard (self, pixbuf);
   }
+}
+
+/* Got all frames, prepare result */
+static void
+submit_screenshot (PhoshScreenshotManager *self)
+{
+  g_autoptr (GTask) task = NULL;
+  ComposeData *data;
+  GdkRectangle box;
+  float screenshot_scale = self->frames->max_scale;
+
+  box = get_output_layout (self);
+  g_debug ("Screenshot of %d,%d %dx%d", box.x, box.y, box.width, box.height);
+
+  data = g_new0 (ComposeData, 1);
+  data->frames = g_array_new (FALSE, TRUE, sizeof (ComposeFrame));
+
+  /* Only allocate what ends up in the final image */
+  if (self->frames->area) {
+    data->region.x = (self->frames->area->x - box.x) * screenshot_scale;
+    data->region.y = (self->frames->area->y - box.y) * screenshot_scale;
+    data->region.width = self->frames->area->width * screenshot_scale;
+    data->region.height = self->frames->area->height * screenshot_scale;
+  } else {
+    data->region.x = 0;
+    data->region.y = 0;
+    data->region.width = box.width * screenshot_scale;
+    data->region.height = box.height * screenshot_scale;
+  }
+
+  for (GList *l = self->frames->frames; l; l = l->next) {
+    ScreencopyFrame *frame = l->data;
+    ComposeFrame compose;
+    float scale;
+
+    if (frame->monitor == NULL)
+      continue;
+
+    scale = phosh_monitor_get_fractional_scale (frame->monitor);
+    g_debug ("Screenshot of '%s' of %d,%d %dx%d, scale: %f",
+             frame->monitor->name,
+             frame->monitor->logical.x - box.x,
+             frame->monitor->logical.y - box.y,
+             frame->monitor->logical.width,
+             frame->monitor->logical.height,
+             scale);
+
+    /* The worker owns the buffer until composing is done */
+    compose.buffer = g_steal_pointer (&frame->buffer);
+    compose.flags = frame->flags;
+    /* TODO: handle flips */
+    compose.angle = get_angle (frame->monitor->transform);
+    compose.zoom = screenshot_scale / scale;
+    compose.output.x = (frame->monitor->logical.x - box.x) * screenshot_scale;
+    compose.output.y = (frame->monitor->logical.y - box.y) * screenshot_scale;
+    compose.output.width = frame->monitor->logical.width * screenshot_scale;
+    compose.output.height = frame->monitor->logical.height * screenshot_scale;
+
+    g_array_append_val (data->frames, compose);
+  }
+
+  task = g_task_new (self, self->cancel, on_compose_ready, NULL);
+  g_task_set_task_data (task, data, (GDestroyNotify) compose_data_free);
+  run_in_worker (task, compose_in_thread);
 
   if (self->frames->flash) {
     phosh_trigger_feedback ("screen-capture");
@@ -748,8 +1245,6 @@ screencopy_frame_handle_ready (void                            *data,
                                uint32_t                         tv_nsec)
 {
   ScreencopyFrame *screencopy_frame = data;
-  g_autoptr (GdkPixbuf) pixbuf = NULL;
-  g_autoptr (GBytes) bytes = NULL;
 
   if (screencopy_frame->monitor == NULL) {
     g_warning ("Output went away during screenshot");
@@ -765,30 +1260,13 @@ screencopy_frame_handle_ready (void                            *data,
            screencopy_frame->buffer->format,
            screencopy_frame->monitor->name);
 
+  /* The frame's buffer is used as is, conversion happens when composing the screenshot */
   switch ((uint32_t) screencopy_frame->buffer->format) {
   case WL_SHM_FORMAT_ABGR8888:
   case WL_SHM_FORMAT_XBGR8888:
-    break;
   case WL_SHM_FORMAT_ARGB8888:
-  case WL_SHM_FORMAT_XRGB8888: { /* ARGB -> ABGR */
-    PhoshWlBuffer *buffer = screencopy_frame->buffer;
-    uint8_t *d = buffer->data;
-    for (int i = 0; i < buffer->height; ++i) {
-      for (int j = 0; j < buffer->width; ++j) {
-        uint32_t *px = (uint32_t *)(d + i * buffer->stride + j * 4);
-        uint8_t a = (*px >> 24) & 0xFF;
-        uint8_t b = (*px >> 16) & 0xFF;
-        uint8_t g = (*px >> 8) & 0xFF;
-        uint8_t r = *px & 0xFF;
-        *px = (a << 24) | (r << 16) | (g << 8) | b;
-      }
-    }
-    if (buffer->format == WL_SHM_FORMAT_ARGB8888)
-      buffer->format = WL_SHM_FORMAT_ABGR8888;
-    else
-      buffer->format = WL_SHM_FORMAT_XBGR8888;
-  }
-  break;
+  case WL_SHM_FORMAT_XRGB8888:
+    break;
   default:
     g_warning ("Unknown buffer formeat 0x%x on %s",
                screencopy_frame->buffer->format,
@@ -797,21 +1275,6 @@ screencopy_frame_handle_ready (void                            *data,
     goto out;
   }
 
-  bytes = phosh_wl_buffer_get_bytes (screencopy_frame->buffer);
-  pixbuf = gdk_pixbuf_new_from_bytes (bytes,
-                                      GDK_COLORSPACE_RGB,
-                                      TRUE,
-                                      8,
-                                      screencopy_frame->buffer->width,
-                                      screencopy_frame->buffer->height,
-                                      screencopy_frame->buffer->stride);
-  if (screencopy_frame->flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT) {
-    GdkPixbuf *tmp = gdk_pixbuf_flip (pixbuf, FALSE);
-    g_object_unref (pixbuf);
-    pixbuf = tmp;
-  }
-
-  screencopy_frame->pixbuf = g_steal_pointer (&pixbuf);
   screencopy_frame->state = FRAME_STATE_SUCCESS;
 
  out:
@@ -1312,6 +1775,7 @@ phosh_screenshot_manager_dispose (GObject *object)
 
   g_clear_pointer (&self->frames, screencopy_frames_dispose);
   g_clear_object (&self->for_clipboard);
+  g_clear_pointer (&self->clipboard_png, g_bytes_unref);
   g_clear_pointer (&self->slurp, slurp_area_dispose);
 
   g_clear_handle_id (&self->fader_id, g_source_remove);
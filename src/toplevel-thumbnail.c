@@ -9,6 +9,7 @@
 #define G_LOG_DOMAIN "phosh-toplevel-thumbnail"
 
 #include "phosh-wayland.h"
+#include "pixel-convert.h"
 #include "shell-priv.h"
 #include "toplevel-thumbnail.h"
 #include "util.h"
@@ -36,6 +37,7 @@ struct _PhoshToplevelThumbnail {
 
   struct zwlr_screencopy_frame_v1 *handle;
   PhoshWlBuffer                   *buffer;
+  uint32_t                         flags;
   gboolean                         ready;
 };
 
@@ -68,7 +70,8 @@ screencopy_handle_buffer (void *data,
     return;
   }
 
-  self->buffer = phosh_wl_buffer_new (format, width, height, stride);
+  self->buffer = phosh_wl_buffer_pool_acquire (phosh_wl_buffer_pool_get_default (),
+                                               format, width, height, stride);
   zwlr_screencopy_frame_v1_copy (zwlr_screencopy_frame_v1, self->buffer->wl_buffer);
 }
 
@@ -77,7 +80,9 @@ screencopy_handle_flags(void *data,
                         struct zwlr_screencopy_frame_v1 *zwlr_screencopy_frame_v1,
                         uint32_t flags)
 {
-  /* Nothing to do */
+  PhoshToplevelThumbnail *self = PHOSH_TOPLEVEL_THUMBNAIL (data);
+
+  self->flags = flags;
 }
 
 static void
@@ -87,7 +92,46 @@ screencopy_handle_ready(void *data,
                         uint32_t tv_sec_lo,
                         uint32_t tv_nsec)
 {
-  phosh_toplevel_thumbnail_set_ready (PHOSH_THUMBNAIL (data), TRUE);
+  PhoshToplevelThumbnail *self = PHOSH_TOPLEVEL_THUMBNAIL (data);
+  PhoshWlBuffer *buffer = self->buffer;
+  PhoshPixelConvertFlags flags = PHOSH_PIXEL_CONVERT_NONE;
+
+  g_return_if_fail (buffer);
+
+  /* Consumers wrap the data in a CAIRO_FORMAT_ARGB32 surface */
+  switch ((uint32_t) buffer->format) {
+  case WL_SHM_FORMAT_ARGB8888:
+    break;
+  case WL_SHM_FORMAT_XRGB8888:
+    flags |= PHOSH_PIXEL_CONVERT_OPAQUE;
+    break;
+  case WL_SHM_FORMAT_ABGR8888:
+    flags |= PHOSH_PIXEL_CONVERT_SWAP_RB;
+    break;
+  case WL_SHM_FORMAT_XBGR8888:
+    flags |= PHOSH_PIXEL_CONVERT_SWAP_RB | PHOSH_PIXEL_CONVERT_OPAQUE;
+    break;
+  default:
+    g_warning ("Unhandled thumbnail format 0x%x", buffer->format);
+    break;
+  }
+
+  if (self->flags & ZWLR_SCREENCOPY_FRAME_V1_FLAGS_Y_INVERT)
+    flags |= PHOSH_PIXEL_CONVERT_FLIP_Y;
+
+  if (flags != PHOSH_PIXEL_CONVERT_NONE) {
+    phosh_pixel_convert (buffer->data,
+                         buffer->stride,
+                         buffer->data,
+                         buffer->stride,
+                         buffer->width,
+                         buffer->height,
+                         PHOSH_PIXEL_ROTATE_0,
+                         flags);
+    buffer->format = WL_SHM_FORMAT_ARGB8888;
+  }
+
+  phosh_toplevel_thumbnail_set_ready (PHOSH_THUMBNAIL (self), TRUE);
 }
 
 static void
@@ -212,7 +256,7 @@ phosh_toplevel_thumbnail_finalize (GObject *object)
 {
   PhoshToplevelThumbnail *self = PHOSH_TOPLEVEL_THUMBNAIL (object);
 
-  g_clear_pointer (&self->buffer, phosh_wl_buffer_destroy);
+  g_clear_pointer (&self->buffer, phosh_wl_buffer_release);
 
   G_OBJECT_CLASS (phosh_toplevel_thumbnail_parent_class)->finalize (object);
 }
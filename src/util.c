@@ -58,53 +58,16 @@ phosh_cp_widget_destroy (void *widget)
  * with X11 and non-GTK applications that may not report the exact same
  * string as their app-id and in their desktop file.
  *
+ * Lookups are cached by the [class@AppListModel].
+ *
  * Returns: (transfer full)(nullable): GDesktopAppInfo for requested app_id
  */
 GDesktopAppInfo *
 phosh_get_desktop_app_info_for_app_id (const char *app_id)
 {
-  g_autofree char *desktop_id = NULL;
-  g_autofree char *lowercase = NULL;
-  GDesktopAppInfo *app_info = NULL;
-  char *last_component;
-  PhoshAppListModel *model = phosh_app_list_model_get_default ();
-
   g_assert (app_id);
 
-  desktop_id = g_strdup_printf ("%s.desktop", app_id);
-  g_return_val_if_fail (desktop_id, NULL);
-  app_info = g_desktop_app_info_new (desktop_id);
-
-  if (app_info)
-    return app_info;
-
-  app_info = phosh_app_list_model_lookup_by_startup_wm_class (model, app_id);
-  if (app_info)
-    return g_object_ref (app_info);
-
-  /* try to handle the case where app-id is rev-DNS, but desktop file is not */
-  last_component = strrchr(app_id, '.');
-  if (last_component) {
-    /* Skip past '.' */
-    last_component++;
-    g_free (desktop_id);
-    desktop_id = g_strdup_printf ("%s.desktop", last_component);
-    g_return_val_if_fail (desktop_id, NULL);
-    app_info = g_desktop_app_info_new (desktop_id);
-    if (app_info)
-      return app_info;
-  }
-
-  /* X11 WM_CLASS is often capitalized, so try in lowercase as well */
-  lowercase = g_utf8_strdown (last_component ?: app_id, -1);
-  g_clear_pointer (&desktop_id, g_free);
-
-  app_info = phosh_app_list_model_lookup_by_startup_wm_class (model, lowercase);
-  if (app_info)
-    return g_object_ref (app_info);
-
-  g_message ("Could not find application for app-id '%s'", app_id);
-  return NULL;
+  return phosh_app_list_model_lookup_app_id (phosh_app_list_model_get_default (), app_id);
 }
 
 /**
@@ -656,6 +619,46 @@ phosh_utils_pixbuf_scale_to_min (GdkPixbuf *src, int min_width, int min_height)
 }
 
 
+/**
+ * phosh_util_create_similar_surface:
+ * @widget: The widget the surface will be drawn on
+ * @image: The image to copy
+ *
+ * Creates a surface that is optimized for drawing onto the widget's
+ * window (e.g. by matching its scale) and copies @image into it. This
+ * allows later redraws to be plain copies. If the widget isn't
+ * realized a reference to @image is returned.
+ *
+ * Returns: (transfer full): The new surface
+ */
+cairo_surface_t *
+phosh_util_create_similar_surface (GtkWidget *widget, cairo_surface_t *image)
+{
+  cairo_surface_t *surface;
+  GdkWindow *window;
+  cairo_t *cr;
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), NULL);
+  g_return_val_if_fail (image != NULL, NULL);
+
+  window = gtk_widget_get_window (widget);
+  if (window == NULL)
+    return cairo_surface_reference (image);
+
+  surface = gdk_window_create_similar_surface (window,
+                                               cairo_surface_get_content (image),
+                                               cairo_image_surface_get_width (image),
+                                               cairo_image_surface_get_height (image));
+  cr = cairo_create (surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+  cairo_set_source_surface (cr, image, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  return surface;
+}
+
+
 static const char *(*app_attr[]) (GAppInfo *info) = {
   g_app_info_get_display_name,
   g_app_info_get_name,
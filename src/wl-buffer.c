@@ -19,6 +19,25 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+/* Upper bound for the memory kept in idle buffers of the default pool */
+#define DEFAULT_POOL_MAX_BYTES (32 * 1024 * 1024)
+
+/**
+ * PhoshWlBufferPool:
+ *
+ * A pool of [struct@WlBuffer]s so that buffers of the same format and
+ * size (e.g. for repeated screencopy requests) don't need to go
+ * through memfd creation, mapping and `wl_shm_pool` setup each
+ * time. Released buffers are kept around until the idle buffers exceed
+ * the pool's memory budget in which case the least recently released
+ * ones are destroyed.
+ */
+struct _PhoshWlBufferPool {
+  GQueue idle;        /* PhoshWlBuffer, most recently released first */
+  gsize  idle_bytes;
+  gsize  max_bytes;
+};
+
 /**
  * phosh_wl_buffer_new: (skip)
  * @format: The buffer format
@@ -61,6 +80,7 @@ phosh_wl_buffer_new (enum wl_shm_format format, uint32_t width, uint32_t height,
   buf->height = height;
   buf->stride = stride;
   buf->format = format;
+  buf->wl_format = format;
   buf->data = data;
 
   pool = wl_shm_create_pool (phosh_wayland_get_wl_shm (wl), fd, size);
@@ -85,6 +105,8 @@ phosh_wl_buffer_destroy (PhoshWlBuffer *self)
   if (self == NULL)
     return;
 
+  g_clear_pointer (&self->pool, phosh_wl_buffer_pool_unref);
+
   if (munmap (self->data, self->stride * self->height) < 0)
     g_warning ("Failed to unmap buffer %p: %s", self, g_strerror (errno));
 
@@ -117,3 +139,166 @@ phosh_wl_buffer_get_bytes (PhoshWlBuffer *self)
 {
   return g_bytes_new (self->data, phosh_wl_buffer_get_size (self));
 }
+
+/**
+ * phosh_wl_buffer_release:
+ * @self: The #PhoshWlBuffer
+ *
+ * Returns a buffer obtained via [method@WlBufferPool.acquire] to its
+ * pool for reuse. Buffers not belonging to a pool are destroyed.
+ */
+void
+phosh_wl_buffer_release (PhoshWlBuffer *self)
+{
+  PhoshWlBufferPool *pool;
+
+  if (self == NULL)
+    return;
+
+  pool = self->pool;
+  if (pool == NULL) {
+    phosh_wl_buffer_destroy (self);
+    return;
+  }
+
+  /* Users might have changed the format after swizzling the data */
+  self->format = self->wl_format;
+  /* Only buffers in use keep the pool alive */
+  self->pool = NULL;
+
+  g_queue_push_head (&pool->idle, self);
+  pool->idle_bytes += phosh_wl_buffer_get_size (self);
+
+  while (pool->idle_bytes > pool->max_bytes) {
+    PhoshWlBuffer *buf = g_queue_pop_tail (&pool->idle);
+
+    pool->idle_bytes -= phosh_wl_buffer_get_size (buf);
+    phosh_wl_buffer_destroy (buf);
+  }
+
+  phosh_wl_buffer_pool_unref (pool);
+}
+
+/**
+ * phosh_wl_buffer_pool_new: (skip)
+ * @max_bytes: The maximum amount of memory to keep in idle buffers
+ *
+ * Creates a new buffer pool.
+ *
+ * Returns: The new pool
+ */
+PhoshWlBufferPool *
+phosh_wl_buffer_pool_new (gsize max_bytes)
+{
+  PhoshWlBufferPool *self = g_rc_box_new0 (PhoshWlBufferPool);
+
+  g_queue_init (&self->idle);
+  self->max_bytes = max_bytes;
+
+  return self;
+}
+
+/**
+ * phosh_wl_buffer_pool_get_default: (skip)
+ *
+ * Gets the buffer pool shared by screenshots and thumbnails.
+ *
+ * Returns: (transfer none): The default pool
+ */
+PhoshWlBufferPool *
+phosh_wl_buffer_pool_get_default (void)
+{
+  static PhoshWlBufferPool *instance;
+
+  if (instance == NULL)
+    instance = phosh_wl_buffer_pool_new (DEFAULT_POOL_MAX_BYTES);
+
+  return instance;
+}
+
+
+PhoshWlBufferPool *
+phosh_wl_buffer_pool_ref (PhoshWlBufferPool *self)
+{
+  g_return_val_if_fail (self != NULL, NULL);
+
+  return g_rc_box_acquire (self);
+}
+
+
+static void
+pool_free (PhoshWlBufferPool *self)
+{
+  phosh_wl_buffer_pool_clear (self);
+}
+
+
+void
+phosh_wl_buffer_pool_unref (PhoshWlBufferPool *self)
+{
+  g_return_if_fail (self != NULL);
+
+  g_rc_box_release_full (self, (GDestroyNotify) pool_free);
+}
+
+/**
+ * phosh_wl_buffer_pool_acquire: (skip)
+ * @self: The buffer pool
+ * @format: The buffer format
+ * @width: The buffer's width in pixels
+ * @height: The buffer's height in lines
+ * @stride: The buffer's stride in bytes
+ *
+ * Gets a buffer with the given properties from the pool or creates a
+ * new one if there's no matching idle buffer. Use
+ * [method@WlBuffer.release] to hand it back to the pool.
+ *
+ * Returns: The buffer
+ */
+PhoshWlBuffer *
+phosh_wl_buffer_pool_acquire (PhoshWlBufferPool  *self,
+                              enum wl_shm_format  format,
+                              uint32_t            width,
+                              uint32_t            height,
+                              uint32_t            stride)
+{
+  PhoshWlBuffer *buf;
+
+  g_return_val_if_fail (self != NULL, NULL);
+
+  for (GList *l = self->idle.head; l; l = l->next) {
+    buf = l->data;
+
+    if (buf->wl_format == format && buf->width == width &&
+        buf->height == height && buf->stride == stride) {
+      g_queue_delete_link (&self->idle, l);
+      self->idle_bytes -= phosh_wl_buffer_get_size (buf);
+      buf->pool = phosh_wl_buffer_pool_ref (self);
+      return buf;
+    }
+  }
+
+  buf = phosh_wl_buffer_new (format, width, height, stride);
+  if (buf)
+    buf->pool = phosh_wl_buffer_pool_ref (self);
+
+  return buf;
+}
+
+/**
+ * phosh_wl_buffer_pool_clear: (skip)
+ * @self: The buffer pool
+ *
+ * Destroys all idle buffers.
+ */
+void
+phosh_wl_buffer_pool_clear (PhoshWlBufferPool *self)
+{
+  PhoshWlBuffer *buf;
+
+  g_return_if_fail (self != NULL);
+
+  while ((buf = g_queue_pop_head (&self->idle)))
+    phosh_wl_buffer_destroy (buf);
+  self->idle_bytes = 0;
+}
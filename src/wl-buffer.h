@@ -12,6 +12,8 @@
 
 G_BEGIN_DECLS
 
+typedef struct _PhoshWlBufferPool PhoshWlBufferPool;
+
 /**
  * PhoshWlBuffer:
  * @data: The actual data
@@ -29,11 +31,27 @@ typedef struct {
   enum wl_shm_format format;
   /*< private >*/
   struct wl_buffer  *wl_buffer;
+  enum wl_shm_format wl_format;
+  PhoshWlBufferPool *pool;
 } PhoshWlBuffer;
 
 PhoshWlBuffer *phosh_wl_buffer_new (enum wl_shm_format format, uint32_t width, uint32_t height, uint32_t stride);
 void           phosh_wl_buffer_destroy (PhoshWlBuffer *self);
+void           phosh_wl_buffer_release (PhoshWlBuffer *self);
 gsize          phosh_wl_buffer_get_size (PhoshWlBuffer *self);
 GBytes        *phosh_wl_buffer_get_bytes (PhoshWlBuffer *self);
 
+PhoshWlBufferPool *phosh_wl_buffer_pool_new (gsize max_bytes);
+PhoshWlBufferPool *phosh_wl_buffer_pool_get_default (void);
+PhoshWlBufferPool *phosh_wl_buffer_pool_ref (PhoshWlBufferPool *self);
+void               phosh_wl_buffer_pool_unref (PhoshWlBufferPool *self);
+PhoshWlBuffer     *phosh_wl_buffer_pool_acquire (PhoshWlBufferPool  *self,
+                                                 enum wl_shm_format  format,
+                                                 uint32_t            width,
+                                                 uint32_t            height,
+                                                 uint32_t            stride);
+void               phosh_wl_buffer_pool_clear (PhoshWlBufferPool *self);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (PhoshWlBufferPool, phosh_wl_buffer_pool_unref)
+
 G_END_DECLS
@@ -80,6 +80,164 @@ test_phosh_app_list_model_api (void)
 }
 
 
+static void
+test_phosh_app_list_model_matches (void)
+{
+  PhoshAppListModel *model = phosh_app_list_model_get_default ();
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr (GDesktopAppInfo) first = g_desktop_app_info_new ("demo.app.First.desktop");
+  g_autoptr (GDesktopAppInfo) second = g_desktop_app_info_new ("demo.app.Second.desktop");
+  g_autofree char *search = NULL;
+
+  g_assert_nonnull (first);
+  g_assert_nonnull (second);
+
+  /* Falls back to matching without the index */
+  search = phosh_app_list_model_normalize_search ("KGX");
+  g_assert_cmpstr (search, ==, "kgx");
+  g_assert_true (phosh_app_list_model_matches (model, G_APP_INFO (first), search));
+  g_assert_false (phosh_app_list_model_matches (model, G_APP_INFO (second), search));
+  /* Fallback agrees with the index */
+  g_clear_pointer (&search, g_free);
+  search = phosh_app_list_model_normalize_search ("kgxcommand");
+  g_assert_false (phosh_app_list_model_matches (model, G_APP_INFO (first), search));
+  g_clear_pointer (&search, g_free);
+  search = phosh_app_list_model_normalize_search ("KGX");
+
+  g_signal_connect_swapped (model, "items-changed", G_CALLBACK (g_main_loop_quit), loop);
+  g_main_loop_run (loop);
+
+  g_assert_true (phosh_app_list_model_matches (model, G_APP_INFO (first), search));
+  g_assert_false (phosh_app_list_model_matches (model, G_APP_INFO (second), search));
+
+  g_clear_pointer (&search, g_free);
+  search = phosh_app_list_model_normalize_search ("Edit");
+  g_assert_false (phosh_app_list_model_matches (model, G_APP_INFO (first), search));
+  g_assert_true (phosh_app_list_model_matches (model, G_APP_INFO (second), search));
+
+  /* Terms don't match across fields */
+  g_clear_pointer (&search, g_free);
+  search = phosh_app_list_model_normalize_search ("kgxcommand");
+  g_assert_false (phosh_app_list_model_matches (model, G_APP_INFO (first), search));
+
+  g_assert_finalize_object (model);
+}
+
+
+static void
+test_phosh_app_list_model_lookup_app_id (void)
+{
+  PhoshAppListModel *model = phosh_app_list_model_get_default ();
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr (GDesktopAppInfo) info = NULL;
+  guint hits, misses;
+
+  info = phosh_app_list_model_lookup_app_id (model, "demo.app.First");
+  g_assert_nonnull (info);
+  g_assert_cmpstr (g_app_info_get_id (G_APP_INFO (info)), ==, "demo.app.First.desktop");
+  g_clear_object (&info);
+
+  info = phosh_app_list_model_lookup_app_id (model, "demo.app.First");
+  g_assert_nonnull (info);
+  g_clear_object (&info);
+
+  g_assert_null (phosh_app_list_model_lookup_app_id (model, "first-app"));
+  g_assert_null (phosh_app_list_model_lookup_app_id (model, "first-app"));
+
+  phosh_app_list_model_get_app_id_cache_stats (model, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 2);
+
+  /* Only the most recent failed lookups are remembered */
+  for (int i = 0; i < 64; i++) {
+    g_autofree char *app_id = g_strdup_printf ("does-not-exist-%d", i);
+
+    g_assert_null (phosh_app_list_model_lookup_app_id (model, app_id));
+  }
+  g_assert_null (phosh_app_list_model_lookup_app_id (model, "first-app"));
+
+  phosh_app_list_model_get_app_id_cache_stats (model, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 67);
+
+  /* Rebuilding the model drops the cache so StartupWMClass is found now */
+  g_signal_connect_swapped (model, "items-changed", G_CALLBACK (g_main_loop_quit), loop);
+  g_main_loop_run (loop);
+
+  info = phosh_app_list_model_lookup_app_id (model, "first-app");
+  g_assert_nonnull (info);
+  g_assert_cmpstr (g_app_info_get_id (G_APP_INFO (info)), ==, "demo.app.First.desktop");
+
+  phosh_app_list_model_get_app_id_cache_stats (model, &hits, &misses);
+  g_assert_cmpuint (hits, ==, 2);
+  g_assert_cmpuint (misses, ==, 68);
+
+  g_assert_finalize_object (model);
+}
+
+
+typedef struct {
+  GMainLoop *loop;
+  guint      position;
+  guint      removed;
+  guint      added;
+} ItemsChangedRecord;
+
+
+static void
+on_items_changed_record (GListModel *model,
+                         guint       position,
+                         guint       removed,
+                         guint       added,
+                         gpointer    user_data)
+{
+  ItemsChangedRecord *record = user_data;
+
+  record->position = position;
+  record->removed = removed;
+  record->added = added;
+  g_main_loop_quit (record->loop);
+}
+
+
+static void
+test_phosh_app_list_model_diff (void)
+{
+  PhoshAppListModel *model = phosh_app_list_model_get_default ();
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  g_autoptr (GSettings) settings = g_settings_new ("org.gnome.desktop.app-folders");
+  const char *folders[] = { "phosh-test-diff", NULL };
+  ItemsChangedRecord record = { .loop = loop };
+  guint n_items;
+
+  g_signal_connect (model, "items-changed", G_CALLBACK (on_items_changed_record), &record);
+  g_main_loop_run (loop);
+
+  n_items = g_list_model_get_n_items (G_LIST_MODEL (model));
+  g_assert_cmpuint (record.position, ==, 0);
+  g_assert_cmpuint (record.removed, ==, 0);
+  g_assert_cmpuint (record.added, ==, n_items);
+
+  /* Only the new folder gets added */
+  g_settings_set_strv (settings, "folder-children", folders);
+  g_main_loop_run (loop);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, n_items + 1);
+  g_assert_cmpuint (record.position, ==, n_items);
+  g_assert_cmpuint (record.removed, ==, 0);
+  g_assert_cmpuint (record.added, ==, 1);
+
+  /* Only the folder gets removed */
+  g_settings_set_strv (settings, "folder-children", NULL);
+  g_main_loop_run (loop);
+  g_assert_cmpuint (g_list_model_get_n_items (G_LIST_MODEL (model)), ==, n_items);
+  g_assert_cmpuint (record.position, ==, n_items);
+  g_assert_cmpuint (record.removed, ==, 1);
+  g_assert_cmpuint (record.added, ==, 0);
+
+  g_assert_finalize_object (model);
+}
+
+
 int
 main (int argc, char *argv[])
 {
@@ -87,6 +245,9 @@ main (int argc, char *argv[])
 
   g_test_add_func("/phosh/app-list-model/new", test_phosh_app_list_model_get_default);
   g_test_add_func("/phosh/app-list-model/api", test_phosh_app_list_model_api);
+  g_test_add_func("/phosh/app-list-model/matches", test_phosh_app_list_model_matches);
+  g_test_add_func("/phosh/app-list-model/diff", test_phosh_app_list_model_diff);
+  g_test_add_func("/phosh/app-list-model/lookup-app-id", test_phosh_app_list_model_lookup_app_id);
 
   return g_test_run();
 }
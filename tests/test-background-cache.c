@@ -0,0 +1,220 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+
+#include "background-cache.h"
+
+#include <gdesktop-enums.h>
+
+#include <cairo.h>
+
+
+static PhoshBackgroundImage *
+load_image (GFile *file, int max_size)
+{
+  g_autoptr (PhoshBackgroundImage) image = NULL;
+  g_autoptr (GError) err = NULL;
+
+  image = phosh_background_image_new_sync (file, max_size, NULL, &err);
+  g_assert_no_error (err);
+  g_assert_true (PHOSH_IS_BACKGROUND_IMAGE (image));
+
+  return g_steal_pointer (&image);
+}
+
+
+static void
+on_load_scaled_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GAsyncResult **result = user_data;
+
+  *result = g_object_ref (res);
+}
+
+
+static cairo_surface_t *
+load_scaled (PhoshBackgroundCache *cache, GFile *file, int width, int height)
+{
+  g_autoptr (GAsyncResult) res = NULL;
+  g_autoptr (GError) err = NULL;
+  cairo_surface_t *surface;
+
+  phosh_background_cache_load_scaled_async (cache, file, width, height,
+                                            G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL,
+                                            NULL, on_load_scaled_ready, &res);
+  while (res == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  surface = phosh_background_cache_load_scaled_finish (cache, res, &err);
+  g_assert_no_error (err);
+
+  return surface;
+}
+
+
+static void
+on_scaled_stored (GMainLoop *loop, GFile *file, int width, int height)
+{
+  g_assert_true (G_IS_FILE (file));
+
+  /* Ignore images stored by other tests */
+  if (width == 48 && height == 24)
+    g_main_loop_quit (loop);
+}
+
+
+static void
+test_phosh_background_cache_scaled (void)
+{
+  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
+  g_autoptr (GFile) file = g_file_new_for_path (TEST_DATA_DIR "/cat.jpg");
+  g_autoptr (PhoshBackgroundImage) image = load_image (file, 0);
+  cairo_surface_t *surface1, *surface2, *surface3, *surface4;
+  GdkRGBA red = { 1.0, 0.0, 0.0, 1.0 }, blue = { 0.0, 0.0, 1.0, 1.0 };
+
+  surface1 = phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                G_DESKTOP_BACKGROUND_STYLE_ZOOM, &red);
+  g_assert_nonnull (surface1);
+  g_assert_cmpint (cairo_image_surface_get_width (surface1), ==, 32);
+  g_assert_cmpint (cairo_image_surface_get_height (surface1), ==, 64);
+
+  /* Same size, color doesn't matter for zoom */
+  surface2 = phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                G_DESKTOP_BACKGROUND_STYLE_ZOOM, &blue);
+  g_assert_true (surface1 == surface2);
+  cairo_surface_destroy (surface2);
+
+  /* Color matters when scaling */
+  surface3 = phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                G_DESKTOP_BACKGROUND_STYLE_SCALED, &red);
+  g_assert_true (surface3 != surface1);
+  surface4 = phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                G_DESKTOP_BACKGROUND_STYLE_SCALED, &blue);
+  g_assert_true (surface4 != surface3);
+  cairo_surface_destroy (surface3);
+  cairo_surface_destroy (surface4);
+
+  /* Different size */
+  surface4 = phosh_background_cache_get_scaled (cache, image, 64, 32,
+                                                G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL);
+  g_assert_true (surface4 != surface1);
+  g_assert_cmpint (cairo_image_surface_get_width (surface4), ==, 64);
+  g_assert_cmpint (cairo_image_surface_get_height (surface4), ==, 32);
+  cairo_surface_destroy (surface4);
+
+  /* No image needed */
+  g_assert_null (phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                    G_DESKTOP_BACKGROUND_STYLE_NONE, NULL));
+
+  /* Clearing the cache drops the scaled images from memory */
+  phosh_background_cache_clear_all (cache);
+  surface4 = phosh_background_cache_get_scaled (cache, image, 32, 64,
+                                                G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL);
+  g_assert_true (surface4 != surface1);
+  cairo_surface_destroy (surface4);
+
+  cairo_surface_destroy (surface1);
+}
+
+
+static void
+test_phosh_background_cache_disk (void)
+{
+  PhoshBackgroundCache *cache = phosh_background_cache_get_default ();
+  g_autoptr (GFile) file = g_file_new_for_path (TEST_DATA_DIR "/cat.jpg");
+  g_autoptr (PhoshBackgroundImage) image = load_image (file, 0);
+  g_autoptr (GMainLoop) loop = g_main_loop_new (NULL, FALSE);
+  cairo_surface_t *scaled, *mapped;
+  gulong handler_id;
+  gsize size;
+
+  phosh_background_cache_clear_all (cache);
+  g_assert_null (load_scaled (cache, file, 48, 24));
+
+  handler_id = g_signal_connect_swapped (cache, "scaled-stored",
+                                         G_CALLBACK (on_scaled_stored), loop);
+  scaled = phosh_background_cache_get_scaled (cache, image, 48, 24,
+                                              G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL);
+  g_assert_nonnull (scaled);
+
+  /* Storing happens in a thread so wait for it to complete */
+  g_main_loop_run (loop);
+  g_signal_handler_disconnect (cache, handler_id);
+
+  phosh_background_cache_clear_all (cache);
+  mapped = load_scaled (cache, file, 48, 24);
+  g_assert_nonnull (mapped);
+  g_assert_true (mapped != scaled);
+
+  g_assert_cmpint (cairo_image_surface_get_format (mapped), ==,
+                   cairo_image_surface_get_format (scaled));
+  g_assert_cmpint (cairo_image_surface_get_stride (mapped), ==,
+                   cairo_image_surface_get_stride (scaled));
+  size = cairo_image_surface_get_stride (scaled) * cairo_image_surface_get_height (scaled);
+  g_assert_cmpmem (cairo_image_surface_get_data (mapped), size,
+                   cairo_image_surface_get_data (scaled), size);
+
+  /* Now in memory */
+  cairo_surface_destroy (mapped);
+  mapped = phosh_background_cache_lookup_scaled (cache, file, 48, 24,
+                                                 G_DESKTOP_BACKGROUND_STYLE_ZOOM, NULL);
+  g_assert_nonnull (mapped);
+  cairo_surface_destroy (mapped);
+  cairo_surface_destroy (scaled);
+}
+
+
+static void
+test_phosh_background_image_max_size (void)
+{
+  g_autoptr (GFile) file = g_file_new_for_path (TEST_DATA_DIR "/cat.jpg");
+  g_autoptr (PhoshBackgroundImage) image = NULL;
+  GdkPixbuf *pixbuf;
+
+  image = load_image (file, 0);
+  pixbuf = phosh_background_image_get_pixbuf (image);
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, 512);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, 512);
+  g_clear_object (&image);
+
+  image = load_image (file, 100);
+  pixbuf = phosh_background_image_get_pixbuf (image);
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, 100);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, 100);
+  g_clear_object (&image);
+
+  /* Never upscale */
+  image = load_image (file, 1024);
+  pixbuf = phosh_background_image_get_pixbuf (image);
+  g_assert_cmpint (gdk_pixbuf_get_width (pixbuf), ==, 512);
+  g_assert_cmpint (gdk_pixbuf_get_height (pixbuf), ==, 512);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autofree char *cache_dir = g_dir_make_tmp ("phosh-background-cache-XXXXXX", NULL);
+  g_autoptr (GFile) dir = NULL;
+  int ret;
+
+  g_assert_nonnull (cache_dir);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/background-cache/scaled", test_phosh_background_cache_scaled);
+  g_test_add_func ("/phosh/background-cache/disk", test_phosh_background_cache_disk);
+  g_test_add_func ("/phosh/background-image/max-size", test_phosh_background_image_max_size);
+
+  ret = g_test_run ();
+
+  dir = g_file_new_for_path (cache_dir);
+  phosh_test_remove_tree (dir);
+
+  return ret;
+}
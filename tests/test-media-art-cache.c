@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "testlib.h"
+
+#include "media-art-cache.h"
+
+#define ART_URL "https://example.com/art.jpg"
+
+
+static GdkPixbuf *
+load_art (void)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) err = NULL;
+
+  pixbuf = gdk_pixbuf_new_from_file_at_size (TEST_DATA_DIR "/cat.jpg", 64, 32, &err);
+  g_assert_no_error (err);
+  g_assert_true (GDK_IS_PIXBUF (pixbuf));
+
+  return g_steal_pointer (&pixbuf);
+}
+
+
+static void
+on_async_ready (GObject *source_object, GAsyncResult *res, gpointer user_data)
+{
+  GAsyncResult **result = user_data;
+
+  *result = g_object_ref (res);
+}
+
+
+static GdkPixbuf *
+lookup (PhoshMediaArtCache *cache, const char *url, int size)
+{
+  g_autoptr (GAsyncResult) res = NULL;
+  g_autoptr (GError) err = NULL;
+  GdkPixbuf *pixbuf;
+
+  phosh_media_art_cache_lookup_async (cache, url, size, NULL, on_async_ready, &res);
+  while (res == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  pixbuf = phosh_media_art_cache_lookup_finish (cache, res, &err);
+  g_assert_no_error (err);
+
+  return pixbuf;
+}
+
+
+/* Storing happens in a thread so wait until it completed */
+static GdkPixbuf *
+add (PhoshMediaArtCache *cache, const char *url, int size, GdkPixbuf *pixbuf)
+{
+  g_autoptr (GAsyncResult) res = NULL;
+  g_autoptr (GError) err = NULL;
+  GdkPixbuf *art;
+  gboolean success;
+
+  art = phosh_media_art_cache_add (cache, url, size, pixbuf, NULL, on_async_ready, &res);
+  g_assert_true (GDK_IS_PIXBUF (art));
+  while (res == NULL)
+    g_main_context_iteration (NULL, TRUE);
+
+  success = phosh_media_art_cache_add_finish (cache, res, &err);
+  g_assert_no_error (err);
+  g_assert_true (success);
+
+  return art;
+}
+
+
+static void
+test_phosh_media_art_cache_memory (void)
+{
+  PhoshMediaArtCache *cache = phosh_media_art_cache_get_default ();
+  g_autoptr (GdkPixbuf) pixbuf = load_art ();
+  g_autoptr (GdkPixbuf) art = NULL;
+  g_autoptr (GdkPixbuf) hit = NULL;
+  g_autoptr (GdkPixbuf) miss = NULL;
+  const char *data_url = "data:image/png;base64,AAAA";
+  const char *other_url = "data:image/png;base64,BBBB";
+
+  miss = lookup (cache, data_url, 48);
+  g_assert_null (miss);
+  miss = phosh_media_art_cache_lookup (cache, data_url, 48);
+  g_assert_null (miss);
+
+  art = add (cache, data_url, 48, pixbuf);
+  g_assert_cmpint (gdk_pixbuf_get_width (art), ==, 48);
+  g_assert_cmpint (gdk_pixbuf_get_height (art), ==, 48);
+
+  hit = lookup (cache, data_url, 48);
+  g_assert_true (hit == art);
+  g_clear_object (&hit);
+  /* No I/O needed so it's found right away too */
+  hit = phosh_media_art_cache_lookup (cache, data_url, 48);
+  g_assert_true (hit == art);
+
+  /* Different size or contents */
+  miss = lookup (cache, data_url, 96);
+  g_assert_null (miss);
+  miss = lookup (cache, other_url, 48);
+  g_assert_null (miss);
+
+  /* Unknown schemes aren't cached but still processed */
+  g_clear_object (&art);
+  art = add (cache, "foo://bar", 24, pixbuf);
+  g_assert_cmpint (gdk_pixbuf_get_width (art), ==, 24);
+  miss = lookup (cache, "foo://bar", 24);
+  g_assert_null (miss);
+
+  /* data: URLs are only kept in memory */
+  phosh_media_art_cache_clear (cache);
+  miss = lookup (cache, data_url, 48);
+  g_assert_null (miss);
+  miss = phosh_media_art_cache_lookup (cache, data_url, 48);
+  g_assert_null (miss);
+}
+
+
+static void
+test_phosh_media_art_cache_disk (void)
+{
+  PhoshMediaArtCache *cache = phosh_media_art_cache_get_default ();
+  g_autoptr (GdkPixbuf) pixbuf = load_art ();
+  g_autoptr (GdkPixbuf) art = NULL;
+  g_autoptr (GdkPixbuf) miss = NULL;
+  g_autoptr (GdkPixbuf) loaded = NULL;
+  g_autoptr (GdkPixbuf) hit = NULL;
+
+  phosh_media_art_cache_clear (cache);
+  miss = lookup (cache, ART_URL, 48);
+  g_assert_null (miss);
+
+  art = add (cache, ART_URL, 48, pixbuf);
+
+  /* Drop it from memory so it's loaded from disk */
+  phosh_media_art_cache_clear (cache);
+  miss = phosh_media_art_cache_lookup (cache, ART_URL, 48);
+  g_assert_null (miss);
+
+  loaded = lookup (cache, ART_URL, 48);
+  g_assert_nonnull (loaded);
+  g_assert_true (loaded != art);
+
+  g_assert_cmpint (gdk_pixbuf_get_width (loaded), ==, 48);
+  g_assert_cmpint (gdk_pixbuf_get_height (loaded), ==, 48);
+  g_assert_true (gdk_pixbuf_get_has_alpha (loaded));
+
+  /* Loading from disk put it back into memory */
+  hit = phosh_media_art_cache_lookup (cache, ART_URL, 48);
+  g_assert_true (hit == loaded);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_autofree char *cache_dir = g_dir_make_tmp ("phosh-media-art-cache-XXXXXX", NULL);
+  g_autoptr (GFile) dir = NULL;
+  int ret;
+
+  g_assert_nonnull (cache_dir);
+  g_setenv ("XDG_CACHE_HOME", cache_dir, TRUE);
+
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/media-art-cache/memory", test_phosh_media_art_cache_memory);
+  g_test_add_func ("/phosh/media-art-cache/disk", test_phosh_media_art_cache_disk);
+
+  ret = g_test_run ();
+
+  dir = g_file_new_for_path (cache_dir);
+  phosh_test_remove_tree (dir);
+
+  return ret;
+}
@@ -294,6 +294,107 @@ test_phosh_notification_list_seek (void)
 }
 
 
+static PhoshNotification *
+new_notification (guint id, GIcon *image)
+{
+  g_autoptr (GDateTime) now = g_date_time_new_now_local ();
+
+  return phosh_notification_new (id,
+                                 NULL,
+                                 NULL,
+                                 "Hey",
+                                 "Testing",
+                                 NULL,
+                                 image,
+                                 PHOSH_NOTIFICATION_URGENCY_NORMAL,
+                                 NULL,
+                                 FALSE,
+                                 FALSE,
+                                 NULL,
+                                 NULL,
+                                 now);
+}
+
+
+static void
+test_phosh_notification_list_limits (void)
+{
+  g_autoptr (PhoshNotificationList) list = phosh_notification_list_new ();
+  g_autoptr (PhoshNotificationSource) source = NULL;
+  PhoshNotification *notis[5];
+
+  phosh_notification_list_set_max_per_source (list, 2);
+  phosh_notification_list_set_max_total (list, 3);
+
+  for (int i = 0; i < 3; i++) {
+    notis[i] = new_notification (i + 1, NULL);
+    phosh_notification_list_add (list, "org.gnome.zbrown.KingsCross", notis[i]);
+  }
+
+  /* Oldest one of the source got evicted */
+  g_assert_null (phosh_notification_list_get_by_id (list, 1));
+  g_assert_true (phosh_notification_list_get_by_id (list, 2) == notis[1]);
+  g_assert_true (phosh_notification_list_get_by_id (list, 3) == notis[2]);
+  source = g_list_model_get_item (G_LIST_MODEL (list), 0);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (source)), ==, 2);
+
+  for (int i = 3; i < 5; i++) {
+    notis[i] = new_notification (i + 1, NULL);
+    phosh_notification_list_add (list, "org.gnome.design.Palette", notis[i]);
+  }
+
+  /* Oldest one overall got evicted */
+  g_assert_null (phosh_notification_list_get_by_id (list, 2));
+  g_assert_true (phosh_notification_list_get_by_id (list, 3) == notis[2]);
+  g_assert_true (phosh_notification_list_get_by_id (list, 5) == notis[4]);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 2);
+
+  /* Lowering the limit evicts right away */
+  phosh_notification_list_set_max_total (list, 1);
+  g_assert_null (phosh_notification_list_get_by_id (list, 3));
+  g_assert_null (phosh_notification_list_get_by_id (list, 4));
+  g_assert_true (phosh_notification_list_get_by_id (list, 5) == notis[4]);
+  g_assert_cmpint (g_list_model_get_n_items (G_LIST_MODEL (list)), ==, 1);
+
+  for (int i = 0; i < G_N_ELEMENTS (notis); i++)
+    g_object_unref (notis[i]);
+}
+
+
+static void
+test_phosh_notification_list_image_bytes (void)
+{
+  g_autoptr (PhoshNotificationList) list = phosh_notification_list_new ();
+  g_autoptr (GdkPixbuf) image = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 32, 32);
+  g_autoptr (GdkPixbuf) other = gdk_pixbuf_new (GDK_COLORSPACE_RGB, TRUE, 8, 32, 32);
+  gsize size = gdk_pixbuf_get_byte_length (image);
+  g_autoptr (PhoshNotification) noti1 = new_notification (1, G_ICON (image));
+  g_autoptr (PhoshNotification) noti2 = new_notification (2, G_ICON (image));
+  g_autoptr (PhoshNotification) noti3 = new_notification (3, G_ICON (other));
+
+  phosh_notification_list_add (list, "org.gnome.zbrown.KingsCross", noti1);
+  phosh_notification_list_add (list, "org.gnome.zbrown.KingsCross", noti2);
+
+  /* Shared images are accounted once */
+  g_assert_cmpuint (phosh_notification_list_get_image_bytes (list), ==, size);
+
+  phosh_notification_close (noti1, PHOSH_NOTIFICATION_REASON_DISMISSED);
+  g_assert_cmpuint (phosh_notification_list_get_image_bytes (list), ==, size);
+
+  phosh_notification_set_image (noti2, NULL);
+  g_assert_cmpuint (phosh_notification_list_get_image_bytes (list), ==, 0);
+
+  phosh_notification_set_image (noti2, G_ICON (image));
+  phosh_notification_list_set_max_image_bytes (list, size);
+
+  /* Going over the limit evicts the oldest notification */
+  phosh_notification_list_add (list, "org.gnome.design.Palette", noti3);
+  g_assert_null (phosh_notification_list_get_by_id (list, 2));
+  g_assert_true (phosh_notification_list_get_by_id (list, 3) == noti3);
+  g_assert_cmpuint (phosh_notification_list_get_image_bytes (list), ==, size);
+}
+
+
 int
 main (int argc, char **argv)
 {
@@ -304,6 +405,8 @@ main (int argc, char **argv)
   g_test_add_func ("/phosh/notification-list/latest-on-top", test_phosh_notification_list_latest_on_top);
   g_test_add_func ("/phosh/notification-list/source-empty", test_phosh_notification_list_source_empty);
   g_test_add_func ("/phosh/notification-list/seek", test_phosh_notification_list_seek);
+  g_test_add_func ("/phosh/notification-list/limits", test_phosh_notification_list_limits);
+  g_test_add_func ("/phosh/notification-list/image-bytes", test_phosh_notification_list_image_bytes);
 
   return g_test_run ();
 }
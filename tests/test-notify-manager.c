@@ -149,6 +149,81 @@ test_phosh_notify_manager_server_notify (PhoshTestFullShellFixture *fixture, gco
 }
 
 
+static guint
+send_notification (PhoshDBusNotifications *proxy, const char *app_name, guchar urgency)
+{
+  g_autoptr (GError) err = NULL;
+  g_auto (GVariantBuilder) builder = G_VARIANT_BUILDER_INIT (G_VARIANT_TYPE_VARDICT);
+  const char *const * actions = (const char*[]){ NULL };
+  gboolean success;
+  guint id = 0;
+
+  g_variant_builder_add (&builder, "{sv}", "urgency", g_variant_new_byte (urgency));
+  success = phosh_dbus_notifications_call_notify_sync (proxy,
+                                                       app_name,
+                                                       0,
+                                                       "",
+                                                       "summary",
+                                                       "body",
+                                                       actions,
+                                                       g_variant_builder_end (&builder),
+                                                       -1,
+                                                       &id,
+                                                       NULL,
+                                                       &err);
+  g_assert_no_error (err);
+  g_assert_true (success);
+  g_assert_cmpuint (id, >, 0);
+
+  return id;
+}
+
+
+static void
+test_phosh_notify_manager_coalesce (PhoshTestFullShellFixture *fixture, gconstpointer unused)
+{
+  g_autoptr (GError) err = NULL;
+  g_autoptr (PhoshDBusNotifications) proxy = NULL;
+  guint id, last_id = 0;
+
+  /* Wait until comp/shell are up */
+  g_assert_nonnull (g_async_queue_timeout_pop (fixture->queue, POP_TIMEOUT));
+
+  proxy = phosh_dbus_notifications_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
+                                                           G_DBUS_PROXY_FLAGS_NONE,
+                                                           BUS_NAME,
+                                                           OBJECT_PATH,
+                                                           NULL,
+                                                           &err);
+  g_assert_no_error (err);
+  g_assert_true (PHOSH_DBUS_IS_NOTIFICATIONS_PROXY (proxy));
+
+  /* A short burst gets separate notifications */
+  for (int i = 0; i < 5; i++) {
+    id = send_notification (proxy, "com.example.burst", PHOSH_NOTIFICATION_URGENCY_NORMAL);
+    g_assert_cmpuint (id, !=, last_id);
+    last_id = id;
+  }
+
+  /* Longer bursts get coalesced into the last notification */
+  id = send_notification (proxy, "com.example.burst", PHOSH_NOTIFICATION_URGENCY_NORMAL);
+  g_assert_cmpuint (id, ==, last_id);
+  id = send_notification (proxy, "com.example.burst", PHOSH_NOTIFICATION_URGENCY_LOW);
+  g_assert_cmpuint (id, ==, last_id);
+
+  /* Critical notifications are never coalesced ... */
+  id = send_notification (proxy, "com.example.burst", PHOSH_NOTIFICATION_URGENCY_CRITICAL);
+  g_assert_cmpuint (id, !=, last_id);
+  /* ... and never replaced by a coalesced one */
+  g_assert_cmpuint (send_notification (proxy, "com.example.burst",
+                                       PHOSH_NOTIFICATION_URGENCY_NORMAL), ==, last_id);
+
+  /* Another source from the same sender isn't coalesced */
+  id = send_notification (proxy, "com.example.other", PHOSH_NOTIFICATION_URGENCY_NORMAL);
+  g_assert_cmpuint (id, !=, last_id);
+}
+
+
 int
 main (int argc, char *argv[])
 {
@@ -167,6 +242,9 @@ main (int argc, char *argv[])
   PHOSH_FULL_SHELL_TEST_ADD ("/phosh/dbus/notify-manager/notify",
                              cfg,
                              test_phosh_notify_manager_server_notify);
+  PHOSH_FULL_SHELL_TEST_ADD ("/phosh/dbus/notify-manager/coalesce",
+                             cfg,
+                             test_phosh_notify_manager_coalesce);
 
   return g_test_run ();
 }
@@ -0,0 +1,182 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ */
+
+#include "pixel-convert.h"
+
+#define PERF_WIDTH  3840
+#define PERF_HEIGHT 2160
+#define PERF_RUNS   10
+
+static const PhoshPixelConvertImpl impls[] = {
+  PHOSH_PIXEL_CONVERT_IMPL_SCALAR,
+  PHOSH_PIXEL_CONVERT_IMPL_SSE2,
+  PHOSH_PIXEL_CONVERT_IMPL_AVX2,
+  PHOSH_PIXEL_CONVERT_IMPL_NEON,
+};
+
+
+static guint32
+reference_pixel (guint32 px, PhoshPixelConvertFlags flags)
+{
+  if (flags & PHOSH_PIXEL_CONVERT_SWAP_RB)
+    px = (px & 0xFF00FF00) | ((px >> 16) & 0xFF) | ((px & 0xFF) << 16);
+
+  if (flags & PHOSH_PIXEL_CONVERT_OPAQUE) {
+    px |= 0xFF000000;
+  } else if (flags & PHOSH_PIXEL_CONVERT_PREMULTIPLY) {
+    guint32 a = px >> 24;
+    guint32 out = a << 24;
+
+    for (int shift = 0; shift < 24; shift += 8)
+      out |= ((((px >> shift) & 0xFF) * a + 127) / 255) << shift;
+    px = out;
+  }
+
+  return px;
+}
+
+
+static void
+test_phosh_pixel_convert_row (void)
+{
+  PhoshPixelConvertImpl best = phosh_pixel_convert_get_impl ();
+  /* Not a multiple of any vector width to exercise the tails */
+  guint32 src[37], dest[37];
+  g_autoptr (GRand) rand = g_rand_new_with_seed (42);
+
+  for (int i = 0; i < G_N_ELEMENTS (impls); i++) {
+    if (!phosh_pixel_convert_set_impl (impls[i])) {
+      g_test_message ("Skipping unsupported %s", phosh_pixel_convert_impl_to_string (impls[i]));
+      continue;
+    }
+
+    for (PhoshPixelConvertFlags flags = 0; flags < PHOSH_PIXEL_CONVERT_FLIP_Y; flags++) {
+      for (int run = 0; run < 100; run++) {
+        for (int j = 0; j < G_N_ELEMENTS (src); j++)
+          src[j] = g_rand_int (rand);
+
+        phosh_pixel_convert_row (dest, src, G_N_ELEMENTS (src), flags);
+        for (int j = 0; j < G_N_ELEMENTS (src); j++)
+          g_assert_cmphex (dest[j], ==, reference_pixel (src[j], flags));
+
+        /* In place */
+        phosh_pixel_convert_row (src, src, G_N_ELEMENTS (src), flags);
+        g_assert_cmpmem (src, sizeof (src), dest, sizeof (dest));
+      }
+    }
+  }
+
+  g_assert_true (phosh_pixel_convert_set_impl (best));
+}
+
+
+static void
+test_phosh_pixel_convert_rotate (void)
+{
+  /* 3x2 image, each pixel encodes its position as 10 * y + x */
+  const guint32 src[] = { 0, 1, 2, 10, 11, 12 };
+  const guint32 rotated_0_flipped[] = { 10, 11, 12, 0, 1, 2 };
+  const guint32 rotated_90[] = { 2, 12, 1, 11, 0, 10 };
+  const guint32 rotated_180[] = { 12, 11, 10, 2, 1, 0 };
+  const guint32 rotated_270[] = { 10, 0, 11, 1, 12, 2 };
+  const guint32 rotated_270_flipped[] = { 0, 10, 1, 11, 2, 12 };
+  guint32 dest[6], in_place[6];
+
+  phosh_pixel_convert ((guint8 *)dest, 3 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_0, PHOSH_PIXEL_CONVERT_NONE);
+  g_assert_cmpmem (dest, sizeof (dest), src, sizeof (src));
+
+  phosh_pixel_convert ((guint8 *)dest, 3 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_0, PHOSH_PIXEL_CONVERT_FLIP_Y);
+  g_assert_cmpmem (dest, sizeof (dest), rotated_0_flipped, sizeof (rotated_0_flipped));
+
+  phosh_pixel_convert ((guint8 *)dest, 2 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_90, PHOSH_PIXEL_CONVERT_NONE);
+  g_assert_cmpmem (dest, sizeof (dest), rotated_90, sizeof (rotated_90));
+
+  phosh_pixel_convert ((guint8 *)dest, 3 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_180, PHOSH_PIXEL_CONVERT_NONE);
+  g_assert_cmpmem (dest, sizeof (dest), rotated_180, sizeof (rotated_180));
+
+  phosh_pixel_convert ((guint8 *)dest, 2 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_270, PHOSH_PIXEL_CONVERT_NONE);
+  g_assert_cmpmem (dest, sizeof (dest), rotated_270, sizeof (rotated_270));
+
+  phosh_pixel_convert ((guint8 *)dest, 2 * 4, (const guint8 *)src, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_270, PHOSH_PIXEL_CONVERT_FLIP_Y);
+  g_assert_cmpmem (dest, sizeof (dest), rotated_270_flipped, sizeof (rotated_270_flipped));
+
+  memcpy (in_place, src, sizeof (src));
+  phosh_pixel_convert ((guint8 *)in_place, 3 * 4, (const guint8 *)in_place, 3 * 4, 3, 2,
+                       PHOSH_PIXEL_ROTATE_0, PHOSH_PIXEL_CONVERT_FLIP_Y);
+  g_assert_cmpmem (in_place, sizeof (in_place), rotated_0_flipped, sizeof (rotated_0_flipped));
+}
+
+
+static void
+test_phosh_pixel_convert_perf (void)
+{
+  PhoshPixelConvertImpl best = phosh_pixel_convert_get_impl ();
+  gsize size = PERF_WIDTH * PERF_HEIGHT * sizeof (guint32);
+  g_autofree guint8 *src = g_malloc (size);
+  g_autofree guint8 *dest = g_malloc (size);
+  PhoshPixelConvertFlags flags = PHOSH_PIXEL_CONVERT_SWAP_RB | PHOSH_PIXEL_CONVERT_OPAQUE;
+  double scalar_elapsed = 0.0, best_elapsed = 0.0;
+
+  memset (src, 0x7f, size);
+
+  for (int i = 0; i < G_N_ELEMENTS (impls); i++) {
+    if (!phosh_pixel_convert_set_impl (impls[i]))
+      continue;
+
+    for (PhoshPixelRotation rotation = PHOSH_PIXEL_ROTATE_0;
+         rotation <= PHOSH_PIXEL_ROTATE_270;
+         rotation += 90) {
+      int dest_stride = (rotation % 180 ? PERF_HEIGHT : PERF_WIDTH) * sizeof (guint32);
+      double elapsed;
+
+      g_test_timer_start ();
+      for (int run = 0; run < PERF_RUNS; run++) {
+        phosh_pixel_convert (dest, dest_stride, src, PERF_WIDTH * sizeof (guint32),
+                             PERF_WIDTH, PERF_HEIGHT, rotation, flags);
+      }
+      elapsed = g_test_timer_elapsed () / PERF_RUNS;
+
+      g_test_maximized_result ((double)PERF_WIDTH * PERF_HEIGHT / elapsed / 1e6,
+                               "%s, rotated by %d: %.2f ms per 4K frame (MPixel/s)",
+                               phosh_pixel_convert_impl_to_string (impls[i]),
+                               rotation,
+                               elapsed * 1000);
+
+      if (rotation != PHOSH_PIXEL_ROTATE_0)
+        continue;
+
+      if (impls[i] == PHOSH_PIXEL_CONVERT_IMPL_SCALAR)
+        scalar_elapsed = elapsed;
+      if (impls[i] == best)
+        best_elapsed = elapsed;
+    }
+  }
+
+  g_assert_true (phosh_pixel_convert_set_impl (best));
+
+  /* The default implementation must not regress below plain C */
+  g_assert_cmpfloat (best_elapsed, <=, scalar_elapsed * 1.25);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/phosh/pixel-convert/row", test_phosh_pixel_convert_row);
+  g_test_add_func ("/phosh/pixel-convert/rotate", test_phosh_pixel_convert_rotate);
+  if (g_test_perf ())
+    g_test_add_func ("/phosh/pixel-convert/perf", test_phosh_pixel_convert_perf);
+
+  return g_test_run ();
+}
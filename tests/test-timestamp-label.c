@@ -164,6 +164,46 @@ test_phosh_time_diff_in_words (void)
 }
 
 
+static void
+test_phosh_time_diff_next_update (void)
+{
+  gint64 dt = 1609455600 * G_TIME_SPAN_SECOND;
+  guint granularity;
+  gint64 next;
+
+  next = phosh_time_diff_next_update (dt, dt, &granularity);
+  g_assert_cmpint (next, ==, dt + 15 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 1);
+
+  next = phosh_time_diff_next_update (dt, dt + 31 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 60 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 1);
+
+  next = phosh_time_diff_next_update (dt, dt + 90 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 120 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 1);
+
+  /* 30m, next change at 31m */
+  next = phosh_time_diff_next_update (dt, dt + 30 * 60 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 31 * 60 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 60);
+
+  /* ~1h, next change at 90m */
+  next = phosh_time_diff_next_update (dt, dt + 50 * 60 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 90 * 60 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 60);
+
+  /* ~2h, next change at 3h */
+  next = phosh_time_diff_next_update (dt, dt + 2 * 3600 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 3 * 3600 * G_TIME_SPAN_SECOND);
+
+  /* 2d, next change at 3d */
+  next = phosh_time_diff_next_update (dt, dt + 2 * 86400 * G_TIME_SPAN_SECOND, &granularity);
+  g_assert_cmpint (next, ==, dt + 3 * 86400 * G_TIME_SPAN_SECOND);
+  g_assert_cmpuint (granularity, ==, 60);
+}
+
+
 int
 main (int   argc,
       char *argv[])
@@ -175,5 +215,6 @@ main (int   argc,
 
   g_test_add_func ("/phosh/timestamp-label/test_phosh_timestamp_label_destroy", test_phosh_timestamp_label_destroy);
   g_test_add_func ("/phosh/timestamp-label/test_phosh_time_diff_in_words", test_phosh_time_diff_in_words);
+  g_test_add_func ("/phosh/timestamp-label/test_phosh_time_diff_next_update", test_phosh_time_diff_next_update);
   return g_test_run ();
 }
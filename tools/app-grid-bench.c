@@ -0,0 +1,145 @@
+/*
+ * Copyright (C) 2025 The Phosh Developers
+ *
+ * SPDX-License-Identifier: GPL-3.0-or-later
+ *
+ * BUILDDIR $ ./run_tool ./tools/app-grid-bench [N_APPS]
+ *
+ * Measure how long it takes to populate a PhoshAppGrid from a
+ * directory of synthetic apps. Only the synthetic apps are visible
+ * to keep the numbers comparable between systems.
+ *
+ * The app grid caches the apps' sort keys on first use so the first
+ * run is reported separately from the (warm) later ones.
+ */
+
+#include <app-grid.h>
+#include <app-list-model.h>
+
+#include <glib/gstdio.h>
+
+#define DEFAULT_N_APPS 1000
+#define RUNS           10
+
+static const char *prefixes[] = { "Ärger", "arcade", "Browser", "éditeur", "Zebra", "mail", "Öffi" };
+
+
+static char *
+get_desktop_file (const char *datadir, guint i)
+{
+  g_autofree char *basename = g_strdup_printf ("mobi.phosh.Bench%05u.desktop", i);
+
+  return g_build_filename (datadir, "applications", basename, NULL);
+}
+
+
+static char *
+create_apps (guint n_apps)
+{
+  g_autoptr (GError) err = NULL;
+  g_autoptr (GRand) rand = g_rand_new_with_seed (42);
+  g_autofree char *datadir = NULL;
+  g_autofree char *appdir = NULL;
+
+  datadir = g_dir_make_tmp ("phosh-app-grid-bench-XXXXXX", &err);
+  if (datadir == NULL)
+    g_error ("Failed to create data dir: %s", err->message);
+
+  appdir = g_build_filename (datadir, "applications", NULL);
+  if (g_mkdir (appdir, 0755) != 0)
+    g_error ("Failed to create %s", appdir);
+
+  for (guint i = 0; i < n_apps; i++) {
+    g_autofree char *filename = get_desktop_file (datadir, i);
+    g_autofree char *contents = NULL;
+
+    /* Random names so the sort model has to do some work */
+    contents = g_strdup_printf ("[Desktop Entry]\n"
+                                "Type=Application\n"
+                                "Name=%s %08x\n"
+                                "Exec=true\n"
+                                "Icon=application-x-executable\n"
+                                "Keywords=bench;synthetic;\n",
+                                prefixes[g_rand_int_range (rand, 0, G_N_ELEMENTS (prefixes))],
+                                g_rand_int (rand));
+
+    if (!g_file_set_contents (filename, contents, -1, &err))
+      g_error ("Failed to write %s: %s", filename, err->message);
+  }
+
+  return g_steal_pointer (&datadir);
+}
+
+
+static void
+remove_apps (const char *datadir, guint n_apps)
+{
+  g_autofree char *appdir = g_build_filename (datadir, "applications", NULL);
+
+  for (guint i = 0; i < n_apps; i++) {
+    g_autofree char *filename = get_desktop_file (datadir, i);
+
+    g_remove (filename);
+  }
+
+  g_rmdir (appdir);
+  g_rmdir (datadir);
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  PhoshAppListModel *model;
+  g_autoptr (GMainLoop) loop = NULL;
+  g_autoptr (GTimer) timer = NULL;
+  g_autofree char *datadir = NULL;
+  guint n_apps = DEFAULT_N_APPS;
+  double cold = 0.0, min = G_MAXDOUBLE, total = 0.0;
+
+  if (argc > 1)
+    n_apps = g_ascii_strtoull (argv[1], NULL, 10);
+
+  /* Needs to happen before anything looks at desktop files */
+  datadir = create_apps (n_apps);
+  g_setenv ("XDG_DATA_HOME", datadir, TRUE);
+  g_setenv ("XDG_DATA_DIRS", datadir, TRUE);
+
+  gtk_init (&argc, &argv);
+
+  model = phosh_app_list_model_get_default ();
+  loop = g_main_loop_new (NULL, FALSE);
+  g_signal_connect_swapped (model, "items-changed", G_CALLBACK (g_main_loop_quit), loop);
+  g_main_loop_run (loop);
+  g_signal_handlers_disconnect_by_data (model, loop);
+
+  g_print ("Populating app grid with %u apps, %d runs\n",
+           g_list_model_get_n_items (G_LIST_MODEL (model)), RUNS);
+
+  timer = g_timer_new ();
+  for (int run = 0; run < RUNS; run++) {
+    GtkWidget *grid;
+    double elapsed;
+
+    g_timer_start (timer);
+    grid = g_object_ref_sink (phosh_app_grid_new ());
+    elapsed = g_timer_elapsed (timer, NULL);
+
+    if (run == 0) {
+      cold = elapsed;
+    } else {
+      min = MIN (min, elapsed);
+      total += elapsed;
+    }
+
+    gtk_widget_destroy (grid);
+    g_object_unref (grid);
+  }
+
+  g_print ("cold: %.2f ms\n", cold * 1000);
+  g_print ("warm min: %.2f ms, avg: %.2f ms\n", min * 1000, total / (RUNS - 1) * 1000);
+
+  remove_apps (datadir, n_apps);
+
+  return 0;
+}